@@ -29,12 +29,14 @@
 #include <SoftwareSerial.h>
 
 #include "SIM808Driver.h"
+#include "SIM808BringUp.h"
 
 #define SIM808_RX_PIN 5
 #define SIM808_TX_PIN 4
 #define SIM808_RST_PIN -1
 
 SIM808Driver *sim808;
+SIM808BringUp *bringUp;
 SIM808Driver::GnssInfo gnssInfo;
 
 void setup()
@@ -55,6 +57,11 @@ void setup()
   // Equivalent line with the debug enabled on the Serial
   sim808 = new SIM808Driver((Stream *)serial, SIM808_RST_PIN, 200, 512, (Stream *)&Serial);
 
+  // Bring-up without network, the GNSS is powered on as soon as the module answers
+  bringUp = new SIM808BringUp(sim808);
+  bringUp->setNetwork(false);
+  bringUp->setGNSS(true);
+
   // Setup module for GPRS communication
   setupModule();
 }
@@ -93,13 +100,19 @@ void loop()
 
 void setupModule()
 {
-  // Wait until the module is ready to accept AT commands
-  while (!sim808->isReady())
+  // Bring-up driven by the URCs of the module (RDY, Call Ready, +CREG) instead of fixed delays
+  bringUp->start();
+  while (bringUp->process() != SIM808BringUp::BRINGUP_DONE)
   {
-    Serial.println(F("Problem to initialize AT command, retry in 1 sec"));
-    delay(1000);
+    if (bringUp->getStep() == SIM808BringUp::BRINGUP_FAILED)
+    {
+      Serial.print(F("Bring-up failed at step "));
+      Serial.println(bringUp->getFailedStep());
+      sim808->reset();
+      bringUp->start();
+    }
   }
-  Serial.println(F("Setup Complete!"));
-
-  sim808->powerOnGNSS();
+  Serial.print(F("Module ready in "));
+  Serial.print(bringUp->getTimeToReady());
+  Serial.println(F(" ms"));
 }
@@ -29,15 +29,19 @@
 #include <SoftwareSerial.h>
 
 #include "SIM808Driver.h"
+#include "SIM808BringUp.h"
 
 #define SIM808_RX_PIN 5
 #define SIM808_TX_PIN 4
 #define SIM808_RST_PIN -1
+#define SIM808_PWRKEY_PIN 8
+#define SIM808_STATUS_PIN 9
 
 const char APN[] = "Internet.be";
 const char URL[] = "https://postman-echo.com/get?foo1=bar1&foo2=bar2";
 
 SIM808Driver *sim808;
+SIM808BringUp *bringUp;
 
 void setup()
 {
@@ -56,6 +60,13 @@ void setup()
   // Equivalent line with the debug enabled on the Serial
   //sim808 = new SIM808Driver((Stream *)serial, SIM808_RST_PIN, 200, 512, (Stream *)&Serial);
 
+  // Bring-up up to the APN setup, the bearer is connected by the loop
+  bringUp = new SIM808BringUp(sim808);
+  bringUp->setGPRS(APN, false);
+
+  // Equivalent line with the power key and the status pin wired (module switched on by the bring-up)
+  // bringUp = new SIM808BringUp(sim808, SIM808_PWRKEY_PIN, SIM808_STATUS_PIN);
+
   // Setup module for GPRS communication
   setupModule();
 }
@@ -139,42 +150,23 @@ void loop()
 
 void setupModule()
 {
-  // Wait until the module is ready to accept AT commands
-  while (!sim808->isReady())
-  {
-    Serial.println(F("Problem to initialize AT command, retry in 1 sec"));
-    delay(1000);
-  }
-  Serial.println(F("Setup Complete!"));
-
-  // Wait for the GSM signal
-  uint8_t signal = sim808->getSignal();
-  while (signal <= 0)
-  {
-    delay(1000);
-    signal = sim808->getSignal();
-  }
-  Serial.print(F("Signal OK (strenght: "));
-  Serial.print(signal);
-  Serial.println(F(")"));
-  delay(1000);
-
-  // Wait for operator network registration (national or roaming network)
-  SIM808Driver::NetworkRegistration network = sim808->getRegistrationStatus();
-  while (network != SIM808Driver::NET_REGISTERED_HOME && network != SIM808Driver::NET_REGISTERED_ROAMING)
-  {
-    delay(1000);
-    network = sim808->getRegistrationStatus();
-  }
-  Serial.println(F("Network registration OK"));
-  delay(1000);
-
-  // Setup APN for GPRS configuration
-  bool success = sim808->setupGPRS(APN);
-  while (!success)
+  // Bring-up driven by the URCs of the module (RDY, Call Ready, +CREG) instead of fixed delays
+  bringUp->start();
+  while (bringUp->process() != SIM808BringUp::BRINGUP_DONE)
   {
-    success = sim808->setupGPRS(APN);
-    delay(5000);
+    if (bringUp->getStep() == SIM808BringUp::BRINGUP_FAILED)
+    {
+      Serial.print(F("Bring-up failed at step "));
+      Serial.println(bringUp->getFailedStep());
+      sim808->reset();
+      bringUp->start();
+    }
   }
+  Serial.print(F("Module ready in "));
+  Serial.print(bringUp->getTimeToReady());
+  Serial.println(F(" ms"));
+  Serial.print(F("Network registration OK in "));
+  Serial.print(bringUp->getTimeToRegistered());
+  Serial.println(F(" ms"));
   Serial.println(F("GPRS config OK"));
 }
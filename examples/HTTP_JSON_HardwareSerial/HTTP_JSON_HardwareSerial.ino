@@ -0,0 +1,197 @@
+/********************************************************************************
+ * Example of JSON values extracted from an HTTPS GET with Serial1 (Mega2560)  *
+ *                                                                              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Driver.h"
+#include "SIM808BringUp.h"
+#include "SIM808Json.h"
+
+#define SIM808_RST_PIN 6
+#define SIM808_PWRKEY_PIN 8
+#define SIM808_STATUS_PIN 9
+
+const char APN[] = "Internet.be";
+const char URL[] = "https://postman-echo.com/get?interval=300&command=reboot";
+
+// Paths of the values to extract from the answer {"args":{"interval":"300","command":"reboot"},...}
+const char PATH_INTERVAL[] PROGMEM = "args.interval";
+const char PATH_COMMAND[] PROGMEM = "args.command";
+
+SIM808Driver *sim808;
+SIM808BringUp *bringUp;
+
+// The body is parsed while it is received, only the values are kept in memory
+SIM808JsonExtractor json;
+char interval[8];
+char command[16];
+
+void setup()
+{
+  // Initialize Serial Monitor for debugging
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+
+  // Initialize the hardware Serial1
+  Serial1.begin(9600);
+  delay(1000);
+
+  // Initialize SIM808 driver with an internal buffer of 200 bytes and a small reception buffer of 32 bytes
+  // (the body of the answer is given to the JSON extractor), debug disabled
+  sim808 = new SIM808Driver((Stream *)&Serial1, SIM808_RST_PIN, 200, 32);
+
+  // Equivalent line with the debug enabled on the Serial
+  // sim808 = new SIM808Driver((Stream *)&Serial1, SIM808_RST_PIN, 200, 32, (Stream *)&Serial);
+
+  // Declare the values to extract and give the body of the answers to the extractor
+  json.addPath_P(PATH_INTERVAL, interval, sizeof(interval));
+  json.addPath_P(PATH_COMMAND, command, sizeof(command));
+  sim808->setDataOutput(&json);
+
+  // Bring-up up to the APN setup, the bearer is connected by the loop
+  bringUp = new SIM808BringUp(sim808);
+  bringUp->setGPRS(APN, false);
+
+  // Equivalent line with the power key and the status pin wired (module switched on by the bring-up)
+  // bringUp = new SIM808BringUp(sim808, SIM808_PWRKEY_PIN, SIM808_STATUS_PIN);
+
+  // Setup module for GPRS communication
+  setupModule();
+}
+
+void loop()
+{
+  // Establish GPRS connectivity (5 trials)
+  bool connected = false;
+  for (uint8_t i = 0; i < 5 && !connected; i++)
+  {
+    delay(1000);
+    connected = sim808->connectGPRS();
+  }
+
+  // Check if connected, if not reset the module and setup the config again
+  if (connected)
+  {
+    Serial.println(F("GPRS connected !"));
+  }
+  else
+  {
+    Serial.println(F("GPRS not connected !"));
+    Serial.println(F("Reset the module."));
+    sim808->reset();
+    setupModule();
+    return;
+  }
+
+  Serial.println(F("Start HTTP GET..."));
+
+  // Do HTTP GET communication with 10s for the timeout (read)
+  json.reset();
+  uint16_t rc = sim808->doGet(URL, 10000);
+  if (rc == 200)
+  {
+    // Success, output the values extracted on the serial
+    Serial.print(F("HTTP GET successful ("));
+    Serial.print(sim808->getDataSizeReceived());
+    Serial.println(F(" bytes)"));
+    if (json.isFound(0))
+    {
+      Serial.print(F("Interval : "));
+      Serial.println(interval);
+    }
+    if (json.isFound(1))
+    {
+      Serial.print(F("Command : "));
+      Serial.println(command);
+    }
+    if (json.hasError())
+    {
+      Serial.println(F("Invalid JSON document"));
+    }
+  }
+  else
+  {
+    // Failed...
+    Serial.print(F("HTTP GET error "));
+    Serial.println(rc);
+  }
+
+  // Close GPRS connectivity (5 trials)
+  bool disconnected = sim808->disconnectGPRS();
+  for (uint8_t i = 0; i < 5 && !connected; i++)
+  {
+    delay(1000);
+    disconnected = sim808->disconnectGPRS();
+  }
+
+  if (disconnected)
+  {
+    Serial.println(F("GPRS disconnected !"));
+  }
+  else
+  {
+    Serial.println(F("GPRS still connected !"));
+  }
+
+  // Go into low power mode
+  bool lowPowerMode = sim808->setPowerMode(SIM808Driver::POW_MINIMUM);
+  if (lowPowerMode)
+  {
+    Serial.println(F("Module in low power mode"));
+  }
+  else
+  {
+    Serial.println(F("Failed to switch module to low power mode"));
+  }
+
+  // End of program... wait...
+  while (1)
+    ;
+}
+
+void setupModule()
+{
+  // Bring-up driven by the URCs of the module (RDY, Call Ready, +CREG) instead of fixed delays
+  bringUp->start();
+  while (bringUp->process() != SIM808BringUp::BRINGUP_DONE)
+  {
+    if (bringUp->getStep() == SIM808BringUp::BRINGUP_FAILED)
+    {
+      Serial.print(F("Bring-up failed at step "));
+      Serial.println(bringUp->getFailedStep());
+      sim808->reset();
+      bringUp->start();
+    }
+  }
+  Serial.print(F("Module ready in "));
+  Serial.print(bringUp->getTimeToReady());
+  Serial.println(F(" ms"));
+  Serial.print(F("Network registration OK in "));
+  Serial.print(bringUp->getTimeToRegistered());
+  Serial.println(F(" ms"));
+  Serial.println(F("GPRS config OK"));
+}
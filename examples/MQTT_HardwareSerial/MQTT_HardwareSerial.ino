@@ -0,0 +1,134 @@
+/********************************************************************************
+ * Example of MQTT with HardwareSerial and SIM808-arduino-driver                *
+ *                                                                              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Driver.h"
+#include "SIM808BringUp.h"
+#include "SIM808MqttClient.h"
+
+#define SIM808_RST_PIN 6
+
+const char APN[] = "Internet.be";
+const char BROKER[] = "test.mosquitto.org";
+const char CLIENT_ID[] = "sim808-tracker-1";
+
+SIM808Driver *sim808;
+SIM808BringUp *bringUp;
+SIM808MqttClient *mqtt;
+
+void onMessage(const char *topic, const uint8_t *payload, uint16_t size)
+{
+  Serial.print(F("Message on "));
+  Serial.print(topic);
+  Serial.print(F(" : "));
+  Serial.write(payload, size);
+  Serial.println();
+}
+
+void setup()
+{
+  // Initialize Serial Monitor for debugging
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+
+  // Initialize the hardware Serial1
+  Serial1.begin(9600);
+  delay(1000);
+
+  // Initialize SIM808 driver with an internal buffer of 200 bytes and a reception buffer of 512 bytes, debug disabled
+  sim808 = new SIM808Driver((Stream *)&Serial1, SIM808_RST_PIN, 200, 512);
+
+  // MQTT client on the link 0 with packets of 128 bytes max and a publish queue of 256 bytes
+  mqtt = new SIM808MqttClient(sim808, 0, 128, 256);
+  mqtt->setServer(BROKER, 1883);
+  mqtt->setCallback(onMessage);
+  mqtt->setKeepAlive(60);
+
+  // Bring-up up to the network registration, the TCP/IP stack is started by setupModule()
+  bringUp = new SIM808BringUp(sim808);
+
+  // Setup module and the TCP/IP stack
+  setupModule();
+}
+
+void loop()
+{
+  // (Re)connect to the broker
+  if (!mqtt->connected())
+  {
+    if (mqtt->connect(CLIENT_ID) != SIM808MqttClient::MQTT_CONNECTED)
+    {
+      Serial.println(F("MQTT connection failed, retry in 5 sec"));
+      delay(5000);
+      return;
+    }
+    Serial.println(F("MQTT connected !"));
+    mqtt->subscribe("sim808/tracker-1/config", 1);
+  }
+
+  // Publish a position every 30s (QoS 1, kept in the queue until acknowledged)
+  static uint32_t lastPublish = 0;
+  if (millis() - lastPublish > 30000)
+  {
+    lastPublish = millis();
+    mqtt->publish("sim808/tracker-1/pos", "{\"lat\":50.85,\"lon\":4.35}", 1);
+  }
+
+  // Handle incoming messages, retransmissions and keep-alive
+  mqtt->loop();
+  delay(500);
+}
+
+void setupModule()
+{
+  // Bring-up driven by the URCs of the module (RDY, Call Ready, +CREG) instead of fixed delays
+  bringUp->start();
+  while (bringUp->process() != SIM808BringUp::BRINGUP_DONE)
+  {
+    if (bringUp->getStep() == SIM808BringUp::BRINGUP_FAILED)
+    {
+      Serial.print(F("Bring-up failed at step "));
+      Serial.println(bringUp->getFailedStep());
+      sim808->reset();
+      bringUp->start();
+    }
+  }
+  Serial.print(F("Module ready in "));
+  Serial.print(bringUp->getTimeToReady());
+  Serial.println(F(" ms"));
+  Serial.print(F("Network registration OK in "));
+  Serial.print(bringUp->getTimeToRegistered());
+  Serial.println(F(" ms"));
+
+  // Bring up the TCP/IP stack with the APN
+  while (!sim808->startTCPIP(APN))
+  {
+    delay(5000);
+  }
+  Serial.println(F("TCP/IP stack up"));
+}
@@ -0,0 +1,129 @@
+/********************************************************************************
+ * Example of several modules with HardwareSerial and SIM808-arduino-driver     *
+ *                                                                              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Driver.h"
+#include "SIM808BringUp.h"
+#include "SIM808RequestQueue.h"
+#include "SIM808Scheduler.h"
+
+// Two modules on the hardware serials of an Arduino Mega
+#define MODEM1_RST_PIN 6
+#define MODEM2_RST_PIN 7
+
+const char APN[] = "Internet.be";
+const char URL[] = "https://postman-echo.com/post";
+const char CONTENT_TYPE[] = "application/json";
+
+// One pair of buffers for both modules (the calls run one after the other)
+SIM808SharedBuffers<200, 256> buffers;
+
+SIM808Driver *modem1;
+SIM808Driver *modem2;
+
+SIM808BringUp *bringUp1;
+SIM808BringUp *bringUp2;
+
+SIM808RequestQueue *queue1;
+SIM808RequestQueue *queue2;
+
+SIM808Scheduler scheduler;
+
+uint32_t lastMeasure = 0;
+
+void setup()
+{
+  // Initialize Serial Monitor for debugging
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+
+  // Initialize the hardware serials of the modules
+  Serial1.begin(9600);
+  Serial2.begin(9600);
+  delay(1000);
+
+  // Initialize the drivers on the shared buffers, debug disabled
+  modem1 = new SIM808Driver((Stream *)&Serial1, MODEM1_RST_PIN, buffers.internal, sizeof(buffers.internal), buffers.recv, sizeof(buffers.recv));
+  modem2 = new SIM808Driver((Stream *)&Serial2, MODEM2_RST_PIN, buffers.internal, sizeof(buffers.internal), buffers.recv, sizeof(buffers.recv));
+
+  // Both modules start at the same time, the bearers are opened by the queues when needed
+  bringUp1 = new SIM808BringUp(modem1);
+  bringUp1->setGPRS(APN, false);
+  bringUp2 = new SIM808BringUp(modem2);
+  bringUp2->setGPRS(APN, false);
+  setupModules();
+
+  // Each module sends its own queue, one step each in turn
+  queue1 = new SIM808RequestQueue(modem1, URL, CONTENT_TYPE);
+  queue2 = new SIM808RequestQueue(modem2, URL, CONTENT_TYPE);
+  scheduler.addTask(modem1, SIM808Scheduler::processQueue, queue1);
+  scheduler.addTask(modem2, SIM808Scheduler::processQueue, queue2);
+}
+
+void loop()
+{
+  // Record a measure every 10 seconds on both links
+  if (millis() - lastMeasure > 10000)
+  {
+    lastMeasure = millis();
+    char record[32];
+    sprintf(record, "{\"uptime\":%lu}", lastMeasure / 1000);
+    queue1->enqueue(record);
+    queue2->enqueue(record);
+  }
+
+  scheduler.runAll();
+}
+
+void setupModules()
+{
+  // The steps of both bring-ups run in turn, the slower module does not delay the other one
+  bringUp1->start();
+  bringUp2->start();
+  while (!bringUp1->isDone() || !bringUp2->isDone())
+  {
+    processBringUp(bringUp1, modem1);
+    processBringUp(bringUp2, modem2);
+  }
+  Serial.print(F("Modules ready, registered in "));
+  Serial.print(bringUp1->getTimeToRegistered());
+  Serial.print(F(" ms and "));
+  Serial.print(bringUp2->getTimeToRegistered());
+  Serial.println(F(" ms"));
+}
+
+void processBringUp(SIM808BringUp *bringUp, SIM808Driver *sim808)
+{
+  if (bringUp->process() == SIM808BringUp::BRINGUP_FAILED)
+  {
+    Serial.print(F("Bring-up failed at step "));
+    Serial.println(bringUp->getFailedStep());
+    sim808->reset();
+    bringUp->start();
+  }
+}
@@ -0,0 +1,120 @@
+/********************************************************************************
+ * Example of TCP socket with HardwareSerial and SIM808-arduino-driver          *
+ *                                                                              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Driver.h"
+#include "SIM808BringUp.h"
+
+#define SIM808_RST_PIN 6
+
+const char APN[] = "Internet.be";
+const char HOST[] = "tcpbin.com";
+const uint16_t PORT = 4242;
+
+SIM808Driver *sim808;
+SIM808BringUp *bringUp;
+
+void setup()
+{
+  // Initialize Serial Monitor for debugging
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+
+  // Initialize the hardware Serial1
+  Serial1.begin(9600);
+  delay(1000);
+
+  // Initialize SIM808 driver with an internal buffer of 200 bytes and a reception buffer of 512 bytes, debug disabled
+  sim808 = new SIM808Driver((Stream *)&Serial1, SIM808_RST_PIN, 200, 512);
+
+  // Bring-up up to the network registration, the TCP/IP stack is started by setupModule()
+  bringUp = new SIM808BringUp(sim808);
+
+  // Setup module and the TCP/IP stack
+  setupModule();
+
+  // Open a persistent TCP connection on the link 0
+  while (!sim808->socketOpen(0, SIM808Driver::SOCKET_TCP, HOST, PORT))
+  {
+    Serial.println(F("Unable to connect, retry in 5 sec"));
+    delay(5000);
+  }
+  Serial.println(F("Connected !"));
+}
+
+void loop()
+{
+  // Send a compact frame
+  uint8_t frame[] = {0x01, 0x02, 0x03, '\n'};
+  if (!sim808->socketSend(0, frame, sizeof(frame)))
+  {
+    Serial.println(F("Send failed, reconnect"));
+    sim808->socketClose(0);
+    sim808->socketOpen(0, SIM808Driver::SOCKET_TCP, HOST, PORT);
+    return;
+  }
+
+  // Read the echo (non-blocking, only what is already received by the module)
+  delay(1000);
+  uint8_t buffer[32];
+  uint16_t size = sim808->socketRead(0, buffer, sizeof(buffer));
+  Serial.print(F("Received "));
+  Serial.print(size);
+  Serial.println(F(" bytes"));
+
+  delay(10000);
+}
+
+void setupModule()
+{
+  // Bring-up driven by the URCs of the module (RDY, Call Ready, +CREG) instead of fixed delays
+  bringUp->start();
+  while (bringUp->process() != SIM808BringUp::BRINGUP_DONE)
+  {
+    if (bringUp->getStep() == SIM808BringUp::BRINGUP_FAILED)
+    {
+      Serial.print(F("Bring-up failed at step "));
+      Serial.println(bringUp->getFailedStep());
+      sim808->reset();
+      bringUp->start();
+    }
+  }
+  Serial.print(F("Module ready in "));
+  Serial.print(bringUp->getTimeToReady());
+  Serial.println(F(" ms"));
+  Serial.print(F("Network registration OK in "));
+  Serial.print(bringUp->getTimeToRegistered());
+  Serial.println(F(" ms"));
+
+  // Bring up the TCP/IP stack with the APN
+  while (!sim808->startTCPIP(APN))
+  {
+    delay(5000);
+  }
+  Serial.println(F("TCP/IP stack up"));
+}
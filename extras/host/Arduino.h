@@ -0,0 +1,158 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Minimal Arduino API for the host checks (g++ on Linux/macOS): PROGMEM        *
+ * helpers, Print/Stream and a virtual clock, just enough to build the library  *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_HOST_ARDUINO_H_
+#define _SIM808_HOST_ARDUINO_H_
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Flash memory is plain memory on the host
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strncat_P strncat
+#define memcpy_P memcpy
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+inline char *itoa(int value, char *buffer, int) { sprintf(buffer, "%d", value); return buffer; }
+inline char *utoa(unsigned value, char *buffer, int) { sprintf(buffer, "%u", value); return buffer; }
+inline char *ultoa(unsigned long value, char *buffer, int) { sprintf(buffer, "%lu", value); return buffer; }
+
+// Virtual clock (see HostArduino.cpp): each call to millis() moves it by 1 ms, so the
+// timeouts of the driver expire without waiting, and delay() moves it by the delay
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Current time of the virtual clock, without moving it
+unsigned long hostNow();
+// Move the virtual clock
+void hostAdvance(unsigned long ms);
+// Last value written on an output pin (HIGH before any write)
+int hostPinOutput(uint8_t pin);
+// Value read on an input pin (HIGH by default)
+void hostPinInput(uint8_t pin, int value);
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--)
+    {
+      n += write(*buffer++);
+    }
+    return n;
+  }
+  size_t write(const char *str) { return str != NULL ? write((const uint8_t *)str, strlen(str)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *str) { return write((const char *)str); }
+  size_t print(const char *str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int = 10) { return printValue("%d", value); }
+  size_t print(unsigned int value, int = 10) { return printValue("%u", value); }
+  size_t print(long value, int = 10) { return printValue("%ld", value); }
+  size_t print(unsigned long value, int = 10) { return printValue("%lu", value); }
+  size_t print(double value, int digits = 2) { return printValue("%.*f", digits, value); }
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+  template <typename T>
+  size_t printValue(const char *format, T value)
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), format, value);
+    return write(buffer);
+  }
+  size_t printValue(const char *format, int digits, double value)
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), format, digits, value);
+    return write(buffer);
+  }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(char *buffer, size_t size)
+  {
+    size_t n = 0;
+    while (n < size && available())
+    {
+      buffer[n++] = read();
+    }
+    return n;
+  }
+  size_t readBytes(uint8_t *buffer, size_t size) { return readBytes((char *)buffer, size); }
+};
+
+#endif // _SIM808_HOST_ARDUINO_H_
@@ -0,0 +1,104 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Virtual clock and pins of the host checks                                    *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+
+static unsigned long now = 0;
+
+unsigned long millis()
+{
+  return now++;
+}
+
+unsigned long micros()
+{
+  return now * 1000;
+}
+
+void delay(unsigned long ms)
+{
+  now += ms;
+}
+
+void yield()
+{
+}
+
+unsigned long hostNow()
+{
+  return now;
+}
+
+void hostAdvance(unsigned long ms)
+{
+  now += ms;
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+// Pins: written by the driver (outputs), set by the checks (inputs)
+static uint8_t pinOutputs[256];
+static uint8_t pinInputs[256];
+static bool pinsInitialized = false;
+
+static void initPins()
+{
+  if (!pinsInitialized)
+  {
+    memset(pinOutputs, HIGH, sizeof(pinOutputs));
+    memset(pinInputs, HIGH, sizeof(pinInputs));
+    pinsInitialized = true;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  initPins();
+  pinOutputs[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  initPins();
+  return pinInputs[pin];
+}
+
+int hostPinOutput(uint8_t pin)
+{
+  initPins();
+  return pinOutputs[pin];
+}
+
+void hostPinInput(uint8_t pin, int value)
+{
+  initPins();
+  pinInputs[pin] = value;
+}
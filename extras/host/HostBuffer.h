@@ -0,0 +1,89 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Stream in memory for the host checks: what is written is read back in        *
+ * order, loaded from or saved to a file                                        *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_HOST_BUFFER_H_
+#define _SIM808_HOST_BUFFER_H_
+
+#include <Arduino.h>
+#include <string>
+
+/**
+ * FIFO Stream in memory (trace files, spill area...)
+ */
+class HostBuffer : public Stream
+{
+public:
+  std::string bytes;
+  size_t position = 0;
+
+  // Replace the content by a file, false if it can't be read
+  bool load(const char *path)
+  {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+      return false;
+    }
+    bytes.clear();
+    position = 0;
+    char chunk[4096];
+    size_t size;
+    while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+      bytes.append(chunk, size);
+    }
+    fclose(file);
+    return true;
+  }
+
+  // Write the content to a file, false if it can't be written
+  bool save(const char *path)
+  {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+      return false;
+    }
+    bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && written;
+  }
+
+  int available() { return bytes.size() - position; }
+  int read() { return position < bytes.size() ? (uint8_t)bytes[position++] : -1; }
+  int peek() { return position < bytes.size() ? (uint8_t)bytes[position] : -1; }
+  size_t write(uint8_t c)
+  {
+    bytes += (char)c;
+    return 1;
+  }
+  using Print::write;
+};
+
+#endif // _SIM808_HOST_BUFFER_H_
@@ -0,0 +1,55 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Assertions of the host checks: a failed check is printed with its line and   *
+ * the program exits with an error at the end                                   *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_HOST_CHECK_H_
+#define _SIM808_HOST_CHECK_H_
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                      \
+  do                                                                          \
+  {                                                                           \
+    if (!(condition))                                                         \
+    {                                                                         \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);    \
+      checkFailures++;                                                        \
+    }                                                                         \
+  } while (0)
+
+// Exit code of the check program
+static inline int checkResult(const char *name)
+{
+  printf("%s: %s\n", name, checkFailures == 0 ? "OK" : "FAILED");
+  return checkFailures == 0 ? 0 : 1;
+}
+
+#endif // _SIM808_HOST_CHECK_H_
@@ -0,0 +1,190 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Scripted SIM808 module for the host checks: answers the AT commands with     *
+ * a handler, takes data blocks after prompts and sends URCs on demand          *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_HOST_MODULE_H_
+#define _SIM808_HOST_MODULE_H_
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Module side of the serial link
+ * The handler gets each command line (without CRLF) and returns the answer, or one of:
+ *  "PROMPT:<n>|<answer>" : send "> ", take <n> bytes of data then send <answer> (OK if empty)
+ *  "DOWNLOAD:<n>"        : send DOWNLOAD, take <n> bytes of data then send OK
+ * The answers arrive after the latency of the virtual clock
+ */
+class HostModule : public Stream
+{
+public:
+  std::function<std::string(const std::string &command)> handler;
+  // Called with each data block taken after a prompt
+  std::function<void(const std::string &data)> onData;
+
+  std::vector<std::string> commands;
+  std::string data;
+  bool echo = true;
+  unsigned long latency = 2;
+  // Number of write() calls of the driver (one per byte or per buffer)
+  uint32_t writeCalls = 0;
+
+  // Send bytes to the driver (answer or URC)
+  void push(const std::string &bytes)
+  {
+    for (size_t i = 0; i < bytes.size(); i++)
+    {
+      pending.push_back(std::make_pair(hostNow() + latency, (uint8_t)bytes[i]));
+    }
+  }
+
+  int available()
+  {
+    release();
+    return rx.size();
+  }
+
+  int read()
+  {
+    release();
+    if (rx.empty())
+    {
+      return -1;
+    }
+    int c = rx.front();
+    rx.pop_front();
+    return c;
+  }
+
+  int peek()
+  {
+    release();
+    return rx.empty() ? -1 : rx.front();
+  }
+
+  size_t write(const uint8_t *buffer, size_t size)
+  {
+    writeCalls++;
+    for (size_t i = 0; i < size; i++)
+    {
+      take(buffer[i]);
+    }
+    return size;
+  }
+
+  size_t write(uint8_t c)
+  {
+    writeCalls++;
+    take(c);
+    return 1;
+  }
+
+  using Print::write;
+
+private:
+  std::deque<uint8_t> rx;
+  std::deque<std::pair<unsigned long, uint8_t> > pending;
+  std::string line;
+  size_t dataExpected = 0;
+  std::string afterData;
+
+  // Move to the reception side the bytes whose latency has elapsed
+  void release()
+  {
+    while (!pending.empty() && pending.front().first <= hostNow())
+    {
+      rx.push_back(pending.front().second);
+      pending.pop_front();
+    }
+  }
+
+  void take(uint8_t c)
+  {
+    if (dataExpected > 0)
+    {
+      data += (char)c;
+      if (--dataExpected == 0)
+      {
+        if (onData)
+        {
+          onData(data);
+        }
+        push(afterData.empty() ? std::string("\r\nOK\r\n") : afterData);
+      }
+      return;
+    }
+
+    line += (char)c;
+    if (line.size() < 2 || line.compare(line.size() - 2, 2, "\r\n") != 0)
+    {
+      return;
+    }
+    std::string command = line.substr(0, line.size() - 2);
+    line.clear();
+    commands.push_back(command);
+    if (echo)
+    {
+      push(command + "\r");
+    }
+    if (command == "ATE0")
+    {
+      echo = false;
+    }
+    else if (command == "ATE1")
+    {
+      echo = true;
+    }
+
+    std::string answer = handler ? handler(command) : std::string("\r\nOK\r\n");
+    if (answer.compare(0, 7, "PROMPT:") == 0)
+    {
+      size_t separator = answer.find('|');
+      dataExpected = strtoul(answer.c_str() + 7, NULL, 10);
+      afterData = answer.substr(separator + 1);
+      data.clear();
+      push("\r\n> ");
+    }
+    else if (answer.compare(0, 9, "DOWNLOAD:") == 0)
+    {
+      dataExpected = strtoul(answer.c_str() + 9, NULL, 10);
+      afterData.clear();
+      data.clear();
+      push("\r\nDOWNLOAD\r\n");
+    }
+    else
+    {
+      push(answer);
+    }
+  }
+};
+
+#endif // _SIM808_HOST_MODULE_H_
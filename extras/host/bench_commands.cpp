@@ -0,0 +1,103 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host benchmark of the command path: N commands are sent to the simulated     *
+ * module, the bytes/s and the microseconds per command are printed             *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Driver.h"
+
+struct Result
+{
+  uint32_t commands;
+  uint32_t bytes;
+  uint32_t writes;
+};
+
+// Send the commands of one kind count times, the host time is measured, not the virtual clock
+static Result run(HostModule &module, const char *name, int count, bool (*send)(SIM808Driver &), SIM808Driver &driver)
+{
+  size_t firstCommand = module.commands.size();
+  uint32_t firstWrite = module.writeCalls;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++)
+  {
+    CHECK(send(driver));
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Result result;
+  result.commands = module.commands.size() - firstCommand;
+  result.bytes = 0;
+  for (size_t i = firstCommand; i < module.commands.size(); i++)
+  {
+    result.bytes += module.commands[i].size() + 2;
+  }
+  result.writes = module.writeCalls - firstWrite;
+  printf("bench_commands: %s: %u commands (%u bytes) in %.2f s, %.0f bytes/s, %.2f us/command, %.2f writes/command\n",
+         name, (unsigned)result.commands, (unsigned)result.bytes, seconds, result.bytes / seconds,
+         seconds * 1e6 / result.commands, (double)result.writes / result.commands);
+  return result;
+}
+
+static bool sendShort(SIM808Driver &driver)
+{
+  return driver.isReady();
+}
+
+// 100 characters of APN: the second line (AT+SAPBR=3,1,"APN","...") does not fit the staging buffer
+static bool sendLong(SIM808Driver &driver)
+{
+  return driver.setupGPRS("internet.long-apn-name-of-the-operator.example.com/with/a/path/to/make/it/one-hundred/chars1");
+}
+
+int main()
+{
+  HostModule module;
+  module.echo = false;
+  SIM808Driver driver(&module, RESET_PIN_NOT_USED, 256, 512);
+  // First call: the echo mode of the configuration is set
+  CHECK(driver.isReady());
+
+  const int count = 20000;
+  Result result = run(module, "short", count, sendShort, driver);
+  CHECK(result.commands == (uint32_t)count);
+  // A line that fits the staging buffer is written in one call
+  CHECK(result.writes == result.commands);
+
+  result = run(module, "long parameter", count / 2, sendLong, driver);
+  CHECK(result.commands == (uint32_t)count);
+  // A long line is written in a few parts, never byte per byte
+  CHECK(result.writes < result.commands * 4);
+  CHECK(result.writes * 16 < result.bytes);
+
+  return checkResult("bench_commands");
+}
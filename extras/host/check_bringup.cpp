@@ -0,0 +1,185 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the bring-up sequencer: power key pulse, poll triggered by the *
+ * boot URCs, registration by the +CREG URC, blocking connection of the bearer, *
+ * timeout and failed steps                                                     *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808BringUp.h"
+
+#define PIN_POWER_KEY 7
+#define PIN_STATUS 8
+
+// State of the simulated module
+static bool powered = false;
+static char registration = '2';
+static bool bearerUp = false;
+static bool bearerAccepted = true;
+// Time taken by AT+SAPBR=1,1 (ms)
+static unsigned long bearerTime = 3000;
+
+static std::string answer(const std::string &command)
+{
+  if (!powered)
+  {
+    return "";
+  }
+  if (command == "AT+CREG?")
+  {
+    return std::string("\r\n+CREG: 0,") + registration + "\r\n\r\nOK\r\n";
+  }
+  if (command == "AT+SAPBR=2,1")
+  {
+    return bearerUp ? "\r\n+SAPBR: 1,1,\"10.0.0.1\"\r\n\r\nOK\r\n" : "\r\n+SAPBR: 1,3,\"0.0.0.0\"\r\n\r\nOK\r\n";
+  }
+  if (command == "AT+SAPBR=1,1")
+  {
+    hostAdvance(bearerTime);
+    bearerUp = bearerAccepted;
+    return bearerAccepted ? "\r\nOK\r\n" : "\r\nERROR\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+static size_t countSent(const HostModule &module, size_t first, const std::string &command)
+{
+  size_t n = 0;
+  for (size_t i = first; i < module.commands.size(); i++)
+  {
+    n += module.commands[i] == command;
+  }
+  return n;
+}
+
+int main()
+{
+  HostModule module;
+  module.handler = answer;
+  module.echo = false;
+  SIM808Driver driver(&module);
+
+  // Module off (status pin low): the power key is pulsed, then released by process()
+  hostPinInput(PIN_STATUS, LOW);
+  SIM808BringUp bringUp(&driver, PIN_POWER_KEY, PIN_STATUS);
+  bringUp.setGPRS("internet", true);
+  bringUp.setTimeout(20000);
+  CHECK(hostPinOutput(PIN_POWER_KEY) == HIGH);
+  bringUp.start();
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_POWER_KEY);
+  CHECK(hostPinOutput(PIN_POWER_KEY) == LOW);
+  unsigned long pressed = hostNow();
+  hostAdvance(BRINGUP_POWER_KEY_PULSE / 2);
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_POWER_KEY);
+  CHECK(hostPinOutput(PIN_POWER_KEY) == LOW);
+  hostAdvance(BRINGUP_POWER_KEY_PULSE / 2 + 1);
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_WAIT_READY);
+  CHECK(hostPinOutput(PIN_POWER_KEY) == HIGH);
+  CHECK(hostNow() - pressed >= BRINGUP_POWER_KEY_PULSE);
+  hostPinInput(PIN_STATUS, HIGH);
+
+  // The module boots: no poll before the interval, the RDY URC triggers one at once
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_WAIT_READY);
+  powered = true;
+  size_t first = module.commands.size();
+  hostAdvance(50);
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_WAIT_READY);
+  CHECK(module.commands.size() == first);
+  module.push("\r\nRDY\r\n");
+  hostAdvance(10);
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_WAIT_NETWORK);
+  CHECK(countSent(module, first, "AT") == 1);
+  CHECK(countSent(module, first, "AT+CREG=1") == 1);
+  CHECK(bringUp.getTimeToReady() > 0);
+
+  // Searching: polled at the interval, then registered by the +CREG URC before the next poll
+  first = module.commands.size();
+  for (int i = 0; i < 4; i++)
+  {
+    hostAdvance(BRINGUP_POLL_INTERVAL);
+    CHECK(bringUp.process() == SIM808BringUp::BRINGUP_WAIT_NETWORK);
+  }
+  CHECK(countSent(module, first, "AT+CREG?") >= 3);
+  first = module.commands.size();
+  registration = '1';
+  module.push("\r\n+CREG: 1\r\n");
+  hostAdvance(10);
+  unsigned long urcTime = hostNow();
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_CONNECT);
+  CHECK(countSent(module, first, "AT+CREG?") == 0);
+  CHECK(countSent(module, first, "AT+CREG=0") == 1);
+  CHECK(bringUp.getTimeToRegistered() <= urcTime + 10);
+
+  // Connection of the bearer: the only blocking step, process() returns once the bearer is up
+  first = module.commands.size();
+  unsigned long connectStart = hostNow();
+  CHECK(bringUp.process() == SIM808BringUp::BRINGUP_DONE);
+  CHECK(hostNow() - connectStart >= bearerTime);
+  CHECK(countSent(module, first, "AT+SAPBR=3,1,\"APN\",\"internet\"") == 1);
+  CHECK(countSent(module, first, "AT+SAPBR=1,1") == 1);
+  CHECK(bringUp.isDone() && bringUp.getTimeToBearer() >= bringUp.getTimeToRegistered() + bearerTime);
+  CHECK(bringUp.getFailedStep() == SIM808BringUp::BRINGUP_IDLE);
+
+  // Never registered: the network step times out, the registration URC is switched off
+  bringUp.setGPRS(NULL, false);
+  bringUp.setTimeout(5000);
+  registration = '2';
+  bringUp.start();
+  first = module.commands.size();
+  unsigned long start = hostNow();
+  while (bringUp.process() != SIM808BringUp::BRINGUP_FAILED && hostNow() - start < 60000)
+  {
+    hostAdvance(100);
+  }
+  CHECK(bringUp.getStep() == SIM808BringUp::BRINGUP_FAILED);
+  CHECK(bringUp.getFailedStep() == SIM808BringUp::BRINGUP_WAIT_NETWORK);
+  CHECK(hostNow() - start >= 5000 && hostNow() - start < 10000);
+  CHECK(countSent(module, first, "AT+CREG=1") == 1);
+  CHECK(countSent(module, first, "AT+CREG=0") == 1);
+  CHECK(bringUp.getTimeToRegistered() == 0);
+
+  // Bearer refused: the connection is tried again at each poll until the step fails
+  bringUp.setGPRS("internet", true);
+  registration = '5';
+  bearerUp = false;
+  bearerAccepted = false;
+  bearerTime = 1000;
+  bringUp.start();
+  first = module.commands.size();
+  start = hostNow();
+  while (bringUp.process() != SIM808BringUp::BRINGUP_FAILED && hostNow() - start < 60000)
+  {
+    hostAdvance(100);
+  }
+  CHECK(bringUp.getFailedStep() == SIM808BringUp::BRINGUP_CONNECT);
+  CHECK(countSent(module, first, "AT+SAPBR=1,1") >= 2);
+  CHECK(bringUp.getTimeToRegistered() > 0 && bringUp.getTimeToBearer() == 0);
+
+  return checkResult("check_bringup");
+}
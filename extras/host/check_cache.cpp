@@ -0,0 +1,172 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the HTTP cache: Last-Modified validator (long, truncated), ETag *
+ * ignored, empty store, and the headers given to AT+HTTPPARA="USERDATA"        *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808HttpCache.h"
+
+// Resource of the server stand-in
+static std::string body = "{\"interval\":300}";
+static std::string etag;
+static std::string lastModified;
+// Parameter of the last AT+HTTPPARA="USERDATA"
+static std::string userData;
+static int status = 0;
+static int actions = 0;
+
+static bool sent(const std::string &header)
+{
+  return userData.find(header) != std::string::npos;
+}
+
+static std::string server(const std::string &command)
+{
+  if (command.compare(0, 22, "AT+HTTPPARA=\"USERDATA\"") == 0)
+  {
+    userData = command.substr(23);
+    return "\r\nOK\r\n";
+  }
+  if (command == "AT+HTTPINIT")
+  {
+    userData.clear();
+  }
+  if (command == "AT+HTTPACTION=0")
+  {
+    bool match = (!etag.empty() && sent("If-None-Match: " + etag)) ||
+                 (!lastModified.empty() && sent("If-Modified-Since: " + lastModified));
+    actions++;
+    status = match ? 304 : 200;
+    return "\r\nOK\r\n\r\n+HTTPACTION: 0," + std::to_string(status) + "," + std::to_string(match ? 0 : body.size()) + "\r\n";
+  }
+  if (command == "AT+HTTPHEAD")
+  {
+    std::string head = "HTTP/1.1 " + std::to_string(status) + " OK\r\nContent-Type: application/json\r\n";
+    if (!etag.empty())
+    {
+      head += "ETag: " + etag + "\r\n";
+    }
+    if (!lastModified.empty())
+    {
+      head += "Last-Modified: " + lastModified + "\r\n";
+    }
+    head += "\r\n";
+    return "\r\n+HTTPHEAD: " + std::to_string(head.size()) + "\r\n" + head + "\r\nOK\r\n";
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    return "\r\n+HTTPREAD: " + std::to_string(body.size()) + "\r\n" + body + "\r\nOK\r\n";
+  }
+  if (command == "ATI")
+  {
+    return "\r\nSIM808 R14.18\r\n\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+// The USERDATA parameter is one quoted string, without quote inside
+static bool quotedOnce()
+{
+  return userData.size() >= 2 && userData[0] == '"' && userData[userData.size() - 1] == '"' &&
+         userData.find('"', 1) == userData.size() - 1;
+}
+
+int main()
+{
+  HostModule module;
+  module.handler = server;
+  SIM808Driver driver(&module);
+  char store[64];
+  SIM808HttpCache cache(&driver, "http://example.com/config", store, sizeof(store));
+  cache.setHeaders("Authorization: Bearer t");
+
+  // Last-Modified: sent back, 304
+  lastModified = "Wed, 21 Oct 2026 07:28:00 GMT";
+  CHECK(cache.get(10000) == 200);
+  CHECK(cache.isCached() && cache.getBody() == body);
+  CHECK(cache.getLastModified() == lastModified);
+  CHECK(cache.get(10000) == 304);
+  CHECK(cache.isHit() && cache.getBody() == body);
+  CHECK(sent("Authorization: Bearer t\\r\\nIf-Modified-Since: " + lastModified) && quotedOnce());
+
+  // ETag (quoted weak SHA-1) with Last-Modified: only If-Modified-Since is sent
+  etag = "W/\"0123456789abcdef0123456789abcdef01234567\"";
+  cache.invalidate();
+  CHECK(cache.get(10000) == 200);
+  CHECK(cache.get(10000) == 304);
+  CHECK(!sent("If-None-Match") && sent("If-Modified-Since: " + lastModified) && quotedOnce());
+  CHECK(cache.getDroppedValidators() == 0);
+
+  // ETag alone: no conditional request, every get() downloads the body
+  lastModified.clear();
+  cache.invalidate();
+  CHECK(cache.get(10000) == 200);
+  CHECK(cache.get(10000) == 200);
+  CHECK(!cache.isHit() && !sent("If-"));
+  CHECK(cache.getHits() == 2 && cache.getMisses() == 4);
+
+  // Last-Modified too long: dropped instead of truncated, the next request is not conditional
+  etag.clear();
+  lastModified = std::string(SIM808_CACHE_VALIDATOR_SIZE + 10, 'l');
+  cache.invalidate();
+  CHECK(cache.get(10000) == 200);
+  CHECK(cache.getLastModified()[0] == 0);
+  CHECK(cache.getDroppedValidators() == 1);
+  CHECK(cache.get(10000) == 200);
+  CHECK(!sent("If-Modified-Since"));
+  CHECK(cache.getDroppedValidators() == 2);
+
+  // Longest validator kept
+  lastModified = std::string(SIM808_CACHE_VALIDATOR_SIZE - 1, 'm');
+  cache.invalidate();
+  CHECK(cache.get(10000) == 200);
+  CHECK(cache.getLastModified() == lastModified);
+  CHECK(cache.get(10000) == 304);
+  CHECK(cache.getDroppedValidators() == 2);
+
+  // Empty body: cached as an empty string
+  body.clear();
+  lastModified.clear();
+  cache.invalidate();
+  CHECK(cache.get(10000) == 200);
+  CHECK(cache.isCached() && cache.getBodySize() == 0 && store[0] == 0);
+
+  // Store of 0 byte or without buffer: refused without request
+  actions = 0;
+  SIM808HttpCache empty(&driver, "http://example.com/config", store, 0);
+  CHECK(empty.get(10000) == 702);
+  CHECK(!empty.isCached());
+  SIM808HttpCache missing(&driver, "http://example.com/config", NULL, 64);
+  CHECK(missing.get(10000) == 702);
+  missing.invalidate();
+  CHECK(actions == 0);
+
+  return checkResult("check_cache");
+}
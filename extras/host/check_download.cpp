@@ -0,0 +1,229 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the large downloads: ranges (206), resume after a failed chunk, *
+ * server without range support (200 over 64 KB, short answer) and 416          *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include <zlib.h>
+#include "HostBuffer.h"
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Download.h"
+
+// Resource of the server stand-in
+static std::string resource;
+static bool ranges = true;
+static bool contentLength = true;
+// Range of the last request, and the answer being built
+static std::string userData;
+static int status = 0;
+static std::string answer;
+static std::string head;
+// Next answer cut by the module: announced shorter (200), or data lost during AT+HTTPREAD
+static size_t shortAnswer = 0;
+static size_t cutRead = 0;
+
+static std::string server(const std::string &command)
+{
+  if (command.compare(0, 22, "AT+HTTPPARA=\"USERDATA\"") == 0)
+  {
+    userData = command.substr(23);
+    return "\r\nOK\r\n";
+  }
+  if (command == "AT+HTTPACTION=0")
+  {
+    size_t start = 0;
+    size_t end = resource.size() - 1;
+    bool range = ranges && sscanf(userData.c_str(), "\"Range: bytes=%zu-%zu", &start, &end) == 2;
+    head.clear();
+    if (range && start >= resource.size())
+    {
+      status = 416;
+      answer.clear();
+      head = "Content-Range: bytes */" + std::to_string(resource.size()) + "\r\n";
+    }
+    else if (range)
+    {
+      status = 206;
+      answer = resource.substr(start, end - start + 1);
+      head = "Content-Range: bytes " + std::to_string(start) + "-" + std::to_string(start + answer.size() - 1) + "/" + std::to_string(resource.size()) + "\r\n";
+    }
+    else
+    {
+      status = 200;
+      answer = resource;
+    }
+    if (contentLength)
+    {
+      head += "Content-Length: " + std::to_string(answer.size()) + "\r\n";
+    }
+    if (shortAnswer > 0)
+    {
+      answer.resize(shortAnswer);
+      shortAnswer = 0;
+    }
+    return "\r\nOK\r\n\r\n+HTTPACTION: 0," + std::to_string(status) + "," + std::to_string(answer.size()) + "\r\n";
+  }
+  if (command == "AT+HTTPHEAD")
+  {
+    std::string lines = "HTTP/1.1 " + std::to_string(status) + " OK\r\n" + head + "\r\n";
+    return "\r\n+HTTPHEAD: " + std::to_string(lines.size()) + "\r\n" + lines + "\r\nOK\r\n";
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    if (cutRead > 0)
+    {
+      // The link is lost: the end of the data and the final OK never arrive
+      std::string part = "\r\n+HTTPREAD: " + std::to_string(answer.size()) + "\r\n" + answer.substr(0, cutRead);
+      cutRead = 0;
+      return part;
+    }
+    return "\r\n+HTTPREAD: " + std::to_string(answer.size()) + "\r\n" + answer + "\r\nOK\r\n";
+  }
+  if (command == "ATI")
+  {
+    return "\r\nSIM808 R14.18\r\n\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+static uint32_t crcOf(const std::string &data)
+{
+  return crc32(0, (const Bytef *)data.data(), data.size());
+}
+
+// Process until finished, returns the number of calls
+static int run(SIM808Download &download, std::vector<uint16_t> &codes)
+{
+  int calls = 0;
+  codes.clear();
+  while (!download.isFinished() && calls < 100)
+  {
+    codes.push_back(download.process(20000));
+    calls++;
+  }
+  return calls;
+}
+
+int main()
+{
+  HostModule module;
+  module.handler = server;
+  SIM808Driver driver(&module);
+  std::vector<uint16_t> codes;
+
+  resource.resize(3000);
+  for (size_t i = 0; i < resource.size(); i++)
+  {
+    resource[i] = (char)(i * 7 + i / 251);
+  }
+
+  // Server with ranges: 3 ranges of 1024 bytes, CRC checked
+  {
+    HostBuffer sink;
+    SIM808Download download(&driver, "http://example.com/firmware.bin", &sink, 1024);
+    download.setExpectedCrc32(crcOf(resource));
+    CHECK(run(download, codes) == 3);
+    CHECK(codes == std::vector<uint16_t>({206, 206, 206}));
+    CHECK(sink.bytes == resource);
+    CHECK(download.getSize() == resource.size() && download.isVerified());
+  }
+
+  // Failed chunk: the link is lost in the middle of the second range, the next one starts after the
+  // last byte written
+  {
+    HostBuffer sink;
+    SIM808Download download(&driver, "http://example.com/firmware.bin", &sink, 1024);
+    download.setExpectedCrc32(crcOf(resource));
+    CHECK(download.process(20000) == 206);
+    cutRead = 500;
+    CHECK(download.process(20000) == 705);
+    CHECK(!download.isFinished() && download.getOffset() == 1524);
+    CHECK(download.process(20000) == 206);
+    CHECK(userData == "\"Range: bytes=1524-2547\"");
+    run(download, codes);
+    CHECK(sink.bytes == resource);
+    CHECK(download.isVerified());
+  }
+
+  // Progress restored at the end without the size: 416 finishes the download
+  {
+    HostBuffer sink;
+    SIM808Download download(&driver, "http://example.com/firmware.bin", &sink, 1024);
+    download.setExpectedCrc32(crcOf(resource));
+    SIM808Download::Progress progress = {(uint32_t)resource.size(), 0, crcOf(resource)};
+    download.setProgress(&progress);
+    CHECK(!download.isFinished());
+    CHECK(download.process(20000) == 416);
+    CHECK(download.isFinished() && download.isVerified());
+  }
+
+  // Server without ranges: the whole resource in one 200 answer, larger than 64 KB
+  ranges = false;
+  resource.resize(70000);
+  for (size_t i = 3000; i < resource.size(); i++)
+  {
+    resource[i] = (char)(i * 13 + i / 509);
+  }
+  {
+    HostBuffer sink;
+    SIM808Download download(&driver, "http://example.com/firmware.bin", &sink, 1024);
+    download.setExpectedCrc32(crcOf(resource));
+    CHECK(run(download, codes) == 1 && codes[0] == 200);
+    CHECK(driver.getDataSizeReceived() == resource.size());
+    CHECK(download.getSize() == resource.size() && download.getOffset() == resource.size());
+    CHECK(sink.bytes == resource && download.isVerified());
+  }
+
+  // Short 200 answer (less than Content-Length): not finished, the next answer is written after the
+  // bytes already received
+  {
+    HostBuffer sink;
+    SIM808Download download(&driver, "http://example.com/firmware.bin", &sink, 1024);
+    download.setExpectedCrc32(crcOf(resource));
+    shortAnswer = 30000;
+    CHECK(download.process(20000) == 200);
+    CHECK(!download.isFinished() && !download.isVerified());
+    CHECK(download.getOffset() == 30000 && download.getSize() == resource.size());
+    CHECK(download.process(20000) == 200);
+    CHECK(download.isFinished() && download.getOffset() == resource.size());
+    CHECK(sink.bytes == resource && download.isVerified());
+  }
+
+  // Without Content-Length: the size announced by the module is used
+  contentLength = false;
+  {
+    HostBuffer sink;
+    SIM808Download download(&driver, "http://example.com/firmware.bin", &sink, 1024);
+    CHECK(download.process(20000) == 200);
+    CHECK(download.isFinished() && download.getSize() == resource.size());
+    CHECK(sink.bytes == resource);
+  }
+
+  return checkResult("check_download");
+}
@@ -0,0 +1,135 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the FTP transfers of files done by the module: parameters,     *
+ * end of the transfer read without waiting, URCs kept, FTP errors, firmware    *
+ * without the commands and timeout                                             *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Driver.h"
+
+// Answer of the FTP application to the transfer of a file (pushed with the OK when set)
+static std::string transferEnd;
+static bool firmwareSupport = true;
+
+static std::string answer(const std::string &command)
+{
+  if (command.compare(0, 15, "AT+FTPPUTFRMFS=") == 0 || command.compare(0, 14, "AT+FTPGETTOFS=") == 0)
+  {
+    return firmwareSupport ? "\r\nOK\r\n" + transferEnd : std::string("\r\nERROR\r\n");
+  }
+  return "\r\nOK\r\n";
+}
+
+// Send bytes to the driver after a delay
+static void pushLater(HostModule &module, const std::string &bytes, unsigned long delay)
+{
+  unsigned long latency = module.latency;
+  module.latency = delay;
+  module.push(bytes);
+  module.latency = latency;
+}
+
+static bool sent(const HostModule &module, size_t first, const std::string &command)
+{
+  for (size_t i = first; i < module.commands.size(); i++)
+  {
+    if (module.commands[i] == command)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+int main()
+{
+  HostModule module;
+  module.handler = answer;
+  SIM808Driver driver(&module);
+  CHECK(driver.isReady());
+  driver.setupFTP("ftp.example.com", 21, "user", "password");
+
+  // Upload of a file of the driver: the module reads it, no data crosses the serial
+  size_t first = module.commands.size();
+  transferEnd = "\r\n+FTPPUTFRMFS: 0,5000\r\n";
+  CHECK(driver.ftpPutFromFile("/logs/", "20261019.log", "log.txt", 30000));
+  CHECK(sent(module, first, "AT+FTPPUTNAME=\"20261019.log\""));
+  CHECK(sent(module, first, "AT+FTPPUTPATH=\"/logs/\""));
+  CHECK(sent(module, first, "AT+FTPPUTOPT=\"STOR\""));
+  CHECK(sent(module, first, "AT+FTPPUTFRMFS=\"C:\\User\\log.txt\""));
+  CHECK(module.data.empty());
+  CHECK(driver.getLastResult().bytesSent == 5000);
+  CHECK(driver.getLastResult().stage == SIM808Driver::STAGE_NONE);
+
+  // Download in the module without waiting: the board is free until the end of the transfer, the URCs
+  // received meanwhile are kept
+  first = module.commands.size();
+  transferEnd.clear();
+  CHECK(driver.startFTPGetToFile("/config/", "settings.bin", "settings.bin", 30000));
+  CHECK(sent(module, first, "AT+FTPGETNAME=\"settings.bin\""));
+  CHECK(sent(module, first, "AT+FTPGETTOFS=0,\"settings.bin\""));
+  CHECK(driver.isFTPPending());
+  CHECK(driver.readURC() == NULL);
+  module.push("\r\n+CREG: 5\r\n");
+  hostAdvance(100);
+  CHECK(driver.pollFTP() == 0);
+  pushLater(module, "\r\n+FTPGETTOFS: 0,70000\r\n", 20000);
+  hostAdvance(10000);
+  CHECK(driver.pollFTP() == 0);
+  hostAdvance(10000);
+  CHECK(driver.pollFTP() == 1);
+  CHECK(!driver.isFTPPending() && driver.pollFTP() == 0);
+  CHECK(driver.getLastResult().bytesReceived == 70000);
+  CHECK(driver.getLastResult().stageTime[SIM808Driver::STAGE_READ] >= 20000);
+  const char *urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "+CREG: 5") == 0);
+
+  // FTP error of the session (66: file not found)
+  CHECK(driver.startFTPGetToFile("/config/", "missing.bin", "missing.bin", 30000));
+  pushLater(module, "\r\n+FTPGETTOFS: 66\r\n", 500);
+  hostAdvance(500);
+  CHECK(driver.pollFTP() == -1);
+  CHECK(driver.getLastResult().moduleError == 66);
+  CHECK(driver.getLastResult().stage == SIM808Driver::STAGE_READ);
+
+  // No end of the transfer before the timeout
+  CHECK(driver.startFTPPutFromFile("/logs/", "20261019.log", "log.txt", 5000));
+  hostAdvance(5001);
+  CHECK(driver.pollFTP() == -1);
+  CHECK(!driver.isFTPPending());
+
+  // Firmware without the FTP application: ERROR, nothing is awaited
+  firmwareSupport = false;
+  CHECK(!driver.ftpGetToFile("/config/", "settings.bin", "settings.bin", 30000));
+  CHECK(!driver.isFTPPending());
+  CHECK(driver.getLastResult().stage == SIM808Driver::STAGE_ACTION);
+
+  return checkResult("check_ftp");
+}
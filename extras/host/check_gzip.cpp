@@ -0,0 +1,162 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the gzip encoder: round-trip through zlib, compressed size     *
+ * of the counting pass and CRC32 (build with 'make' in extras/host)            *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include <zlib.h>
+#include <chrono>
+#include <string>
+#include "HostCheck.h"
+#include "SIM808Gzip.h"
+
+// Collects the bytes written by the encoder
+class Buffer : public Print
+{
+public:
+  std::string data;
+  size_t write(uint8_t c) { data += (char)c; return 1; }
+  using Print::write;
+};
+
+// Decompress a gzip member with zlib, false if zlib rejects it
+static bool gunzip(const std::string &in, std::string &out)
+{
+  z_stream z = z_stream();
+  if (inflateInit2(&z, 16 + MAX_WBITS) != Z_OK)
+  {
+    return false;
+  }
+  z.next_in = (Bytef *)in.data();
+  z.avail_in = in.size();
+  char chunk[4096];
+  int rc;
+  do
+  {
+    z.next_out = (Bytef *)chunk;
+    z.avail_out = sizeof(chunk);
+    rc = inflate(&z, Z_NO_FLUSH);
+    out.append(chunk, sizeof(chunk) - z.avail_out);
+  } while (rc == Z_OK);
+  inflateEnd(&z);
+  return rc == Z_STREAM_END && z.avail_in == 0;
+}
+
+// Compress, check the size of the counting pass and the round-trip, returns the compressed size
+static uint32_t roundTrip(const std::string &payload, uint16_t window = SIM808_GZIP_WINDOW)
+{
+  Buffer out;
+  uint32_t counted = SIM808Gzip::compress((const uint8_t *)payload.data(), payload.size(), NULL, window);
+  uint32_t written = SIM808Gzip::compress((const uint8_t *)payload.data(), payload.size(), &out, window);
+  CHECK(counted == written);
+  CHECK(written == out.data.size());
+
+  std::string decoded;
+  CHECK(gunzip(out.data, decoded));
+  CHECK(decoded == payload);
+  return written;
+}
+
+// Host CPU time of doPost(): counting pass then write pass, per KB of payload
+static double costPerKB(const std::string &payload)
+{
+  const int runs = 200;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; i++)
+  {
+    Buffer out;
+    SIM808Gzip::compress((const uint8_t *)payload.data(), payload.size(), NULL);
+    SIM808Gzip::compress((const uint8_t *)payload.data(), payload.size(), &out);
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  return us / runs * 1024 / payload.size();
+}
+
+int main()
+{
+  // Telemetry records as sent by a tracker
+  std::string json = "[";
+  for (int i = 0; i < 12; i++)
+  {
+    char record[96];
+    sprintf(record, "%s{\"ts\":%d,\"lat\":50.85%02d,\"lon\":4.35%02d,\"speed\":%d,\"fix\":3}", i ? "," : "", 1700000000 + i * 30, i, 99 - i, 40 + i % 7);
+    json += record;
+  }
+  json += "]";
+  uint32_t size = roundTrip(json);
+  printf("JSON telemetry: %u -> %u bytes, %.1f us/KB\n", (unsigned)json.size(), (unsigned)size, costPerKB(json));
+  CHECK(size < json.size());
+
+  // Position fixes of the GNSS (fields of AT+CGNSINF)
+  std::string gnss = "[";
+  for (int i = 0; i < 8; i++)
+  {
+    char fix[160];
+    sprintf(fix, "%s{\"utc\":\"20261018101%03d.000\",\"lat\":50.85%03d,\"lon\":4.35%03d,\"alt\":%d.%d,\"speed\":%d.%02d,\"course\":%d.0,\"hdop\":0.9,\"sats\":%d,\"used\":%d}",
+            i ? "," : "", i * 5, 120 + i * 7, 310 - i * 3, 101 + i % 3, i, 12 + i, i * 11 % 100, 180 + i, 11 + i % 2, 8 + i % 3);
+    gnss += fix;
+  }
+  gnss += "]";
+  size = roundTrip(gnss);
+  printf("JSON GNSS fixes: %u -> %u bytes, %.1f us/KB\n", (unsigned)gnss.size(), (unsigned)size, costPerKB(gnss));
+  CHECK(size < gnss.size());
+
+  // Edge cases: empty, one byte, long runs, matches at the window limit, binary data
+  roundTrip("");
+  roundTrip("a");
+  roundTrip(std::string(3000, 'x'));
+  roundTrip(std::string("\0\0\0\1\2\3", 6));
+  std::string pattern;
+  for (int i = 0; i < 1000; i++)
+  {
+    pattern += (char)('a' + i % 23);
+  }
+  roundTrip(pattern, 1);
+  roundTrip(pattern, 23);
+  roundTrip(pattern, 1024);
+
+  // Random data does not shrink but stays valid
+  srand(1);
+  for (int n = 0; n < 200; n++)
+  {
+    std::string random(rand() % 2000, 0);
+    int alphabet = 1 + rand() % 256;
+    for (size_t i = 0; i < random.size(); i++)
+    {
+      random[i] = (char)(rand() % alphabet);
+    }
+    roundTrip(random, 1 + rand() % 512);
+  }
+
+  // CRC32 against zlib, also when updated in several parts
+  uint32_t crc = SIM808Gzip::crc32(0, (const uint8_t *)json.data(), 100);
+  crc = SIM808Gzip::crc32(crc, (const uint8_t *)json.data() + 100, json.size() - 100);
+  CHECK(crc == ::crc32(0, (const Bytef *)json.data(), json.size()));
+
+  return checkResult("check_gzip");
+}
@@ -0,0 +1,122 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the JSON extractor: paths, escapes, truncated values, invalid  *
+ * and too deep documents, and a body streamed by the driver                    *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Driver.h"
+#include "SIM808Json.h"
+
+static std::string body;
+
+static std::string server(const std::string &command)
+{
+  if (command == "AT+HTTPACTION=0")
+  {
+    return "\r\nOK\r\n\r\n+HTTPACTION: 0,200," + std::to_string(body.size()) + "\r\n";
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    return "\r\n+HTTPREAD: " + std::to_string(body.size()) + "\r\n" + body + "\r\nOK\r\n";
+  }
+  if (command == "ATI")
+  {
+    return "\r\nSIM808 R14.18\r\n\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+static void feed(SIM808JsonExtractor &json, const std::string &document)
+{
+  json.reset();
+  json.write((const uint8_t *)document.data(), document.size());
+}
+
+int main()
+{
+  char interval[8];
+  char id[12];
+  char name[16];
+  char enabled[6];
+  char deep[8];
+  SIM808JsonExtractor json;
+  CHECK(json.addPath_P(PSTR("config.interval"), interval, sizeof(interval)) == 0);
+  CHECK(json.addPath_P(PSTR("commands.1.id"), id, sizeof(id)) == 1);
+  CHECK(json.addPath_P(PSTR("name"), name, sizeof(name)) == 2);
+  CHECK(json.addPath_P(PSTR("config.enabled"), enabled, sizeof(enabled)) == 3);
+  CHECK(json.addPath_P(PSTR("a.b.0.0.c"), deep, sizeof(deep)) == 4);
+
+  // Nested objects and arrays, a key of the same name deeper, escapes, truncated value
+  feed(json, " {\"name\":\"dev \\\"x\\\" \\u00e9\\n\",\"config\":{\"interval\":300,\"enabled\":true,\"x\":[1,{\"interval\":5}]},"
+             "\"commands\":[{\"id\":\"c1\"},{\"id\":\"c2-long-value-truncated\",\"arg\":null}],\"a\":{\"b\":[[{\"c\":-1.5e3}]]}} \r\n");
+  CHECK(!json.hasError());
+  CHECK(json.isComplete());
+  CHECK(json.getFoundCount() == 5);
+  CHECK(strcmp(interval, "300") == 0);
+  CHECK(strcmp(id, "c2-long-val") == 0);
+  CHECK(strcmp(name, "dev \"x\" ?\n") == 0);
+  CHECK(strcmp(enabled, "true") == 0);
+  CHECK(strcmp(deep, "-1.5e3") == 0);
+
+  // Invalid document: the values found before the error are kept
+  feed(json, "{\"config\":{\"interval\":1,}x");
+  CHECK(json.hasError());
+  CHECK(json.isFound(0) && strcmp(interval, "1") == 0);
+  CHECK(!json.isFound(1));
+
+  // Deeper than SIM808_JSON_MAX_DEPTH
+  feed(json, std::string(SIM808_JSON_MAX_DEPTH + 1, '[') + "1" + std::string(SIM808_JSON_MAX_DEPTH + 1, ']'));
+  CHECK(json.hasError());
+
+  // Value at the root, complete at the first byte after it
+  char root[8];
+  SIM808JsonExtractor rootJson;
+  rootJson.addPath_P(PSTR(""), root, sizeof(root));
+  feed(rootJson, "42");
+  rootJson.write(' ');
+  CHECK(rootJson.isFound(0) && strcmp(root, "42") == 0);
+  CHECK(rootJson.isComplete());
+
+  // Body larger than the reception buffer, streamed by the driver
+  HostModule module;
+  module.handler = server;
+  SIM808Driver driver(&module);
+  body = "{\"config\":{\"interval\":120},\"commands\":[{\"id\":1},{\"id\":77}],\"pad\":\"" + std::string(2000, 'z') + "\"}";
+  json.reset();
+  driver.setDataOutput(&json);
+  CHECK(driver.doGet("http://example.com/config", 10000) == 200);
+  driver.setDataOutput(NULL);
+  CHECK(driver.getDataSizeReceived() == body.size());
+  CHECK(json.isComplete() && !json.hasError());
+  CHECK(strcmp(interval, "120") == 0);
+  CHECK(strcmp(id, "77") == 0);
+
+  return checkResult("check_json");
+}
@@ -0,0 +1,92 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the debug log: at the default level and buffer size, every     *
+ * command and answer of HTTP calls is written, no message is lost              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostBuffer.h"
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Driver.h"
+
+static const std::string body = "{\"temperature\": 21.5, \"humidity\": 48, \"station\": \"abcdef\"}";
+
+static std::string server(const std::string &command)
+{
+  if (command == "AT+SAPBR=2,1")
+  {
+    return "\r\n+SAPBR: 1,1,\"10.0.0.1\"\r\n\r\nOK\r\n";
+  }
+  if (command.compare(0, 12, "AT+HTTPDATA=") == 0)
+  {
+    return "DOWNLOAD:" + std::to_string(strtoul(command.c_str() + 12, NULL, 10));
+  }
+  if (command.compare(0, 14, "AT+HTTPACTION=") == 0)
+  {
+    return "\r\nOK\r\n\r\n+HTTPACTION: " + command.substr(14) + ",200," + std::to_string(body.size()) + "\r\n";
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    return "\r\n+HTTPREAD: " + std::to_string(body.size()) + "\r\n" + body + "\r\nOK\r\n";
+  }
+  if (command == "ATI")
+  {
+    return "\r\nSIM808 R14.18\r\n\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+static size_t count(const std::string &text, const std::string &part)
+{
+  size_t n = 0;
+  for (size_t p = text.find(part); p != std::string::npos; p = text.find(part, p + 1))
+  {
+    n++;
+  }
+  return n;
+}
+
+int main()
+{
+  HostModule module;
+  module.handler = server;
+  HostBuffer debug;
+  SIM808Driver driver(&module, RESET_PIN_NOT_USED, 256, 512, &debug);
+
+  // HTTPS with long URLs: the longest traces are truncated to SIM808_LOG_LINE
+  module.commands.clear();
+  CHECK(driver.doGet("https://example.com/api/v1/measurements?station=abcdef", 10000) == 200);
+  CHECK(driver.doPost("https://example.com/api/v1/measurements", "application/json", "{\"temperature\": 21.5, \"humidity\": 48}", 10000, 10000) == 200);
+  driver.flushLog();
+
+  CHECK(count(debug.bytes, "messages lost") == 0);
+  CHECK(count(debug.bytes, " D : Send ") == module.commands.size());
+  CHECK(count(debug.bytes, "\n") > 2 * module.commands.size());
+
+  return checkResult("check_log");
+}
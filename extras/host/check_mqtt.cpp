@@ -0,0 +1,179 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the MQTT client: session with a broker stand-in, malformed     *
+ * packets from the broker and keep-alive of a publish-only client              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808MqttClient.h"
+
+static HostModule module;
+// Bytes the broker sends, read by the driver with AT+CIPRXGET
+static std::string inbox;
+// Packets received by the broker
+static std::vector<std::string> packets;
+static bool answerPing = true;
+static std::string lastMessage;
+
+static void broker(const std::string &packet)
+{
+  packets.push_back(packet);
+  uint8_t type = packet[0] & 0xf0;
+  if (type == 0x10)
+  {
+    inbox += std::string("\x20\x02\x00\x00", 4);
+  }
+  else if (type == 0x80)
+  {
+    inbox += std::string("\x90\x03", 2) + packet.substr(2, 2) + std::string("\x01", 1);
+  }
+  else if (type == 0x30 && (packet[0] & 0x06) != 0)
+  {
+    size_t topicLength = ((uint8_t)packet[2] << 8) | (uint8_t)packet[3];
+    inbox += std::string("\x40\x02", 2) + packet.substr(4 + topicLength, 2);
+  }
+  else if (type == 0xC0 && answerPing)
+  {
+    inbox += std::string("\xD0\x00", 2);
+  }
+}
+
+static std::string answer(const std::string &command)
+{
+  if (command.compare(0, 12, "AT+CIPSTART=") == 0)
+  {
+    return "\r\nOK\r\n\r\n0, CONNECT OK\r\n";
+  }
+  if (command.compare(0, 11, "AT+CIPSEND=") == 0)
+  {
+    std::string size = command.substr(command.find(',') + 1);
+    return "PROMPT:" + size + "|\r\nDATA ACCEPT:0," + size + "\r\n";
+  }
+  if (command.compare(0, 16, "AT+CIPRXGET=2,0,") == 0)
+  {
+    size_t size = std::min<size_t>(strtoul(command.c_str() + 16, NULL, 10), inbox.size());
+    std::string bytes = inbox.substr(0, size);
+    inbox.erase(0, size);
+    return "\r\n+CIPRXGET: 2,0," + std::to_string(size) + "," + std::to_string(inbox.size()) + "\r\n" + bytes + "\r\nOK\r\n";
+  }
+  if (command == "AT+CIPCLOSE=0")
+  {
+    return "\r\n0, CLOSE OK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+static void onMessage(const char *topic, const uint8_t *payload, uint16_t size)
+{
+  lastMessage = std::string(topic) + "=" + std::string((const char *)payload, size);
+}
+
+static size_t countPackets(uint8_t type)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < packets.size(); i++)
+  {
+    count += ((uint8_t)packets[i][0] & 0xf0) == type;
+  }
+  return count;
+}
+
+// PUBLISH from the broker with a given topic length field
+static std::string publishPacket(uint8_t flags, uint16_t topicLength, const std::string &rest)
+{
+  std::string variable = std::string(1, (char)(topicLength >> 8)) + std::string(1, (char)(topicLength & 0xff)) + rest;
+  return std::string(1, (char)(0x30 | flags)) + std::string(1, (char)variable.size()) + variable;
+}
+
+int main()
+{
+  module.handler = answer;
+  module.onData = broker;
+  SIM808Driver driver(&module);
+  SIM808MqttClient client(&driver, 0, 64, 128);
+  client.setServer("broker", 1883);
+  client.setCallback(onMessage);
+  client.setKeepAlive(5);
+
+  // Session: queued publish, subscription, QoS 1 message received and acknowledged
+  CHECK(client.publish("t/a", "queued", 1));
+  CHECK(client.connect("dev1", "user", "password") == SIM808MqttClient::MQTT_CONNECTED);
+  CHECK(client.subscribe("cfg/#", 1));
+  CHECK(client.getQueueUsed() == 0);
+  inbox += publishPacket(0x02, 8, std::string("cfg/dev1\x00\x07", 10) + "interval=30");
+  CHECK(client.loop());
+  CHECK(lastMessage == "cfg/dev1=interval=30");
+  CHECK(countPackets(0x40) == 1);
+
+  // Keep-alive of a publish-only client: the ping is answered, the connection stays up
+  for (int i = 0; i < 3; i++)
+  {
+    hostAdvance(6000);
+    CHECK(client.publish("t/b", "x", 0));
+    hostAdvance(6000);
+    CHECK(client.loop());
+    CHECK(client.loop());
+  }
+  CHECK(countPackets(0xC0) == 3);
+  CHECK(client.connected());
+
+  // Unanswered ping: the connection is dropped after the keep-alive delay
+  answerPing = false;
+  hostAdvance(6000);
+  CHECK(client.loop());
+  hostAdvance(6000);
+  CHECK(!client.loop());
+
+  // Malformed packets: topic longer than the packet, missing packet id, short CONNACK and PUBACK
+  const std::string malformed[] = {
+      publishPacket(0x00, 0xffff, "abc"),
+      publishPacket(0x02, 3, "abc"),
+      publishPacket(0x06, 1, "a"),
+      std::string("\x30\x01\x00", 3),
+      std::string("\x40\x01\x00", 3),
+      std::string("\x20\x00", 2),
+  };
+  for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++)
+  {
+    answerPing = true;
+    inbox.clear();
+    CHECK(client.connect("dev1") == SIM808MqttClient::MQTT_CONNECTED);
+    lastMessage.clear();
+    inbox += malformed[i];
+    CHECK(!client.loop());
+    CHECK(lastMessage.empty());
+  }
+
+  // A short CONNACK is not taken as an answer
+  inbox.clear();
+  module.onData = [](const std::string &packet) { packets.push_back(packet); inbox += std::string("\x20\x01\x00", 3); };
+  CHECK(client.connect("dev1") != SIM808MqttClient::MQTT_CONNECTED);
+
+  return checkResult("check_mqtt");
+}
@@ -0,0 +1,239 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the request queue: ring, coalescing, spill (order, reset of    *
+ * the board, short reads), backoff, the failures of the server and the idle    *
+ * time of the bearer                                                           *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include <deque>
+#include "HostBuffer.h"
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808RequestQueue.h"
+
+static HostModule module;
+static bool bearer = true;
+static bool network = true;
+// Codes of the next answers (200 when empty)
+static std::deque<int> codes;
+static std::vector<std::string> bodies;
+static int posts = 0;
+// Time the server takes to answer a POST
+static unsigned long serverTime = 0;
+
+static std::string server(const std::string &command)
+{
+  if (command == "AT+SAPBR=2,1")
+  {
+    return bearer ? "\r\n+SAPBR: 1,1,\"10.0.0.1\"\r\n\r\nOK\r\n" : "\r\n+SAPBR: 1,3,\"0.0.0.0\"\r\n\r\nOK\r\n";
+  }
+  if (command == "AT+SAPBR=1,1")
+  {
+    bearer = network;
+    return network ? "\r\nOK\r\n" : "\r\nERROR\r\n";
+  }
+  if (command.compare(0, 12, "AT+HTTPDATA=") == 0)
+  {
+    return "DOWNLOAD:" + std::to_string(strtoul(command.c_str() + 12, NULL, 10));
+  }
+  if (command == "AT+HTTPACTION=1")
+  {
+    posts++;
+    hostAdvance(serverTime);
+    int code = 200;
+    if (!codes.empty())
+    {
+      code = codes.front();
+      codes.pop_front();
+    }
+    return "\r\nOK\r\n\r\n+HTTPACTION: 1," + std::to_string(code) + ",2\r\n";
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    return "\r\n+HTTPREAD: 2\r\nok\r\nOK\r\n";
+  }
+  if (command == "ATI")
+  {
+    return "\r\nSIM808 R14.18\r\n\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+static void body(const std::string &data)
+{
+  bodies.push_back(data);
+}
+
+// Process until the queue is empty, the backoff delays are skipped
+static void drain(SIM808RequestQueue &queue)
+{
+  for (int i = 0; i < 50 && !queue.isEmpty(); i++)
+  {
+    queue.process();
+    hostAdvance(QUEUE_DEFAULT_MAX_BACKOFF);
+  }
+}
+
+int main()
+{
+  module.handler = server;
+  module.onData = body;
+  SIM808Driver driver(&module);
+
+  // Coalescing: the records are sent in order, as many as fit in a body
+  {
+    SIM808RequestQueue queue(&driver, "http://example.com/", "application/json", 256, 40);
+    queue.setCoalescing("[", ",", "]");
+    CHECK(!queue.enqueue(""));
+    CHECK(!queue.enqueue(std::string(40, 'x').c_str()));
+    for (int i = 0; i < 6; i++)
+    {
+      CHECK(queue.enqueue(("{\"n\":" + std::to_string(i) + "}").c_str()));
+    }
+    bodies.clear();
+    drain(queue);
+    CHECK(bodies.size() == 2);
+    CHECK(bodies.size() == 2 && bodies[0] == "[{\"n\":0},{\"n\":1},{\"n\":2},{\"n\":3}]");
+    CHECK(bodies.size() == 2 && bodies[1] == "[{\"n\":4},{\"n\":5}]");
+    CHECK(queue.getSentRecords() == 6);
+    CHECK(queue.getDroppedRecords() == 2);
+  }
+
+  // Spill: the records beyond the ring keep their order, also after a reset of the board
+  HostBuffer spill;
+  {
+    SIM808RequestQueue queue(&driver, "http://example.com/", "text/plain", 32, 32, &spill);
+    for (int i = 0; i < 8; i++)
+    {
+      CHECK(queue.enqueue(("record" + std::to_string(i)).c_str()));
+    }
+    CHECK(queue.getPendingRecords() == 8);
+    CHECK(spill.bytes.size() > 0);
+  }
+  bodies.clear();
+  {
+    // New run on the same spill: the RAM ring is lost, the spilled records are sent
+    SIM808RequestQueue queue(&driver, "http://example.com/", "text/plain", 32, 32, &spill);
+    CHECK(!queue.isEmpty());
+    CHECK(queue.enqueue("after"));
+    drain(queue);
+    CHECK(queue.isEmpty());
+    CHECK(bodies.size() == 6);
+    CHECK(bodies.size() == 6 && bodies[0] == "record3" && bodies[4] == "record7" && bodies[5] == "after");
+  }
+
+  // Short read of the spill: the cut record is dropped, not sent with missing bytes
+  spill.bytes = std::string("\x03\x00one\x0a\x00two", 9);
+  spill.position = 0;
+  bodies.clear();
+  {
+    SIM808RequestQueue queue(&driver, "http://example.com/", "text/plain", 64, 32, &spill);
+    drain(queue);
+    CHECK(bodies.size() == 1 && bodies[0] == "one");
+    CHECK(queue.getDroppedRecords() == 1);
+  }
+
+  // Erased spill (invalid length): the rest is dropped
+  spill.bytes = std::string("\x03\x00one\xff\xff\xff\xff\xff", 10);
+  spill.position = 0;
+  bodies.clear();
+  {
+    SIM808RequestQueue queue(&driver, "http://example.com/", "text/plain", 64, 32, &spill);
+    drain(queue);
+    CHECK(bodies.size() == 1 && bodies[0] == "one");
+    CHECK(queue.getDroppedRecords() == 1);
+    CHECK(queue.isEmpty());
+  }
+
+  // Backoff: no request before the delay, doubled at each failure up to the maximum
+  {
+    SIM808RequestQueue queue(&driver, "http://example.com/", "text/plain");
+    queue.setBackoff(1000, 3000);
+    queue.enqueue("retry");
+    codes.assign({500, 503, 500, 200});
+    posts = 0;
+    CHECK(queue.process() == 500);
+    CHECK(queue.process() == 0 && posts == 1);
+    hostAdvance(1000);
+    CHECK(queue.process() == 503);
+    hostAdvance(1000);
+    CHECK(queue.process() == 0 && posts == 2);
+    hostAdvance(1000);
+    CHECK(queue.process() == 500);
+    // 4000 ms limited to 3000 ms (the request itself moves the clock)
+    hostAdvance(2000);
+    CHECK(queue.process() == 0 && posts == 3);
+    hostAdvance(1000);
+    CHECK(queue.process() == 200);
+    CHECK(queue.isEmpty() && queue.getSentRecords() == 1);
+
+    // Rejected by the server (4xx): dropped, 408 and 429 are retried
+    codes.assign({400, 429});
+    queue.enqueue("bad");
+    queue.enqueue("busy");
+    CHECK(queue.process() == 400);
+    CHECK(queue.getDroppedRecords() == 1);
+    CHECK(queue.process() == 429);
+    CHECK(queue.getPendingRecords() == 1);
+    hostAdvance(1000);
+    CHECK(queue.process() == 200);
+
+    // Bearer down: no POST while it can't be connected, backoff applies
+    bearer = false;
+    network = false;
+    codes.assign({601});
+    posts = 0;
+    queue.enqueue("offline");
+    CHECK(queue.process() == 601);
+    hostAdvance(1000);
+    CHECK(queue.process() == 0);
+    CHECK(posts == 1);
+    network = true;
+    hostAdvance(2000);
+    CHECK(queue.process() == 200);
+    CHECK(posts == 2 && queue.isEmpty());
+  }
+
+  // Bearer kept warm: the idle time counts from the end of a long request
+  {
+    SIM808RequestQueue queue(&driver, "http://example.com/", "text/plain");
+    driver.setBearerIdleTimeout(5000);
+    serverTime = 8000;
+    queue.enqueue("slow");
+    CHECK(queue.process() == 200);
+    serverTime = 0;
+    module.commands.clear();
+    CHECK(!driver.maintainGPRS());
+    CHECK(driver.getBearerStatus() == SIM808Driver::BEARER_CONNECTED);
+    hostAdvance(5000);
+    CHECK(driver.maintainGPRS());
+    CHECK(!module.commands.empty() && module.commands.back() == "AT+SAPBR=0,1");
+  }
+
+  return checkResult("check_queue");
+}
@@ -0,0 +1,192 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the scheduler: modules on shared buffers waiting for their     *
+ * servers at the same time, aggregate throughput of N modules, and the time    *
+ * the other modules are left unread by a blocking step                         *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808RequestQueue.h"
+#include "SIM808Scheduler.h"
+
+// Size of the serial reception buffer of the AVR cores
+#define SERIAL_RX_BUFFER 64
+// Bytes per second on a 9600 baud UART (10 bits per byte)
+#define UART_BYTES_PER_S 960
+// Modules of the throughput measure, records sent by each
+#define MODEMS 4
+#define RECORDS 5
+
+// Module behind a server answering after a delay (between OK and +HTTPACTION)
+struct Modem
+{
+  HostModule module;
+  unsigned long server = 0;
+};
+
+static Modem modems[MODEMS];
+
+// HTTP POST session, the answer to AT+HTTPACTION comes after the server delay
+static std::string session(Modem &modem, const std::string &command)
+{
+  if (command == "AT+SAPBR=2,1")
+  {
+    return "\r\n+SAPBR: 1,1,\"10.0.0.1\"\r\n\r\nOK\r\n";
+  }
+  if (command.compare(0, 12, "AT+HTTPDATA=") == 0)
+  {
+    return "DOWNLOAD:" + std::to_string(strtoul(command.c_str() + 12, NULL, 10));
+  }
+  if (command == "AT+HTTPACTION=1")
+  {
+    modem.module.push("\r\nOK\r\n");
+    unsigned long latency = modem.module.latency;
+    modem.module.latency = modem.server;
+    modem.module.push("\r\n+HTTPACTION: 1,200,2\r\n");
+    modem.module.latency = latency;
+    return std::string();
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    return "\r\n+HTTPREAD: 2\r\nok\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+// Task sending the next batch with the blocking process() (the server is awaited within the step)
+static bool blockingQueue(SIM808Driver * /*driver*/, void *queue)
+{
+  return ((SIM808RequestQueue *)queue)->process() > 0;
+}
+
+// Time at which the queue of each module was empty
+static unsigned long emptyTime[MODEMS];
+
+// Run n modules through the scheduler until their queues are empty, returns the time taken (ms)
+static unsigned long run(uint8_t n, SIM808Scheduler::Task task, SIM808Scheduler &scheduler)
+{
+  static SIM808SharedBuffers<200, 256> buffers;
+  SIM808Driver *drivers[MODEMS];
+  SIM808RequestQueue *queues[MODEMS];
+  for (uint8_t i = 0; i < n; i++)
+  {
+    Modem *modem = &modems[i];
+    modem->module.handler = [modem](const std::string &command) { return session(*modem, command); };
+    drivers[i] = new SIM808Driver(&modem->module, RESET_PIN_NOT_USED, buffers.internal, sizeof(buffers.internal), buffers.recv, sizeof(buffers.recv));
+    queues[i] = new SIM808RequestQueue(drivers[i], "http://example.com/", "application/json");
+    scheduler.addTask(drivers[i], task, queues[i]);
+    for (int r = 0; r < RECORDS; r++)
+    {
+      queues[i]->enqueue("{\"n\":1}");
+    }
+  }
+
+  unsigned long start = hostNow();
+  bool empty = false;
+  for (int i = 0; i < 100000 && !empty; i++)
+  {
+    scheduler.runAll();
+    empty = true;
+    for (uint8_t m = 0; m < n; m++)
+    {
+      if (!queues[m]->isEmpty())
+      {
+        empty = false;
+        emptyTime[m] = hostNow() - start;
+      }
+    }
+  }
+  unsigned long time = hostNow() - start;
+
+  for (uint8_t i = 0; i < n; i++)
+  {
+    CHECK(queues[i]->getSentRecords() == RECORDS);
+    delete queues[i];
+    delete drivers[i];
+  }
+  return time;
+}
+
+int main()
+{
+  // Round robin: a fast module is not held by the one behind a slow server
+  {
+    modems[0].server = 4000;
+    modems[1].server = 200;
+    SIM808Scheduler scheduler;
+    unsigned long time = run(2, SIM808Scheduler::processQueue, scheduler);
+    CHECK(scheduler.getTaskCount() == 2);
+    CHECK(scheduler.getRuns(0) == scheduler.getRuns(1));
+    // Two busy steps per batch: start, then answer
+    CHECK(scheduler.getBusyRuns(0) == 2 * RECORDS);
+    CHECK(scheduler.getBusyRuns(1) == 2 * RECORDS);
+    // The server wait is not part of the steps, the fast module does not wait for the slow one
+    CHECK(scheduler.getBusyTime(0) < RECORDS * modems[0].server);
+    CHECK(time >= RECORDS * modems[0].server);
+    CHECK(emptyTime[1] < emptyTime[0] / 2);
+    printf("module behind a 4 s server: queue sent in %lu ms, module behind a 200 ms server: %lu ms\n", emptyTime[0], emptyTime[1]);
+  }
+
+  // Aggregate throughput of N modules behind a server answering in 1 s
+  unsigned long blockingTime = 0;
+  unsigned long overlappedTime = 0;
+  for (uint8_t i = 0; i < MODEMS; i++)
+  {
+    modems[i].server = 1000;
+  }
+  {
+    SIM808Scheduler scheduler;
+    blockingTime = run(MODEMS, blockingQueue, scheduler);
+  }
+  {
+    SIM808Scheduler scheduler;
+    overlappedTime = run(MODEMS, SIM808Scheduler::processQueue, scheduler);
+  }
+  double blockingRate = MODEMS * RECORDS * 1000.0 / blockingTime;
+  double overlappedRate = MODEMS * RECORDS * 1000.0 / overlappedTime;
+  printf("%u modules, %u requests each, server 1000 ms: blocking %.2f requests/s (%lu ms), overlapped %.2f requests/s (%lu ms)\n",
+         MODEMS, RECORDS, blockingRate, blockingTime, overlappedRate, overlappedTime);
+  CHECK(overlappedRate > 1.5 * blockingRate);
+
+  // A blocking step lasts at least its server delay, the other modules are not read meanwhile
+  {
+    modems[0].server = 4000;
+    modems[1].server = 200;
+    SIM808Scheduler scheduler;
+    run(2, blockingQueue, scheduler);
+    uint32_t slowStep = scheduler.getBusyTime(0) / scheduler.getBusyRuns(0);
+    CHECK(slowStep >= modems[0].server);
+    uint32_t unread = slowStep * UART_BYTES_PER_S / 1000;
+    printf("blocking step of a module behind a 4 s server: %u ms, bytes the other module can send at 9600 baud meanwhile: %u (serial buffer: %u)\n",
+           (unsigned)slowStep, (unsigned)unread, SERIAL_RX_BUFFER);
+    CHECK(unread > SERIAL_RX_BUFFER);
+  }
+
+  return checkResult("check_scheduler");
+}
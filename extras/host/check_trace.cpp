@@ -0,0 +1,134 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the trace recorder and replay: a session recorded on an        *
+ * output or in a ring buffer is replayed to the driver without mismatch        *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostBuffer.h"
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Driver.h"
+#include "SIM808Trace.h"
+
+static std::string answer(const std::string &command)
+{
+  if (command == "AT+HTTPACTION=0")
+  {
+    return "\r\nOK\r\n\r\n+HTTPACTION: 0,200,5\r\n";
+  }
+  if (command == "AT+HTTPREAD")
+  {
+    return "\r\n+HTTPREAD: 5\r\nhello\r\nOK\r\n";
+  }
+  if (command == "ATI")
+  {
+    return "\r\nSIM808 R14.18\r\n\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+// Walk the records of a trace, false if a record is cut or has an unknown type
+static bool validTrace(const std::string &trace, uint16_t *records)
+{
+  size_t pos = 0;
+  *records = 0;
+  while (pos < trace.size())
+  {
+    if (trace.size() - pos < TRACE_HEADER_SIZE || (trace[pos] != TRACE_RECORD_TX && trace[pos] != TRACE_RECORD_RX))
+    {
+      return false;
+    }
+    pos += TRACE_HEADER_SIZE + (uint8_t)trace[pos + TRACE_HEADER_SIZE - 1];
+    (*records)++;
+  }
+  return pos == trace.size();
+}
+
+int main()
+{
+  // Record a GET on an output, then replay it
+  HostModule module;
+  module.handler = answer;
+  module.latency = 300;
+  HostBuffer output;
+  SIM808TraceStream recorder(&module, &output);
+  {
+    SIM808Driver driver(&recorder);
+    CHECK(driver.doGet("http://example.com/", 10000) == 200);
+    CHECK(strcmp(driver.getDataReceived(), "hello") == 0);
+  }
+  recorder.flushTrace();
+  uint16_t records;
+  CHECK(validTrace(output.bytes, &records));
+  CHECK(records > 10);
+  // Sample for trace_replay (see the Makefile)
+  CHECK(output.save("build/get.trace"));
+
+  // Nothing to dump without ring buffer
+  HostBuffer nothing;
+  recorder.dumpTrace(&nothing);
+  CHECK(nothing.bytes.empty());
+
+  SIM808TraceReplay replay(&output);
+  {
+    SIM808Driver driver(&replay);
+    CHECK(driver.doGet("http://example.com/", 10000) == 200);
+    CHECK(strcmp(driver.getDataReceived(), "hello") == 0);
+  }
+  CHECK(replay.getMismatches() == 0);
+  CHECK(replay.isFinished());
+
+  // A different call is reported as mismatches
+  output.position = 0;
+  SIM808TraceReplay other(&output);
+  {
+    SIM808Driver driver(&other);
+    driver.doGet("http://example.org/", 10000);
+  }
+  CHECK(other.getMismatches() > 0);
+
+  // Ring buffer smaller than the session: the oldest records are dropped, the dump keeps whole records
+  for (uint16_t ringSize = TRACE_HEADER_SIZE; ringSize < 400; ringSize += 37)
+  {
+    uint8_t ring[400];
+    HostModule ringModule;
+    ringModule.handler = answer;
+    SIM808TraceStream ringRecorder(&ringModule, ring, ringSize);
+    {
+      SIM808Driver driver(&ringRecorder);
+      driver.doGet("http://example.com/", 10000);
+    }
+    HostBuffer dump;
+    ringRecorder.dumpTrace(&dump);
+    CHECK(dump.bytes.size() <= ringSize);
+    CHECK(validTrace(dump.bytes, &records));
+    CHECK(ringRecorder.getDroppedRecords() > 0);
+  }
+
+  return checkResult("check_trace");
+}
@@ -0,0 +1,135 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Host check of the command lines and URCs: one write per command line,        *
+ * URCs received before a command or while a request waits for its server are   *
+ * kept for readURC()                                                           *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostCheck.h"
+#include "HostModule.h"
+#include "SIM808Driver.h"
+
+static std::string answer(const std::string &command)
+{
+  if (command == "AT+CSQ")
+  {
+    return "\r\n+CSQ: 17,0\r\n\r\nOK\r\n";
+  }
+  if (command == "AT+SAPBR=2,1")
+  {
+    return "\r\n+SAPBR: 1,1,\"10.0.0.1\"\r\n\r\nOK\r\n";
+  }
+  // The answer of the server is pushed by the check
+  if (command == "AT+HTTPACTION=0")
+  {
+    return "\r\nOK\r\n";
+  }
+  return "\r\nOK\r\n";
+}
+
+// Send bytes to the driver after a delay
+static void pushLater(HostModule &module, const std::string &bytes, unsigned long delay)
+{
+  unsigned long latency = module.latency;
+  module.latency = delay;
+  module.push(bytes);
+  module.latency = latency;
+}
+
+int main()
+{
+  HostModule module;
+  module.handler = answer;
+  SIM808Driver driver(&module);
+  CHECK(driver.isReady());
+
+  // Each command line is written in one call
+  uint32_t writeCalls = module.writeCalls;
+  size_t commands = module.commands.size();
+  CHECK(driver.getSignal() == 17);
+  CHECK(module.commands.size() == commands + 1);
+  CHECK(module.writeCalls == writeCalls + 1);
+
+  // URC received before a command
+  module.push("\r\n+CREG: 1\r\n");
+  hostAdvance(100);
+  CHECK(driver.getSignal() == 17);
+  const char *urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "+CREG: 1") == 0);
+  CHECK(driver.readURC() == NULL);
+
+  // URC partly read by readURC(), the end arrives just before the command
+  module.push("\r\n+CREG: ");
+  hostAdvance(100);
+  CHECK(driver.readURC() == NULL);
+  pushLater(module, "5\r\n", 20);
+  CHECK(driver.getSignal() == 17);
+  urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "+CREG: 5") == 0);
+
+  // Late answer of a previous command: dropped, the URCs around it are kept in their order
+  module.push("\r\nRDY\r\nAT\r\r\nOK\r\n\r\nCall Ready\r\n\r\nSMS Ready\r\n");
+  hostAdvance(100);
+  CHECK(driver.getSignal() == 17);
+  urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "RDY") == 0);
+  urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "Call Ready") == 0);
+  // Beyond URC_QUEUE_SIZE lines, the last ones are dropped
+  CHECK(driver.readURC() == NULL);
+
+  // Without command, the lines are read as they come
+  module.push("\r\n+CREG: 2\r\n\r\n+CREG: 1\r\n");
+  hostAdvance(100);
+  urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "+CREG: 2") == 0);
+  urc = driver.readURC();
+  CHECK(urc != NULL && strcmp(urc, "+CREG: 1") == 0);
+  CHECK(driver.readURC() == NULL);
+
+  // Request waiting for the server: the URCs received meanwhile are kept, +HTTPACTION ends the wait
+  CHECK(driver.startGet("http://example.com/", NULL, 10000) == 0);
+  CHECK(driver.isHTTPPending());
+  module.push("\r\n+CREG: 5\r\n");
+  hostAdvance(100);
+  CHECK(driver.pollHTTP() == 0);
+  CHECK(driver.readURC() != NULL);
+  pushLater(module, "\r\n+HTTPACTION: 0,204,0\r\n", 1000);
+  CHECK(driver.pollHTTP() == 0);
+  hostAdvance(1000);
+  CHECK(driver.pollHTTP() == 204);
+  CHECK(!driver.isHTTPPending() && driver.pollHTTP() == 0);
+
+  // No answer of the server before the timeout
+  CHECK(driver.startGet("http://example.com/", NULL, 5000) == 0);
+  hostAdvance(5001);
+  CHECK(driver.pollHTTP() == 408);
+  CHECK(!driver.isHTTPPending());
+
+  return checkResult("check_urc");
+}
@@ -0,0 +1,225 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Fuzz harness of the AT response parsers: the input is the answer of the      *
+ * module to each command, for libFuzzer, AFL or the built-in mutation loop     *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "HostModule.h"
+#include "SIM808Driver.h"
+#include "SIM808Json.h"
+
+// Gives access to the response reader
+class FuzzDriver : public SIM808Driver
+{
+public:
+  FuzzDriver(Stream *stream, uint16_t internalBufferSize, uint16_t recvBufferSize)
+      : SIM808Driver(stream, RESET_PIN_NOT_USED, internalBufferSize, recvBufferSize) {}
+  using SIM808Driver::readResponse;
+};
+
+// Discards the data of the HTTP and file reads
+class Sink : public Print
+{
+public:
+  size_t write(uint8_t) { return 1; }
+  using Print::write;
+};
+
+// The input is split on NUL bytes, each part is the answer to the next command (in turn)
+static std::vector<std::string> answers;
+static size_t nextAnswer;
+
+static std::string answer(const std::string &)
+{
+  if (answers.empty())
+  {
+    return std::string();
+  }
+  return answers[nextAnswer++ % answers.size()];
+}
+
+static void runParsers(const uint8_t *data, size_t size)
+{
+  std::string input((const char *)data, size);
+  answers.clear();
+  nextAnswer = 0;
+  size_t start = 0;
+  for (size_t end; (end = input.find('\0', start)) != std::string::npos; start = end + 1)
+  {
+    answers.push_back(input.substr(start, end - start));
+  }
+  answers.push_back(input.substr(start));
+
+  // Small buffers so that the long answers reach the limits
+  HostModule module;
+  module.handler = answer;
+  module.latency = 0;
+  FuzzDriver driver(&module, 64 + size % 64, 32 + size % 96);
+  Sink sink;
+
+  // Raw response, then the URC reader on the same bytes
+  module.push(input);
+  driver.readResponse(50);
+  module.push(input);
+  for (int i = 0; i < 16 && driver.readURC() != NULL; i++)
+  {
+  }
+
+  SIM808Driver::GnssInfo gnssInfo;
+  driver.isReady(50);
+  driver.getPowerMode();
+#if SIM808_STATUS
+  driver.getVersion();
+  driver.getSignal();
+  driver.getRegistrationStatus();
+  driver.getFirmware();
+  driver.getSimCardNumber();
+#endif
+#if SIM808_GNSS
+  driver.getGnssPowerStatus();
+  driver.getGnssInfo(&gnssInfo);
+#endif
+#if SIM808_HTTP
+  driver.getBearerStatus();
+  driver.doGet("http://example.com/", 100);
+  driver.setDataOutput(&sink);
+  driver.doGet("http://example.com/", 100);
+  driver.setDataOutput(NULL);
+#endif
+#if SIM808_TCPIP
+  uint8_t buffer[48];
+  driver.socketConnected(0);
+  driver.socketAvailable(0);
+  driver.socketRead(0, buffer, sizeof(buffer));
+#endif
+#if SIM808_FS
+  driver.fileSize("fuzz.bin");
+  driver.fileFreeSpace();
+  driver.fileRead("fuzz.bin", 0, 100, &sink);
+#endif
+
+  // JSON document received by a data output
+  SIM808JsonExtractor json;
+  char interval[8];
+  char id[16];
+  json.addPath_P(PSTR("config.interval"), interval, sizeof(interval));
+  json.addPath_P(PSTR("commands.0.id"), id, sizeof(id));
+  json.write(data, size);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  runParsers(data, size);
+  return 0;
+}
+
+#ifndef SIM808_LIBFUZZER
+// Pieces of module answers for the mutations
+static const char *const PIECES[] = {
+    "\r\nOK\r\n", "\r\nERROR\r\n", "\r\n+CME ERROR: 100\r\n", "+CSQ: ", "+CFUN: ", "+CREG: ", "+CGNSPWR: ",
+    "+CGNSINF: 1,1,20240101120000.000,50.85,4.35,", "+SAPBR: 1,", "+HTTPACTION: 0,", "+HTTPREAD: ",
+    "+CIPRXGET: 2,0,", "+CIPRXGET: 4,0,", "+FSFLSIZE: ", "+FSMEM: C:", "SIM808 R14.18", "RDY\r\n",
+    "{\"config\":{\"interval\":", "\"commands\":[{\"id\":\"", "\\u00e9\"", "]}", ",", "\r\n"};
+
+static std::string mutate(std::mt19937 &random)
+{
+  std::string input;
+  int parts = random() % 24;
+  for (int i = 0; i < parts; i++)
+  {
+    switch (random() % 5)
+    {
+    case 0:
+    case 1:
+      input += PIECES[random() % (sizeof(PIECES) / sizeof(PIECES[0]))];
+      break;
+    case 2:
+      input += std::to_string(random() % 100000);
+      break;
+    case 3:
+      input += '\0';
+      break;
+    default:
+      for (int n = random() % 200; n > 0; n--)
+      {
+        input += (char)(random() % 256);
+      }
+    }
+  }
+  return input;
+}
+
+// Without argument: runs generated inputs and prints the throughput
+// With files (AFL: fuzz_parsers @@): runs each file, "-" reads the standard input
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      FILE *file = strcmp(argv[i], "-") == 0 ? stdin : fopen(argv[i], "rb");
+      if (file == NULL)
+      {
+        perror(argv[i]);
+        return 1;
+      }
+      std::string input;
+      char chunk[4096];
+      for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;)
+      {
+        input.append(chunk, n);
+      }
+      if (file != stdin)
+      {
+        fclose(file);
+      }
+      runParsers((const uint8_t *)input.data(), input.size());
+    }
+    return 0;
+  }
+
+  std::mt19937 random(1);
+  const int count = 4000;
+  size_t bytes = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++)
+  {
+    std::string input = mutate(random);
+    bytes += input.size();
+    runParsers((const uint8_t *)input.data(), input.size());
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("fuzz_parsers: %d inputs (%u bytes) in %.2f s, %.0f inputs/s\n", count, (unsigned)bytes, seconds, count / seconds);
+  printf("fuzz_parsers: OK\n");
+  return 0;
+}
+#endif
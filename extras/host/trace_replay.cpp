@@ -0,0 +1,114 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Replay of a trace recorded on the board (SIM808TraceStream) through the      *
+ * driver on Linux/macOS, to reproduce a problem seen in the field              *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+#include "HostBuffer.h"
+#include "SIM808Driver.h"
+#include "SIM808Trace.h"
+
+/**
+ * Usage: trace_replay <trace file> <call> [arguments]
+ *  dump                print the records of the trace
+ *  ready               isReady()
+ *  get <url>           doGet(url)
+ *  post <url> <body>   doPost(url, text/plain, body)
+ * The call has to be the one made in the recording. The exit code is 0 when the driver sent the
+ * same bytes as in the trace and the whole trace was played
+ */
+
+static void dump(HostBuffer &trace)
+{
+  while (trace.available() >= TRACE_HEADER_SIZE)
+  {
+    char type = trace.read();
+    uint32_t time = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+      time |= (uint32_t)trace.read() << (8 * i);
+    }
+    uint8_t size = trace.read();
+    printf("%10lu %c ", (unsigned long)time, type);
+    for (uint8_t i = 0; i < size && trace.available(); i++)
+    {
+      int c = trace.read();
+      if (c >= 0x20 && c < 0x7f && c != '\\')
+      {
+        putchar(c);
+      }
+      else
+      {
+        printf("\\x%02x", c);
+      }
+    }
+    putchar('\n');
+  }
+}
+
+int main(int argc, char **argv)
+{
+  HostBuffer trace;
+  if (argc < 3 || !trace.load(argv[1]))
+  {
+    fprintf(stderr, "Usage: %s <trace file> dump|ready|get <url>|post <url> <body>\n", argv[0]);
+    return 2;
+  }
+
+  const char *call = argv[2];
+  if (strcmp(call, "dump") == 0)
+  {
+    dump(trace);
+    return 0;
+  }
+
+  SIM808TraceReplay replay(&trace);
+  SIM808Driver driver(&replay, RESET_PIN_NOT_USED, 256, 4096);
+  if (strcmp(call, "ready") == 0)
+  {
+    printf("isReady: %d\n", driver.isReady());
+  }
+  else if (strcmp(call, "get") == 0 && argc > 3)
+  {
+    printf("doGet: %u\n", driver.doGet(argv[3], 10000));
+    printf("%.*s\n", (int)driver.getDataSizeReceived(), driver.getDataReceived());
+  }
+  else if (strcmp(call, "post") == 0 && argc > 4)
+  {
+    printf("doPost: %u\n", driver.doPost(argv[3], "text/plain", argv[4], 10000, 10000));
+    printf("%.*s\n", (int)driver.getDataSizeReceived(), driver.getDataReceived());
+  }
+  else
+  {
+    fprintf(stderr, "Unknown call %s\n", call);
+    return 2;
+  }
+
+  printf("mismatches: %lu, finished: %d\n", (unsigned long)replay.getMismatches(), replay.isFinished());
+  return replay.getMismatches() == 0 && replay.isFinished() ? 0 : 1;
+}
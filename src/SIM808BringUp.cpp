@@ -0,0 +1,315 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Bring-up of the module after a cold start: power key, boot URCs, network     *
+ * registration, GNSS and GPRS bearer, with the time taken by each step         *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Config.h"
+
+#if SIM808_STATUS
+#include "SIM808BringUp.h"
+
+/**
+ * Constructor; setup the pins of the power key and of the status
+ */
+SIM808BringUp::SIM808BringUp(SIM808Driver *_driver, uint8_t _pinPowerKey, uint8_t _pinStatus)
+{
+  driver = _driver;
+  pinPowerKey = _pinPowerKey;
+  pinStatus = _pinStatus;
+
+  if (pinPowerKey != BRINGUP_PIN_NOT_USED)
+  {
+    pinMode(pinPowerKey, OUTPUT);
+    digitalWrite(pinPowerKey, HIGH);
+  }
+  if (pinStatus != BRINGUP_PIN_NOT_USED)
+  {
+    pinMode(pinStatus, INPUT);
+  }
+}
+
+/**
+ * Wait for the network registration or stop once the module answers
+ */
+void SIM808BringUp::setNetwork(bool enable)
+{
+  network = enable;
+}
+
+/**
+ * APN of the GPRS bearer, setup once registered (NULL to skip), and connection of the bearer
+ */
+void SIM808BringUp::setGPRS(const char *_apn, bool _connect)
+{
+  apn = _apn;
+  connect = _connect;
+}
+
+#if SIM808_GNSS
+/**
+ * Power on the GNSS as soon as the module answers, its start overlaps the network registration
+ */
+void SIM808BringUp::setGNSS(bool enable)
+{
+  gnss = enable;
+}
+#endif
+
+/**
+ * Maximum time of each step before the bring-up fails
+ */
+void SIM808BringUp::setTimeout(uint32_t timeoutMs)
+{
+  timeout = timeoutMs;
+}
+
+/**
+ * Start (again) the bring-up, the times are measured from now
+ */
+void SIM808BringUp::start()
+{
+  startTime = millis();
+  timeToReady = 0;
+  timeToRegistered = 0;
+  timeToBearer = 0;
+  failedStep = BRINGUP_IDLE;
+  powerKeyPressed = false;
+  pollNow = true;
+  enterStep(BRINGUP_WAIT_READY);
+}
+
+/**
+ * Run the current step without waiting (except the short answers of the module, and the connection of the
+ * bearer which waits for AT+SAPBR=1,1)
+ */
+SIM808BringUp::Step SIM808BringUp::process()
+{
+  if (step == BRINGUP_IDLE || step == BRINGUP_DONE || step == BRINGUP_FAILED)
+  {
+    return step;
+  }
+
+  // The URCs received since the last call (also those kept by the driver during the polls) trigger a poll
+  // without waiting for the interval
+  const char *urc;
+  while ((urc = driver->readURC()) != NULL)
+  {
+    if (strcmp_P(urc, PSTR("RDY")) == 0 || strcmp_P(urc, PSTR("Call Ready")) == 0 || strcmp_P(urc, PSTR("SMS Ready")) == 0)
+    {
+      pollNow = true;
+    }
+    else if (step == BRINGUP_WAIT_NETWORK && strncmp_P(urc, PSTR("+CREG: "), 7) == 0)
+    {
+      // +CREG: <stat>, 1 for the home network and 5 for roaming
+      if ((urc[7] == '1' || urc[7] == '5') && urc[8] == 0)
+      {
+        registered();
+        return step;
+      }
+    }
+  }
+
+  switch (step)
+  {
+  case BRINGUP_POWER_KEY:
+    if (millis() - stepStart >= BRINGUP_POWER_KEY_PULSE)
+    {
+      digitalWrite(pinPowerKey, HIGH);
+      enterStep(BRINGUP_WAIT_READY);
+    }
+    return step;
+
+  case BRINGUP_WAIT_READY:
+    if (pollDue() && driver->isReady(BRINGUP_PROBE_TIMEOUT))
+    {
+      timeToReady = millis() - startTime;
+#if SIM808_GNSS
+      if (gnss)
+      {
+        driver->powerOnGNSS();
+      }
+#endif
+      if (network)
+      {
+        // The registration is reported by URC as soon as it happens
+        driver->setRegistrationURC(true);
+        pollNow = true;
+        enterStep(BRINGUP_WAIT_NETWORK);
+      }
+      else
+      {
+        enterStep(BRINGUP_DONE);
+      }
+      return step;
+    }
+
+    // The module is off (status pin low, or no answer for a while without status pin)
+    if (pinPowerKey != BRINGUP_PIN_NOT_USED && !powerKeyPressed &&
+        (pinStatus != BRINGUP_PIN_NOT_USED ? digitalRead(pinStatus) == LOW : millis() - stepStart >= BRINGUP_READY_TIMEOUT))
+    {
+      pressPowerKey();
+      return step;
+    }
+    break;
+
+  case BRINGUP_WAIT_NETWORK:
+    if (pollDue())
+    {
+      SIM808Driver::NetworkRegistration registration = driver->getRegistrationStatus();
+      if (registration == SIM808Driver::NET_REGISTERED_HOME || registration == SIM808Driver::NET_REGISTERED_ROAMING)
+      {
+        registered();
+        return step;
+      }
+    }
+    break;
+
+  case BRINGUP_CONNECT:
+    // Blocking: connectGPRS() waits for the bearer (up to 85 s, see the policy table of the driver)
+    if (pollDue() && driver->setupGPRS(apn) && (!connect || driver->connectGPRS()))
+    {
+      if (connect)
+      {
+        timeToBearer = millis() - startTime;
+      }
+      enterStep(BRINGUP_DONE);
+      return step;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  if (millis() - stepStart >= timeout)
+  {
+    if (step == BRINGUP_WAIT_NETWORK)
+    {
+      driver->setRegistrationURC(false);
+    }
+    failedStep = step;
+    enterStep(BRINGUP_FAILED);
+  }
+  return step;
+}
+
+/**
+ * Current step
+ */
+SIM808BringUp::Step SIM808BringUp::getStep()
+{
+  return step;
+}
+
+/**
+ * Step which timed out (BRINGUP_IDLE if the bring-up did not fail)
+ */
+SIM808BringUp::Step SIM808BringUp::getFailedStep()
+{
+  return failedStep;
+}
+
+/**
+ * True when all the steps are done
+ */
+bool SIM808BringUp::isDone()
+{
+  return step == BRINGUP_DONE;
+}
+
+/**
+ * Time from start() to the first answer of the module
+ */
+uint32_t SIM808BringUp::getTimeToReady()
+{
+  return timeToReady;
+}
+
+/**
+ * Time from start() to the network registration
+ */
+uint32_t SIM808BringUp::getTimeToRegistered()
+{
+  return timeToRegistered;
+}
+
+/**
+ * Time from start() to the connection of the GPRS bearer
+ */
+uint32_t SIM808BringUp::getTimeToBearer()
+{
+  return timeToBearer;
+}
+
+/**
+ * Enter a step, its timeout starts
+ */
+void SIM808BringUp::enterStep(Step _step)
+{
+  step = _step;
+  stepStart = millis();
+}
+
+/**
+ * Start the pulse on the power key to switch the module on (released by process())
+ */
+void SIM808BringUp::pressPowerKey()
+{
+  digitalWrite(pinPowerKey, LOW);
+  powerKeyPressed = true;
+  enterStep(BRINGUP_POWER_KEY);
+}
+
+/**
+ * Registered on the network: setup of the bearer if any
+ */
+void SIM808BringUp::registered()
+{
+  timeToRegistered = millis() - startTime;
+  // Afterwards the URCs would only be noise in the answers and the serial buffer (see SIM808Scheduler)
+  driver->setRegistrationURC(false);
+  pollNow = true;
+  enterStep(apn != NULL ? BRINGUP_CONNECT : BRINGUP_DONE);
+}
+
+/**
+ * Time to poll the module: the interval elapsed since the last poll or a URC was received
+ */
+bool SIM808BringUp::pollDue()
+{
+  uint32_t now = millis();
+  if (!pollNow && now - lastPoll < BRINGUP_POLL_INTERVAL)
+  {
+    return false;
+  }
+  pollNow = false;
+  lastPoll = now;
+  return true;
+}
+
+#endif // SIM808_STATUS
@@ -0,0 +1,149 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Bring-up of the module after a cold start: power key, boot URCs, network     *
+ * registration, GNSS and GPRS bearer, with the time taken by each step         *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_BRINGUP_H_
+#define _SIM808_BRINGUP_H_
+
+#include "SIM808Driver.h"
+
+#if !SIM808_STATUS
+#error "SIM808BringUp needs the status subsystem (SIM808_STATUS)"
+#endif
+
+#define BRINGUP_PIN_NOT_USED 0xFF
+#define BRINGUP_DEFAULT_TIMEOUT 60000
+// Time without answer before pulsing the power key when the status pin is not wired (ms)
+#define BRINGUP_READY_TIMEOUT 10000
+// Low pulse on the power key to switch the module on (ms)
+#define BRINGUP_POWER_KEY_PULSE 1100
+// Interval between two polls of the module (AT, registration) when no URC is received (ms)
+#define BRINGUP_POLL_INTERVAL 500
+// Wait for the answer to AT while the module is starting (ms)
+#define BRINGUP_PROBE_TIMEOUT 200
+
+/**
+ * Bring-up of the module, to call in the loop until done
+ * The steps run without waiting (except the short answers of the module), but the connection of the
+ * GPRS bearer (setGPRS(apn, true)): connectGPRS() waits for the bearer, up to 85 s, and the other
+ * bring-ups of the loop wait meanwhile. setGPRS(apn, false) keeps every step short
+ * The boot URCs (RDY, Call Ready, SMS Ready, +CREG) trigger the next step as soon as they are received,
+ * the module is polled in between; the GNSS is powered on as soon as the module answers, so its
+ * start overlaps the network registration
+ * Several modules can be brought up at the same time, with one bring-up per driver
+ * The registration URC (AT+CREG=1) is only enabled while waiting for the network, AT+CREG=0 is sent
+ * once registered or when this step fails
+ */
+class SIM808BringUp
+{
+public:
+  enum Step
+  {
+    BRINGUP_IDLE,         // Not started
+    BRINGUP_POWER_KEY,    // Pulse on the power key in progress
+    BRINGUP_WAIT_READY,   // Wait for the module to answer (RDY or AT)
+    BRINGUP_WAIT_NETWORK, // Wait for the network registration (home or roaming)
+    BRINGUP_CONNECT,      // Setup of the APN and connection of the GPRS bearer (blocking, see setGPRS())
+    BRINGUP_DONE,
+    BRINGUP_FAILED
+  };
+
+  // Initialize the bring-up
+  // Parameters:
+  //  _driver : driver of the module
+  //  _pinPowerKey (optional) : pin driving the PWRKEY of the module (pulled low to switch it on)
+  //  _pinStatus (optional) : pin reading the STATUS of the module (high when it is on)
+  // Without the power key, the module has to be switched on by the hardware
+  SIM808BringUp(SIM808Driver *_driver, uint8_t _pinPowerKey = BRINGUP_PIN_NOT_USED, uint8_t _pinStatus = BRINGUP_PIN_NOT_USED);
+
+  // Wait for the network registration (true by default, false for a GNSS only use)
+  void setNetwork(bool enable);
+  // Setup the APN of the GPRS bearer once registered, and connect the bearer (kept as pointer, must stay valid)
+  // The connection is the only blocking step: process() returns once the bearer is up or failed (up to 85 s,
+  // not cut by setTimeout())
+  void setGPRS(const char *apn, bool connect);
+#if SIM808_GNSS
+  // Power on the GNSS as soon as the module answers
+  void setGNSS(bool enable);
+#endif
+  // Maximum time of each step (ms)
+  void setTimeout(uint32_t timeoutMs);
+
+  // Start (again) from the power on of the module
+  void start();
+  // To call in the loop: run the current step (without waiting but for the connection), returns the current step
+  Step process();
+
+  Step getStep();
+  // Step which timed out when the bring-up failed
+  Step getFailedStep();
+  bool isDone();
+
+  // Time since start() (ms), 0 if not reached
+  uint32_t getTimeToReady();
+  uint32_t getTimeToRegistered();
+  uint32_t getTimeToBearer();
+
+private:
+  void enterStep(Step step);
+  void pressPowerKey();
+  // Registered on the network (URC or poll)
+  void registered();
+  // Time to poll the module (interval elapsed or URC received)
+  bool pollDue();
+
+  SIM808Driver *driver = NULL;
+  uint8_t pinPowerKey = BRINGUP_PIN_NOT_USED;
+  uint8_t pinStatus = BRINGUP_PIN_NOT_USED;
+
+  // Configuration
+  bool network = true;
+  const char *apn = NULL;
+  bool connect = false;
+#if SIM808_GNSS
+  bool gnss = false;
+#endif
+  uint32_t timeout = BRINGUP_DEFAULT_TIMEOUT;
+
+  // State
+  Step step = BRINGUP_IDLE;
+  Step failedStep = BRINGUP_IDLE;
+  uint32_t startTime = 0;
+  uint32_t stepStart = 0;
+  uint32_t lastPoll = 0;
+  // A URC asks for a poll without waiting for the interval
+  bool pollNow = false;
+  bool powerKeyPressed = false;
+
+  uint32_t timeToReady = 0;
+  uint32_t timeToRegistered = 0;
+  uint32_t timeToBearer = 0;
+};
+
+#endif // _SIM808_BRINGUP_H_
@@ -0,0 +1,119 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Compile time configuration of the driver: subsystems and debug output        *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_CONFIG_H_
+#define _SIM808_CONFIG_H_
+
+/**
+ * Each subsystem can be removed from the build by defining its flag to 0, either here
+ * or through the build flags of the project (e.g. -DSIM808_GNSS=0 in platformio.ini)
+ * The functions of a disabled subsystem are not declared, so using them fails at compile time
+ */
+
+// Debug output on the debug stream given to the constructor
+// When disabled, all the debug code and the debug strings are removed from the binary
+#ifndef SIM808_DEBUG
+#define SIM808_DEBUG 1
+#endif
+
+// Level of the debug messages compiled in: 1 errors, 2 warnings, 3 info, 4 debug (all)
+// The messages above this level are removed from the binary
+#ifndef SIM808_LOG_LEVEL
+#define SIM808_LOG_LEVEL 4
+#endif
+
+// Size of the buffer keeping the debug messages until they are written (outside the receptions)
+// At level 4, a command and its answer are logged between two writes (up to 2 lines of SIM808_LOG_LINE
+// plus the messages of the call), 128 bytes only keep the lower levels
+#ifndef SIM808_LOG_BUFFER
+#if SIM808_LOG_LEVEL >= 4
+#define SIM808_LOG_BUFFER 256
+#else
+#define SIM808_LOG_BUFFER 128
+#endif
+#endif
+
+// Maximum size of a debug message (longer messages are truncated)
+#ifndef SIM808_LOG_LINE
+#define SIM808_LOG_LINE 64
+#endif
+
+// HTTP/S GET and POST (doGet, doPost) and the request queue
+#ifndef SIM808_HTTP
+#define SIM808_HTTP 1
+#endif
+
+// Switch to HTTPS depending on the URL (needs the firmware version check)
+#ifndef SIM808_SSL
+#define SIM808_SSL 1
+#endif
+
+// GPS/GNSS functions
+#ifndef SIM808_GNSS
+#define SIM808_GNSS 1
+#endif
+
+// Status functions (signal, registration, firmware, SIM card number)
+#ifndef SIM808_STATUS
+#define SIM808_STATUS 1
+#endif
+
+// TCP/UDP sockets and the MQTT client
+#ifndef SIM808_TCPIP
+#define SIM808_TCPIP 1
+#endif
+
+// Files on the flash of the module (fileWrite, fileRead, doGetToFile...)
+#ifndef SIM808_FS
+#define SIM808_FS 1
+#endif
+
+// FTP transfers (ftpPut, ftpGet)
+#ifndef SIM808_FTP
+#define SIM808_FTP 1
+#endif
+
+// Echo of the commands by the module, switched off by default (ATE0) to halve the bytes received
+// for short commands; the parsers work in both modes
+#ifndef SIM808_ECHO
+#define SIM808_ECHO 0
+#endif
+
+// Size of the staging buffer of the AT command lines (bytes): a line is written on the module in
+// one call when it fits, the long parameters (URL, headers) are written in several parts
+#ifndef SIM808_TX_BUFFER
+#define SIM808_TX_BUFFER 64
+#endif
+
+// Counters and latency histograms of the driver (getMetrics, resetMetrics)
+#ifndef SIM808_METRICS
+#define SIM808_METRICS 1
+#endif
+
+#endif // _SIM808_CONFIG_H_
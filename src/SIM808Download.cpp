@@ -0,0 +1,311 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Resumable download of a large resource (firmware...) with HTTP range         *
+ * requests, written on a sink given by the caller and checked with a CRC32     *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Config.h"
+
+#if SIM808_HTTP
+#include "SIM808Download.h"
+#include "SIM808Gzip.h"
+
+/**
+ * Constructor; prepare the buffer of the request headers
+ */
+SIM808Download::SIM808Download(SIM808Driver *_driver, const char *_url, Print *_sink, uint16_t _chunkSize, uint16_t _headersSize)
+{
+  driver = _driver;
+  url = _url;
+  sink = _sink;
+  chunkSize = _chunkSize > 0 ? _chunkSize : DOWNLOAD_DEFAULT_CHUNK_SIZE;
+
+  requestHeaders = (char *)malloc(_headersSize);
+  if (requestHeaders != NULL)
+  {
+    requestHeadersSize = _headersSize;
+  }
+  // Out of memory: process() fails with 702
+}
+
+/**
+ * Destructor; cleanup the memory allocated by the download
+ */
+SIM808Download::~SIM808Download()
+{
+  free(requestHeaders);
+}
+
+/**
+ * Headers sent with each request
+ */
+void SIM808Download::setHeaders(const char *_headers)
+{
+  headers = _headers;
+}
+
+/**
+ * CRC32 expected for the whole resource
+ */
+void SIM808Download::setExpectedCrc32(uint32_t crc)
+{
+  checkCrc = true;
+  expectedCrc = crc;
+}
+
+/**
+ * Start again from the beginning (the sink has to be rewound by the caller)
+ */
+void SIM808Download::restart()
+{
+  progress.offset = 0;
+  progress.size = 0;
+  progress.crc = 0;
+  finished = false;
+}
+
+void SIM808Download::getProgress(Progress *_progress)
+{
+  memcpy(_progress, &progress, sizeof(Progress));
+}
+
+void SIM808Download::setProgress(const Progress *_progress)
+{
+  memcpy(&progress, _progress, sizeof(Progress));
+  finished = progress.size > 0 && progress.offset >= progress.size;
+}
+
+/**
+ * Download the next range of the resource
+ */
+uint16_t SIM808Download::process(uint16_t serverReadTimeoutMs)
+{
+  if (finished)
+  {
+    return 0;
+  }
+
+  if (!buildHeaders())
+  {
+    return 702;
+  }
+
+  rangeParser.begin();
+  chunkWriter.begin(sink, progress.offset, progress.crc, &rangeParser);
+  driver->setHeaderOutput(&rangeParser);
+  driver->setDataOutput(&chunkWriter);
+  uint16_t rc = driver->doGet(url, requestHeaders, serverReadTimeoutMs);
+  driver->setHeaderOutput(NULL);
+  driver->setDataOutput(NULL);
+
+  // The bytes written are kept even if the request failed, the next range starts after them
+  progress.offset += chunkWriter.written;
+  progress.crc = chunkWriter.crc;
+
+  if (rc == 206 && rangeParser.found && rangeParser.size > 0)
+  {
+    progress.size = rangeParser.size;
+  }
+  else if (rc == 200 && !chunkWriter.gap)
+  {
+    // The server does not support the ranges: the answer is the whole resource, of the size given by
+    // Content-Length (or announced by the module); a short answer is completed by the next one
+    progress.size = rangeParser.length > 0 ? rangeParser.length : driver->getDataSizeReceived();
+  }
+  else if (rc == 416 && rangeParser.size > 0 && progress.offset >= rangeParser.size)
+  {
+    // Nothing left after the offset (progress restored without the size)
+    progress.size = rangeParser.size;
+  }
+
+  finished = progress.size > 0 && progress.offset >= progress.size;
+  return rc;
+}
+
+bool SIM808Download::isFinished()
+{
+  return finished;
+}
+
+bool SIM808Download::isVerified()
+{
+  return finished && (!checkCrc || progress.crc == expectedCrc);
+}
+
+uint32_t SIM808Download::getOffset()
+{
+  return progress.offset;
+}
+
+uint32_t SIM808Download::getSize()
+{
+  return progress.size;
+}
+
+uint32_t SIM808Download::getCrc32()
+{
+  return progress.crc;
+}
+
+/**
+ * Build the headers of the request: range of the next chunk then the headers of the user
+ * The headers are separated by the escaped CRLF expected by AT+HTTPPARA="USERDATA"
+ */
+bool SIM808Download::buildHeaders()
+{
+  if (requestHeaders == NULL)
+  {
+    return false;
+  }
+
+  uint32_t last = progress.offset + chunkSize - 1;
+  if (progress.size > 0 && last >= progress.size)
+  {
+    last = progress.size - 1;
+  }
+
+  int length = snprintf_P(requestHeaders, requestHeadersSize, PSTR("Range: bytes=%lu-%lu"), (unsigned long)progress.offset, (unsigned long)last);
+  if (length < 0 || length >= requestHeadersSize)
+  {
+    return false;
+  }
+
+  if (headers != NULL)
+  {
+    if (length + 4 + strlen(headers) >= requestHeadersSize)
+    {
+      return false;
+    }
+    strcat(requestHeaders, "\\r\\n");
+    strcat(requestHeaders, headers);
+  }
+  return true;
+}
+
+/**
+ * Start the parsing of new headers
+ */
+void SIM808Download::RangeParser::begin()
+{
+  status = 0;
+  found = false;
+  start = 0;
+  size = 0;
+  length = 0;
+  lineLength = 0;
+}
+
+/**
+ * Keep the current header line (truncated) and parse it at its end if it is the Content-Range or the
+ * Content-Length header
+ */
+size_t SIM808Download::RangeParser::write(uint8_t c)
+{
+  if (c != '\r' && c != '\n')
+  {
+    if (lineLength < sizeof(line) - 1)
+    {
+      line[lineLength++] = tolower(c);
+    }
+    return 1;
+  }
+
+  line[lineLength] = 0;
+  lineLength = 0;
+  if (strncmp_P(line, PSTR("http/"), 5) == 0 && strchr(line, ' ') != NULL)
+  {
+    status = atoi(strchr(line, ' ') + 1);
+    return 1;
+  }
+  if (strncmp_P(line, PSTR("content-length:"), 15) == 0)
+  {
+    length = strtoul(line + 15, NULL, 10);
+    return 1;
+  }
+  if (strncmp_P(line, PSTR("content-range:"), 14) != 0)
+  {
+    return 1;
+  }
+
+  // "bytes <start>-<end>/<size>" or "bytes */<size>" (416 answer)
+  char *unit = strstr(line + 14, "bytes ");
+  char *slash = strchr(line + 14, '/');
+  if (unit == NULL || slash == NULL)
+  {
+    return 1;
+  }
+  if (unit[6] != '*')
+  {
+    found = true;
+    start = strtoul(unit + 6, NULL, 10);
+  }
+  if (slash[1] != '*')
+  {
+    size = strtoul(slash + 1, NULL, 10);
+  }
+  return 1;
+}
+
+/**
+ * Start to write a new answer, offset bytes of the resource are already on the sink
+ */
+void SIM808Download::ChunkWriter::begin(Print *_sink, uint32_t _offset, uint32_t _crc, RangeParser *_range)
+{
+  sink = _sink;
+  offset = _offset;
+  crc = _crc;
+  range = _range;
+  written = 0;
+  gap = false;
+  started = false;
+}
+
+/**
+ * Write a byte of the answer on the sink if it follows the bytes already written
+ */
+size_t SIM808Download::ChunkWriter::write(uint8_t c)
+{
+  if (!started)
+  {
+    // Position of the first byte: start of the range, or beginning of the resource for a full answer
+    // (nothing is written if it is unknown: partial answer without its range)
+    position = range->found ? range->start : 0;
+    gap = position > offset || (!range->found && offset > 0 && range->status != 200);
+    started = true;
+  }
+
+  if (!gap && position == offset + written)
+  {
+    sink->write(c);
+    crc = SIM808Gzip::crc32(crc, &c, 1);
+    written++;
+  }
+  position++;
+  return 1;
+}
+
+#endif // SIM808_HTTP
@@ -0,0 +1,150 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Resumable download of a large resource (firmware...) with HTTP range         *
+ * requests, written on a sink given by the caller and checked with a CRC32     *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_DOWNLOAD_H_
+#define _SIM808_DOWNLOAD_H_
+
+#include "SIM808Driver.h"
+
+#if !SIM808_HTTP
+#error "SIM808Download needs the HTTP subsystem (SIM808_HTTP)"
+#endif
+
+#define DOWNLOAD_DEFAULT_CHUNK_SIZE 1024
+
+class SIM808Download
+{
+public:
+  // State of the download, to persist (EEPROM...) to resume it after a reset
+  struct Progress
+  {
+    uint32_t offset; // Bytes written on the sink
+    uint32_t size;   // Size of the resource (0 while unknown)
+    uint32_t crc;    // CRC32 of the bytes written
+  };
+
+  // Initialize the download
+  // Parameters:
+  //  _driver : driver used to send the requests
+  //  _url : URL of the resource (kept as pointer, must stay valid)
+  //  _sink : output receiving the resource, written in order and only once per byte
+  //  _chunkSize (optional) : size in bytes of the ranges requested (limited by the HTTP buffer of the module)
+  //  _headersSize (optional) : size in bytes of the buffer used to build the headers of the requests
+  SIM808Download(SIM808Driver *_driver, const char *_url, Print *_sink, uint16_t _chunkSize = DOWNLOAD_DEFAULT_CHUNK_SIZE, uint16_t _headersSize = 96);
+  ~SIM808Download();
+
+  // Headers sent with each request (kept as pointer, must stay valid)
+  void setHeaders(const char *headers);
+  // CRC32 expected for the whole resource, checked at the end of the download
+  void setExpectedCrc32(uint32_t crc);
+
+  // Start again from the beginning
+  void restart();
+  // Save and restore the state of the download (the sink has to continue after the bytes already written)
+  void getProgress(Progress *progress);
+  void setProgress(const Progress *progress);
+
+  // To call in the loop until isFinished(): download the next range and write it on the sink
+  // Returns the HTTP code of the request (206 or 200 when data was received), or 0 if already finished
+  // A failed range is requested again from the last byte written on the next call
+  // A server without range support answers 200 with the whole resource: the bytes already written are
+  // skipped, and the download is finished when the Content-Length of the answer is reached
+  uint16_t process(uint16_t serverReadTimeoutMs);
+
+  // Status of the download
+  bool isFinished();
+  // True when the download is finished and the CRC32 is the one expected (or no CRC32 is expected)
+  bool isVerified();
+  uint32_t getOffset();
+  uint32_t getSize();
+  uint32_t getCrc32();
+
+private:
+  // Extract the status, the range (Content-Range: bytes <start>-<end>/<size>) and the length of the answer
+  class RangeParser : public Print
+  {
+  public:
+    void begin();
+    size_t write(uint8_t c);
+    using Print::write;
+    uint16_t status = 0; // From the status line, 0 if not seen
+    bool found = false;
+    uint32_t start = 0;
+    uint32_t size = 0;
+    uint32_t length = 0; // Content-Length, 0 if not seen
+
+  private:
+    char line[48];
+    uint8_t lineLength = 0;
+  };
+
+  // Write the bytes of the answer after the ones already written on the sink, with the CRC32
+  // The headers are read before the body, so the position of the first byte is known from the range
+  class ChunkWriter : public Print
+  {
+  public:
+    void begin(Print *_sink, uint32_t _offset, uint32_t _crc, RangeParser *_range);
+    size_t write(uint8_t c);
+    using Print::write;
+    uint32_t written = 0;
+    uint32_t crc = 0;
+    bool gap = false;
+
+  private:
+    Print *sink = NULL;
+    RangeParser *range = NULL;
+    uint32_t offset = 0;
+    uint32_t position = 0;
+    bool started = false;
+  };
+
+  // Build the headers of the request with the range, false if they do not fit in the buffer
+  bool buildHeaders();
+
+  SIM808Driver *driver = NULL;
+  const char *url = NULL;
+  Print *sink = NULL;
+  const char *headers = NULL;
+  uint16_t chunkSize = DOWNLOAD_DEFAULT_CHUNK_SIZE;
+
+  // Headers of the request
+  char *requestHeaders = NULL;
+  uint16_t requestHeadersSize = 0;
+
+  Progress progress = {0, 0, 0};
+  bool finished = false;
+  bool checkCrc = false;
+  uint32_t expectedCrc = 0;
+
+  RangeParser rangeParser;
+  ChunkWriter chunkWriter;
+};
+
+#endif // _SIM808_DOWNLOAD_H_
@@ -29,11 +29,32 @@
  * SOFTWARE.
  *******************************************************************************/
 #include "SIM808Driver.h"
+#include "SIM808Gzip.h"
+#include <stdarg.h>
+
+// Log a message (format in PROGMEM) if its level is compiled in and the debug is enabled
+// The message is formatted in the log buffer and written on the debug stream later, by flushLog()
+#if SIM808_DEBUG
+#define SIM808_LOG(level, ...)                      \
+  do                                                \
+  {                                                 \
+    if (SIM808_LOG_LEVEL >= (level) && enableDebug) \
+      logMessage_P((level), __VA_ARGS__);           \
+  } while (0)
+#else
+#define SIM808_LOG(level, ...) \
+  do                           \
+  {                            \
+  } while (0)
+#endif
 
 /**
  * AT commands required (const char in PROGMEM to save memory usage)
  */
 const char AT_CMD_BASE[] PROGMEM = "AT"; // Basic AT command to check the link
+const char AT_CMD_CMEE1[] PROGMEM = "AT+CMEE=1"; // Numeric error codes of the module
+const char AT_CMD_ATE0[] PROGMEM = "ATE0";       // Command echo off
+const char AT_CMD_ATE1[] PROGMEM = "ATE1";       // Command echo on
 
 const char AT_CMD_CSQ[] PROGMEM = "AT+CSQ";       // Check the signal strengh
 const char AT_CMD_ATI[] PROGMEM = "ATI";          // Output version of the module
@@ -46,10 +67,13 @@ const char AT_CMD_CFUN1[] PROGMEM = "AT+CFUN=1";    // Switch normal power mode
 const char AT_CMD_CFUN4[] PROGMEM = "AT+CFUN=4";    // Switch sleep power mode
 
 const char AT_CMD_CREG_TEST[] PROGMEM = "AT+CREG?";                           // Check the network registration status
+const char AT_CMD_CREG1[] PROGMEM = "AT+CREG=1";                              // URC on the changes of the registration
+const char AT_CMD_CREG0[] PROGMEM = "AT+CREG=0";                              // No URC on the changes of the registration
 const char AT_CMD_SAPBR_GPRS[] PROGMEM = "AT+SAPBR=3,1,\"Contype\",\"GPRS\""; // Configure the GPRS bearer
 const char AT_CMD_SAPBR_APN[] PROGMEM = "AT+SAPBR=3,1,\"APN\",";              // Configure the APN for the GPRS
 const char AT_CMD_SAPBR1[] PROGMEM = "AT+SAPBR=1,1";                          // Connect GPRS
 const char AT_CMD_SAPBR0[] PROGMEM = "AT+SAPBR=0,1";                          // Disconnect GPRS
+const char AT_CMD_SAPBR2[] PROGMEM = "AT+SAPBR=2,1";                          // Query the GPRS bearer status
 
 const char AT_CMD_HTTPINIT[] PROGMEM = "AT+HTTPINIT";                        // Init HTTP connection
 const char AT_CMD_HTTPPARA_CID[] PROGMEM = "AT+HTTPPARA=\"CID\",1";          // Connect HTTP through GPRS bearer
@@ -58,11 +82,63 @@ const char AT_CMD_HTTPPARA_USERDATA[] PROGMEM = "AT+HTTPPARA=\"USERDATA\","; //
 const char AT_CMD_HTTPPARA_CONTENT[] PROGMEM = "AT+HTTPPARA=\"CONTENT\",";   // Define the content type for the HTTP POST
 const char AT_CMD_HTTPSSL_Y[] PROGMEM = "AT+HTTPSSL=1";                      // Enable SSL for HTTP connection
 const char AT_CMD_HTTPSSL_N[] PROGMEM = "AT+HTTPSSL=0";                      // Disable SSL for HTTP connection
+const char AT_CMD_SSLSETCERT[] PROGMEM = "AT+SSLSETCERT=";                   // Load a certificate in the SSL stack
 const char AT_CMD_HTTPACTION0[] PROGMEM = "AT+HTTPACTION=0";                 // Launch HTTP GET action
 const char AT_CMD_HTTPACTION1[] PROGMEM = "AT+HTTPACTION=1";                 // Launch HTTP POST action
 const char AT_CMD_HTTPREAD[] PROGMEM = "AT+HTTPREAD";                        // Start reading HTTP return data
+const char AT_CMD_HTTPHEAD[] PROGMEM = "AT+HTTPHEAD";                        // Read the HTTP headers of the server response
 const char AT_CMD_HTTPTERM[] PROGMEM = "AT+HTTPTERM";                        // Terminate HTTP connection
 
+const char AT_CMD_CIPSHUT[] PROGMEM = "AT+CIPSHUT";       // Close all connections and shut the TCP/IP stack
+const char AT_CMD_CIPMUX1[] PROGMEM = "AT+CIPMUX=1";      // Enable multi-connection mode
+const char AT_CMD_CIPRXGET1[] PROGMEM = "AT+CIPRXGET=1";  // Get the received data manually
+const char AT_CMD_CIPQSEND1[] PROGMEM = "AT+CIPQSEND=1";  // Quick send mode (no wait of the server acknowledgment)
+const char AT_CMD_CSTT[] PROGMEM = "AT+CSTT=";            // Define the APN of the TCP/IP stack
+const char AT_CMD_CIICR[] PROGMEM = "AT+CIICR";           // Bring up the wireless connection
+const char AT_CMD_CIFSR[] PROGMEM = "AT+CIFSR";           // Get the local IP
+const char AT_RSP_SHUT_OK[] PROGMEM = "SHUT OK";          // Expected answer CIPSHUT
+const char AT_RSP_CLOSE_OK[] PROGMEM = "CLOSE OK";        // Expected answer CIPCLOSE
+const char AT_RSP_PROMPT[] PROGMEM = ">";                 // Expected prompt of CIPSEND
+const char AT_RSP_DATA_ACCEPT[] PROGMEM = "DATA ACCEPT";  // Expected answer CIPSEND in quick send mode
+const char AT_RSP_SEND_FAIL[] PROGMEM = "SEND FAIL";      // Error answer of CIPSEND
+const char AT_RSP_CIPRXGET2[] PROGMEM = "+CIPRXGET: 2,";  // Expected answer CIPRXGET=2
+
+const char AT_CMD_FSCREATE[] PROGMEM = "AT+FSCREATE=";  // Create a file
+const char AT_CMD_FSDEL[] PROGMEM = "AT+FSDEL=";        // Delete a file
+const char AT_CMD_FSFLSIZE[] PROGMEM = "AT+FSFLSIZE=";  // Get the size of a file
+const char AT_CMD_FSWRITE[] PROGMEM = "AT+FSWRITE=";    // Write in a file
+const char AT_CMD_FSREAD[] PROGMEM = "AT+FSREAD=";      // Read a file
+const char AT_CMD_FSMEM[] PROGMEM = "AT+FSMEM";         // Get the free space of the flash
+const char FS_PATH[] PROGMEM = "C:\\User\\";            // Directory of the files of the driver
+const char AT_RSP_FSFLSIZE[] PROGMEM = "+FSFLSIZE: ";   // Expected answer FSFLSIZE
+const char AT_RSP_FSMEM[] PROGMEM = "+FSMEM: ";         // Expected answer FSMEM
+const char AT_RSP_CRLF[] PROGMEM = "\r\n";              // End of the line before the data of FSREAD
+
+const char AT_CMD_FTPCID[] PROGMEM = "AT+FTPCID=1";                    // FTP through GPRS bearer
+const char AT_CMD_FTPSERV[] PROGMEM = "AT+FTPSERV=";                   // Set the FTP server
+const char AT_CMD_FTPUN[] PROGMEM = "AT+FTPUN=";                       // Set the FTP user name
+const char AT_CMD_FTPPW[] PROGMEM = "AT+FTPPW=";                       // Set the FTP password
+const char AT_CMD_FTPTYPE[] PROGMEM = "AT+FTPTYPE=\"I\"";              // Binary transfers
+const char AT_CMD_FTPPUTNAME[] PROGMEM = "AT+FTPPUTNAME=";             // Set the name of the file to put
+const char AT_CMD_FTPPUTPATH[] PROGMEM = "AT+FTPPUTPATH=";             // Set the path of the file to put
+const char AT_CMD_FTPPUTOPT_STOR[] PROGMEM = "AT+FTPPUTOPT=\"STOR\"";  // Put replaces the file
+const char AT_CMD_FTPPUTOPT_APPE[] PROGMEM = "AT+FTPPUTOPT=\"APPE\"";  // Put appends to the file
+const char AT_CMD_FTPGETNAME[] PROGMEM = "AT+FTPGETNAME=";             // Set the name of the file to get
+const char AT_CMD_FTPGETPATH[] PROGMEM = "AT+FTPGETPATH=";             // Set the path of the file to get
+const char AT_CMD_FTPPUT1[] PROGMEM = "AT+FTPPUT=1";                   // Open the FTP put session
+const char AT_CMD_FTPPUT_END[] PROGMEM = "AT+FTPPUT=2,0";              // End of the data to put
+const char AT_CMD_FTPGET1[] PROGMEM = "AT+FTPGET=1";                   // Open the FTP get session
+const char AT_RSP_FTPPUT1[] PROGMEM = "+FTPPUT: 1,";                   // Status of the FTP put session
+const char AT_RSP_FTPPUT2[] PROGMEM = "+FTPPUT: 2,";                   // Expected answer FTPPUT=2
+const char AT_RSP_FTPGET1[] PROGMEM = "+FTPGET: 1,";                   // Status of the FTP get session
+const char AT_RSP_FTPGET2[] PROGMEM = "+FTPGET: 2,";                   // Expected answer FTPGET=2
+#if SIM808_FS
+const char AT_CMD_FTPPUTFRMFS[] PROGMEM = "AT+FTPPUTFRMFS=\"";         // Put a file of the module (done by the module)
+const char AT_CMD_FTPGETTOFS[] PROGMEM = "AT+FTPGETTOFS=0,";           // Get a file in the module (done by the module)
+const char AT_RSP_FTPPUTFRMFS[] PROGMEM = "+FTPPUTFRMFS: ";            // End of the put of a file of the module
+const char AT_RSP_FTPGETTOFS[] PROGMEM = "+FTPGETTOFS: ";              // End of the get of a file in the module
+#endif
+
 const char AT_CMD_CGNSPWR1[] PROGMEM = "AT+CGNSPWR=1";    // Power On GNSS
 const char AT_CMD_CGNSPWR0[] PROGMEM = "AT+CGNSPWR=0";    // Power Off GNSS
 const char AT_CMD_CGNSPWR_TEST[] PROGMEM = "AT+CGNSPWR?"; // Get power status of GNSS
@@ -71,9 +147,100 @@ const char AT_CMD_CGNSINF[] PROGMEM = "AT+CGNSINF";       // Get GNSS navigation
 const char AT_RSP_CGNSINF[] PROGMEM = "+CGNSINF: ";       // Expected answer CGNSINF
 const char AT_RSP_UGNSINF[] PROGMEM = "+UGNSINF: ";       // Expected answer CGNSURC
 
+const char HTTP_HEADER_GZIP[] PROGMEM = "Content-Encoding: gzip"; // Header added on compressed POST payloads
+
 const char AT_RSP_OK[] PROGMEM = "OK";                // Expected answer OK
+const char AT_RSP_ERROR[] PROGMEM = "ERROR";          // Error answer
 const char AT_RSP_DOWNLOAD[] PROGMEM = "DOWNLOAD";    // Expected answer DOWNLOAD
 const char AT_RSP_HTTPREAD[] PROGMEM = "+HTTPREAD: "; // Expected answer HTTPREAD
+const char AT_RSP_HTTPHEAD[] PROGMEM = "+HTTPHEAD: "; // Expected answer HTTPHEAD
+const char AT_RSP_SSLSETCERT[] PROGMEM = "+SSLSETCERT: 0"; // Certificate loaded by SSLSETCERT
+
+/**
+ * Timeout and retry policy per command (matched on the beginning of the command sent, first match wins)
+ * Quick commands fail fast, slow commands get the maximum response time of the SIM808 specifications
+ * Only idempotent commands are retried (sending them twice has the same effect as once)
+ */
+const char POLICY_AT[] PROGMEM = "AT";
+const char POLICY_CSQ[] PROGMEM = "AT+CSQ";
+const char POLICY_ATI[] PROGMEM = "ATI";
+const char POLICY_ATE[] PROGMEM = "ATE";
+const char POLICY_GMR[] PROGMEM = "AT+GMR";
+const char POLICY_CCID[] PROGMEM = "AT+CCID";
+const char POLICY_CFUN_TEST[] PROGMEM = "AT+CFUN?";
+const char POLICY_CFUN[] PROGMEM = "AT+CFUN=";
+const char POLICY_CREG[] PROGMEM = "AT+CREG";
+const char POLICY_SAPBR_OPEN[] PROGMEM = "AT+SAPBR=1";
+const char POLICY_SAPBR_CLOSE[] PROGMEM = "AT+SAPBR=0";
+const char POLICY_SAPBR[] PROGMEM = "AT+SAPBR=";
+const char POLICY_HTTPACTION[] PROGMEM = "AT+HTTPACTION";
+const char POLICY_HTTPREAD[] PROGMEM = "AT+HTTPREAD";
+const char POLICY_HTTPHEAD[] PROGMEM = "AT+HTTPHEAD";
+const char POLICY_HTTPDATA[] PROGMEM = "AT+HTTPDATA";
+const char POLICY_HTTPINIT[] PROGMEM = "AT+HTTPINIT";
+const char POLICY_HTTPTERM[] PROGMEM = "AT+HTTPTERM";
+const char POLICY_HTTP[] PROGMEM = "AT+HTTP";
+const char POLICY_SSL[] PROGMEM = "AT+SSL";
+const char POLICY_CIPSHUT[] PROGMEM = "AT+CIPSHUT";
+const char POLICY_CIICR[] PROGMEM = "AT+CIICR";
+const char POLICY_CIPSTART[] PROGMEM = "AT+CIPSTART";
+const char POLICY_CIPCLOSE[] PROGMEM = "AT+CIPCLOSE";
+const char POLICY_CIPSEND[] PROGMEM = "AT+CIPSEND";
+const char POLICY_CIPRXGET_READ[] PROGMEM = "AT+CIPRXGET=2";
+const char POLICY_CIP[] PROGMEM = "AT+CI";
+const char POLICY_CSTT[] PROGMEM = "AT+CSTT";
+const char POLICY_CGNS[] PROGMEM = "AT+CGNS";
+const char POLICY_FSWRITE[] PROGMEM = "AT+FSWRITE";
+const char POLICY_FSCREATE[] PROGMEM = "AT+FSCREATE";
+const char POLICY_FS[] PROGMEM = "AT+FS";
+const char POLICY_FTPPUT[] PROGMEM = "AT+FTPPUT";
+const char POLICY_FTPGET[] PROGMEM = "AT+FTPGET";
+const char POLICY_FTP[] PROGMEM = "AT+FTP";
+
+const SIM808Driver::CommandPolicy COMMAND_POLICIES[] PROGMEM = {
+    // command, timeout (ms), retries, backoff (ms), idempotent
+    {POLICY_AT, 1000, 2, 200, true},
+    {POLICY_CSQ, 1000, 2, 200, true},
+    {POLICY_ATI, 1000, 1, 200, true},
+    {POLICY_ATE, 1000, 2, 200, true},
+    {POLICY_GMR, 1000, 1, 200, true},
+    {POLICY_CCID, 2000, 1, 200, true},
+    {POLICY_CFUN_TEST, 2000, 1, 200, true},
+    {POLICY_CFUN, 10000, 0, 0, false},
+    {POLICY_CREG, 1000, 2, 200, true},
+    {POLICY_SAPBR_OPEN, 85000, 0, 0, false},
+    {POLICY_SAPBR_CLOSE, 65000, 0, 0, false},
+    {POLICY_SAPBR, 2000, 1, 500, true},
+    {POLICY_HTTPACTION, 5000, 0, 0, false},
+    {POLICY_HTTPREAD, 5000, 0, 0, false},
+    {POLICY_HTTPHEAD, 5000, 0, 0, false},
+    {POLICY_HTTPDATA, 5000, 0, 0, false},
+    {POLICY_HTTPINIT, 2000, 0, 0, false},
+    {POLICY_HTTPTERM, 2000, 0, 0, false},
+    {POLICY_HTTP, 2000, 1, 200, true},
+    {POLICY_SSL, 5000, 1, 200, true},
+    {POLICY_CIPSHUT, 65000, 0, 0, true},
+    {POLICY_CIICR, 85000, 0, 0, false},
+    {POLICY_CIPSTART, 5000, 0, 0, false},
+    {POLICY_CIPCLOSE, 5000, 0, 0, false},
+    {POLICY_CIPSEND, 5000, 0, 0, false},
+    {POLICY_CIPRXGET_READ, 5000, 0, 0, false},
+    {POLICY_CIP, 2000, 1, 200, true},
+    {POLICY_CSTT, 2000, 1, 200, true},
+    {POLICY_CGNS, 2000, 1, 200, true},
+    {POLICY_FSWRITE, 5000, 0, 0, false},
+    {POLICY_FSCREATE, 2000, 0, 0, false},
+    {POLICY_FS, 5000, 1, 200, true},
+    {POLICY_FTPPUT, 5000, 0, 0, false},
+    {POLICY_FTPGET, 5000, 0, 0, false},
+    {POLICY_FTP, 2000, 1, 200, true}};
+
+#if SIM808_METRICS
+/**
+ * Limits of the buckets of the latency histograms (ms), the last bucket has no limit
+ */
+const uint32_t METRICS_BUCKET_LIMITS[METRICS_BUCKETS - 1] PROGMEM = {100, 250, 500, 1000, 2500, 5000, 10000};
+#endif
 
 /**
  * Constructor; Init the driver, communication with the module and shared
@@ -81,37 +248,35 @@ const char AT_RSP_HTTPREAD[] PROGMEM = "+HTTPREAD: "; // Expected answer HTTPREA
  */
 SIM808Driver::SIM808Driver(Stream *_stream, uint8_t _pinRst, uint16_t _internalBufferSize, uint16_t _recvBufferSize, Stream *_debugStream)
 {
-  // Store local variables
-  stream = _stream;
-  enableDebug = _debugStream != NULL;
-  debugStream = _debugStream;
-  pinReset = _pinRst;
-
-  if (pinReset != RESET_PIN_NOT_USED)
-  {
-    // Setup the reset pin and force a reset of the module
-    pinMode(pinReset, OUTPUT);
-    reset();
-  }
+  init(_stream, _pinRst, _debugStream);
 
   // Prepare internal buffers
-  if (enableDebug)
-  {
-    debugStream->print(F("SIM808Driver : Prepare internal buffer of "));
-    debugStream->print(_internalBufferSize);
-    debugStream->println(F(" bytes"));
-  }
-  internalBufferSize = _internalBufferSize;
-  internalBuffer = (char *)malloc(internalBufferSize);
+  SIM808_LOG(LOG_DEBUG, PSTR("Prepare internal buffer of %u bytes"), _internalBufferSize);
+  internalBuffer = (char *)malloc(_internalBufferSize);
+  internalBufferSize = internalBuffer != NULL ? _internalBufferSize : 0;
 
-  if (enableDebug)
-  {
-    debugStream->print(F("SIM808Driver : Prepare reception buffer of "));
-    debugStream->print(_recvBufferSize);
-    debugStream->println(F(" bytes"));
-  }
+  SIM808_LOG(LOG_DEBUG, PSTR("Prepare reception buffer of %u bytes"), _recvBufferSize);
+  recvBuffer = (char *)malloc(_recvBufferSize);
+  recvBufferSize = recvBuffer != NULL ? _recvBufferSize : 0;
+
+  if (internalBuffer == NULL || recvBuffer == NULL)
+    SIM808_LOG(LOG_ERROR, PSTR("Unable to allocate the buffers"));
+
+  ownBuffers = true;
+}
+
+/**
+ * Constructor with buffers given by the caller (no allocation, see SIM808StaticDriver)
+ */
+SIM808Driver::SIM808Driver(Stream *_stream, uint8_t _pinRst, char *_internalBuffer, uint16_t _internalBufferSize, char *_recvBuffer, uint16_t _recvBufferSize, Stream *_debugStream)
+{
+  init(_stream, _pinRst, _debugStream);
+
+  internalBuffer = _internalBuffer;
+  internalBufferSize = _internalBufferSize;
+  recvBuffer = _recvBuffer;
   recvBufferSize = _recvBufferSize;
-  recvBuffer = (char *)malloc(recvBufferSize);
+  ownBuffers = false;
 }
 
 /**
@@ -119,14 +284,41 @@ SIM808Driver::SIM808Driver(Stream *_stream, uint8_t _pinRst, uint16_t _internalB
  */
 SIM808Driver::~SIM808Driver()
 {
-  free(internalBuffer);
-  free(recvBuffer);
+  if (ownBuffers)
+  {
+    free(internalBuffer);
+    free(recvBuffer);
+  }
+}
+
+/**
+ * Common part of the constructors: store the links and reset the module
+ */
+void SIM808Driver::init(Stream *_stream, uint8_t _pinRst, Stream *_debugStream)
+{
+  // Store local variables
+  stream = _stream;
+#if SIM808_DEBUG
+  enableDebug = _debugStream != NULL;
+  debugStream = _debugStream;
+#else
+  (void)_debugStream;
+#endif
+  pinReset = _pinRst;
+
+  if (pinReset != (uint8_t)RESET_PIN_NOT_USED)
+  {
+    // Setup the reset pin and force a reset of the module
+    pinMode(pinReset, OUTPUT);
+    reset();
+  }
 }
 
 /*****************************************************************************************
  * HTTP/S FUNCTIONS
  *****************************************************************************************/
 
+#if SIM808_HTTP
 /**
  * Do HTTP/S POST to a specific URL
  */
@@ -139,154 +331,147 @@ uint16_t SIM808Driver::doPost(const char *url, const char *contentType, const ch
  * Do HTTP/S POST to a specific URL with headers
  */
 uint16_t SIM808Driver::doPost(const char *url, const char *headers, const char *contentType, const char *payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
+{
+  return doPost(url, headers, contentType, (const uint8_t *)payload, strlen(payload), clientWriteTimeoutMs, serverReadTimeoutMs);
+}
+
+/**
+ * Do HTTP/S POST to a specific URL with a binary payload of a given size
+ */
+uint16_t SIM808Driver::doPost(const char *url, const char *contentType, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
+{
+  return doPost(url, NULL, contentType, payload, payloadSize, clientWriteTimeoutMs, serverReadTimeoutMs);
+}
+
+/**
+ * Do HTTP/S POST to a specific URL with headers and a binary payload of a given size
+ * The payload may contain any byte (including NUL), only payloadSize bytes are sent
+ */
+uint16_t SIM808Driver::doPost(const char *url, const char *headers, const char *contentType, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
+{
+  uint16_t rc = startPost(url, headers, contentType, payload, payloadSize, clientWriteTimeoutMs, serverReadTimeoutMs);
+  return rc > 0 ? rc : waitHTTP();
+}
+
+/**
+ * Start a HTTP/S POST: session, parameters and payload are given to the module and the action is started
+ * Returns 0 when the answer of the server is awaited (see pollHTTP()), or the error code
+ */
+uint16_t SIM808Driver::startPost(const char *url, const char *headers, const char *contentType, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
 {
   // Cleanup the receive buffer
   initRecvBuffer();
   dataSize = 0;
+  startResult();
+
+  // Compress the payload only if it is worth it (the size is needed upfront by AT+HTTPDATA)
+  uint32_t compressedSize = 0;
+  if (enableCompression)
+  {
+    compressedSize = SIM808Gzip::compress(payload, payloadSize, NULL);
+    if (compressedSize >= payloadSize)
+    {
+      compressedSize = 0;
+    }
+    else
+    {
+      SIM808_LOG(LOG_INFO, PSTR("doPost() - Payload compressed to %lu bytes"), (unsigned long)compressedSize);
+    }
+  }
 
   // Initiate HTTP/S session with the module
-  uint16_t initRC = initiateHTTP(url, headers);
+  bearerLastActivity = millis();
+  uint16_t initRC = initiateHTTP(url, headers, compressedSize > 0 ? HTTP_HEADER_GZIP : NULL);
   if (initRC > 0)
   {
     return initRC;
   }
 
   // Define the content type
-  sendCommand_P(AT_CMD_HTTPPARA_CONTENT, contentType);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  enterStage(STAGE_PARAMETERS);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPPARA_CONTENT, contentType, AT_RSP_OK))
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doPost() - Unable to define the content type"));
-    return 702;
+    SIM808_LOG(LOG_ERROR, PSTR("doPost() - Unable to define the content type"));
+    return failResult(702);
   }
 
   // Prepare to send the payload
-  char *tmpBuf = (char *)malloc(30);
-  sprintf(tmpBuf, "AT+HTTPDATA=%d,%d", strlen(payload), clientWriteTimeoutMs);
-  sendCommand(tmpBuf);
-  free(tmpBuf);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_DOWNLOAD))
+  enterStage(STAGE_SEND);
+  char cmdBuff[32];
+  sprintf_P(cmdBuff, PSTR("AT+HTTPDATA=%u,%u"), (unsigned int)(compressedSize > 0 ? compressedSize : payloadSize), (unsigned int)clientWriteTimeoutMs);
+  sendCommand(cmdBuff);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_DOWNLOAD))
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doPost() - Unable to send payload to module"));
-    return 707;
+    SIM808_LOG(LOG_ERROR, PSTR("doPost() - Unable to send payload to module"));
+    return failResult(707);
   }
 
   // Write the payload on the module
-  if (enableDebug)
-  {
-    debugStream->print(F("SIM808Driver : doPost() - Payload to send : "));
-    debugStream->println(payload);
-  }
+  SIM808_LOG(LOG_INFO, PSTR("doPost() - Payload to send : %u bytes"), payloadSize);
 
   purgeSerial();
-  stream->write(payload);
+  if (compressedSize > 0)
+  {
+    SIM808Gzip::compress(payload, payloadSize, stream);
+  }
+  else
+  {
+    stream->write(payload, payloadSize);
+  }
+  lastResult.bytesSent = compressedSize > 0 ? compressedSize : payloadSize;
   stream->flush();
   delay(500);
 
   // Start HTTP POST action
-  sendCommand_P(AT_CMD_HTTPACTION1);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  enterStage(STAGE_ACTION);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPACTION1, NULL, AT_RSP_OK))
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doPost() - Unable to initiate POST action"));
-    return 703;
+    SIM808_LOG(LOG_ERROR, PSTR("doPost() - Unable to initiate POST action"));
+    return failResult(703);
   }
 
-  // Wait answer from the server
-  if (!readResponse(serverReadTimeoutMs))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doPost() - Server timeout"));
-    return 408;
-  }
+  startAction(true, serverReadTimeoutMs);
+  return 0;
+}
 
+/**
+ * End of a HTTP/S POST once +HTTPACTION is in the internal buffer: status, data and session termination
+ */
+uint16_t SIM808Driver::finishPost()
+{
   // Extract status information
   int16_t idxBase = strIndex(internalBuffer, "+HTTPACTION: 1,");
   if (idxBase < 0)
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doPost() - Invalid answer on HTTP POST"));
-    return 703;
+    SIM808_LOG(LOG_ERROR, PSTR("doPost() - Invalid answer on HTTP POST"));
+    return failResult(703);
   }
 
-  // Get the HTTP return code
-  uint16_t httpRC = 0;
-  httpRC += (internalBuffer[idxBase + 15] - '0') * 100;
-  httpRC += (internalBuffer[idxBase + 16] - '0') * 10;
-  httpRC += (internalBuffer[idxBase + 17] - '0') * 1;
+  // Get the HTTP return code and the position of the data size (+HTTPACTION: 1,<status>,<size>)
+  uint16_t httpRC = atoi(&internalBuffer[idxBase + 15]);
+  int16_t idxSize = strIndex(internalBuffer, ",", idxBase + 15);
+  if (httpRC < 100 || idxSize < 0)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("doPost() - Invalid answer on HTTP POST"));
+    return failResult(703);
+  }
 
-  if (enableDebug)
+  SIM808_LOG(LOG_INFO, PSTR("doPost() - HTTP status %u"), httpRC);
+
+  // 6xx are errors of the module (network, DNS, SSL...) and not of the server
+  RequestStage failedStage = STAGE_NONE;
+  if (httpRC >= 600)
   {
-    debugStream->print(F("SIM808Driver : doPost() - HTTP status "));
-    debugStream->println(httpRC);
+    lastResult.moduleError = httpRC;
+    failedStage = STAGE_ACTION;
   }
 
   if (httpRC >= 200 && httpRC <= 205)
   {
-    // Get the size of the data to receive
-    dataSize = 0;
-    for (uint16_t i = 0; (internalBuffer[idxBase + 19 + i] - '0') >= 0 && (internalBuffer[idxBase + 19 + i] - '0') <= 9; i++)
-    {
-      if (i != 0)
-      {
-        dataSize = dataSize * 10;
-      }
-      dataSize += (internalBuffer[idxBase + 19 + i] - '0');
-    }
-
-    if (enableDebug)
-    {
-      debugStream->print(F("SIM808Driver : doPost() - Data size received of "));
-      debugStream->print(dataSize);
-      debugStream->println(F(" bytes"));
-    }
-
-    // Ask for reading and detect the start of the reading...
-    sendCommand_P(AT_CMD_HTTPREAD);
-    if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_HTTPREAD, 2))
-    {
-      return 705;
-    }
-
-    // Read number of bytes defined in the dataSize
-    for (uint16_t i = 0; i < dataSize && i < recvBufferSize; i++)
-    {
-      while (!stream->available())
-        ;
-      if (stream->available())
-      {
-        // Load the next char
-        recvBuffer[i] = stream->read();
-        // If the character is CR or LF, ignore it (it's probably part of the module communication schema)
-        if ((recvBuffer[i] == '\r') || (recvBuffer[i] == '\n'))
-        {
-          i--;
-        }
-      }
-    }
-
-    if (recvBufferSize < dataSize)
-    {
-      dataSize = recvBufferSize;
-      if (enableDebug)
-      {
-        debugStream->println(F("SIM808Driver : doPost() - Buffer overflow while loading data from HTTP. Keep only first bytes..."));
-      }
-    }
-
-    // We are expecting a final OK
-    if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+    uint16_t readRC = readHTTPData(parseDataSize(idxSize + 1));
+    if (readRC > 0)
     {
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : doPost() - Invalid end of data while reading HTTP result from the module"));
-      return 705;
-    }
-
-    if (enableDebug)
-    {
-      debugStream->print(F("SIM808Driver : doPost() - Received from HTTP POST : "));
-      debugStream->println(recvBuffer);
+      return readRC;
     }
   }
 
@@ -297,7 +482,7 @@ uint16_t SIM808Driver::doPost(const char *url, const char *headers, const char *
     return termRC;
   }
 
-  return httpRC;
+  return closeResult(httpRC, failedStage);
 }
 
 /**
@@ -312,12 +497,24 @@ uint16_t SIM808Driver::doGet(const char *url, uint16_t serverReadTimeoutMs)
  * Do HTTP/S GET on a specific URL with headers
  */
 uint16_t SIM808Driver::doGet(const char *url, const char *headers, uint16_t serverReadTimeoutMs)
+{
+  uint16_t rc = startGet(url, headers, serverReadTimeoutMs);
+  return rc > 0 ? rc : waitHTTP();
+}
+
+/**
+ * Start a HTTP/S GET: session and parameters are given to the module and the action is started
+ * Returns 0 when the answer of the server is awaited (see pollHTTP()), or the error code
+ */
+uint16_t SIM808Driver::startGet(const char *url, const char *headers, uint16_t serverReadTimeoutMs)
 {
   // Cleanup the receive buffer
   initRecvBuffer();
   dataSize = 0;
+  startResult();
 
   // Initiate HTTP/S session
+  bearerLastActivity = millis();
   uint16_t initRC = initiateHTTP(url, headers);
   if (initRC > 0)
   {
@@ -325,108 +522,66 @@ uint16_t SIM808Driver::doGet(const char *url, const char *headers, uint16_t serv
   }
 
   // Start HTTP GET action
-  sendCommand_P(AT_CMD_HTTPACTION0);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  enterStage(STAGE_ACTION);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPACTION0, NULL, AT_RSP_OK))
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doGet() - Unable to initiate GET action"));
-    return 703;
+    SIM808_LOG(LOG_ERROR, PSTR("doGet() - Unable to initiate GET action"));
+    return failResult(703);
   }
 
-  // Wait answer from the server
-  if (!readResponse(serverReadTimeoutMs))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doGet() - Server timeout"));
-    return 408;
-  }
+  startAction(false, serverReadTimeoutMs);
+  return 0;
+}
 
+/**
+ * End of a HTTP/S GET once +HTTPACTION is in the internal buffer: status, headers, data and session
+ * termination
+ */
+uint16_t SIM808Driver::finishGet()
+{
   // Extract status information
   int16_t idxBase = strIndex(internalBuffer, "+HTTPACTION: 0,");
   if (idxBase < 0)
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : doGet() - Invalid answer on HTTP GET"));
-    return 703;
+    SIM808_LOG(LOG_ERROR, PSTR("doGet() - Invalid answer on HTTP GET"));
+    return failResult(703);
   }
 
-  // Get the HTTP return code
-  uint16_t httpRC = 0;
-  httpRC += (internalBuffer[idxBase + 15] - '0') * 100;
-  httpRC += (internalBuffer[idxBase + 16] - '0') * 10;
-  httpRC += (internalBuffer[idxBase + 17] - '0') * 1;
-
-  if (enableDebug)
+  // Get the HTTP return code and the position of the data size (+HTTPACTION: 0,<status>,<size>)
+  uint16_t httpRC = atoi(&internalBuffer[idxBase + 15]);
+  int16_t idxSize = strIndex(internalBuffer, ",", idxBase + 15);
+  if (httpRC < 100 || idxSize < 0)
   {
-    debugStream->print(F("SIM808Driver : doGet() - HTTP status "));
-    debugStream->println(httpRC);
+    SIM808_LOG(LOG_ERROR, PSTR("doGet() - Invalid answer on HTTP GET"));
+    return failResult(703);
   }
 
-  if (httpRC == 200)
-  {
-    // Get the size of the data to receive
-    dataSize = 0;
-    for (uint16_t i = 0; (internalBuffer[idxBase + 19 + i] - '0') >= 0 && (internalBuffer[idxBase + 19 + i] - '0') <= 9; i++)
-    {
-      if (i != 0)
-      {
-        dataSize = dataSize * 10;
-      }
-      dataSize += (internalBuffer[idxBase + 19 + i] - '0');
-    }
-
-    if (enableDebug)
-    {
-      debugStream->print(F("SIM808Driver : doGet() - Data size received of "));
-      debugStream->print(dataSize);
-      debugStream->println(F(" bytes"));
-    }
-
-    // Ask for reading and detect the start of the reading...
-    sendCommand_P(AT_CMD_HTTPREAD);
-    if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_HTTPREAD, 2))
-    {
-      return 705;
-    }
+  SIM808_LOG(LOG_INFO, PSTR("doGet() - HTTP status %u"), httpRC);
 
-    // Read number of bytes defined in the dataSize
-    for (uint16_t i = 0; i < dataSize && i < recvBufferSize; i++)
-    {
-      while (!stream->available())
-        ;
-      if (stream->available())
-      {
-        // Load the next char
-        recvBuffer[i] = stream->read();
-        // If the character is CR or LF, ignore it (it's probably part of the module communication schema)
-        if ((recvBuffer[i] == '\r') || (recvBuffer[i] == '\n'))
-        {
-          i--;
-        }
-      }
-    }
+  // 6xx are errors of the module (network, DNS, SSL...) and not of the server
+  RequestStage failedStage = STAGE_NONE;
+  if (httpRC >= 600)
+  {
+    lastResult.moduleError = httpRC;
+    failedStage = STAGE_ACTION;
+  }
 
-    if (recvBufferSize < dataSize)
-    {
-      dataSize = recvBufferSize;
-      if (enableDebug)
-      {
-        debugStream->println(F("SIM808Driver : doGet() - Buffer overflow while loading data from HTTP. Keep only first bytes..."));
-      }
-    }
+  // The size is read before the next commands use the internal buffer
+  uint32_t size = parseDataSize(idxSize + 1);
 
-    // We are expecting a final OK
-    if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-    {
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : doGet() - Invalid end of data while reading HTTP result from the module"));
-      return 705;
-    }
+  // Headers of the answer (validators of a cached body, range...), not needed to complete the request
+  if (headerOutput != NULL && httpRC < 600 && !readHTTPHead())
+  {
+    SIM808_LOG(LOG_WARNING, PSTR("doGet() - Unable to read the headers of the answer"));
+  }
 
-    if (enableDebug)
+  // Full body or part of it (range request)
+  if (httpRC == 200 || httpRC == 206)
+  {
+    uint16_t readRC = readHTTPData(size);
+    if (readRC > 0)
     {
-      debugStream->print(F("SIM808Driver : doGet() - Received from HTTP GET : "));
-      debugStream->println(recvBuffer);
+      return readRC;
     }
   }
 
@@ -437,836 +592,3054 @@ uint16_t SIM808Driver::doGet(const char *url, const char *headers, uint16_t serv
     return termRC;
   }
 
-  return httpRC;
+  return closeResult(httpRC, failedStage);
 }
 
 /**
- * Meta method to initiate the HTTP/S session on the module
+ * Wait for the answer of the server to the action started (the answer of the server is read without
+ * waiting by pollHTTP())
  */
-uint16_t SIM808Driver::initiateHTTP(const char *url, const char *headers)
+void SIM808Driver::startAction(bool post, uint16_t serverReadTimeoutMs)
 {
-  // Init HTTP connection
-  sendCommand_P(AT_CMD_HTTPINIT);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : initiateHTTP() - Unable to init HTTP"));
-    return 701;
-  }
-
-  // Use the GPRS bearer
-  sendCommand_P(AT_CMD_HTTPPARA_CID);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : initiateHTTP() - Unable to define bearer"));
-    return 702;
-  }
-
-  // Define URL to look for
-  sendCommand_P(AT_CMD_HTTPPARA_URL, url);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : initiateHTTP() - Unable to define the URL"));
-    return 702;
-  }
+  httpPending = true;
+  httpPendingPost = post;
+  httpActionStart = millis();
+  httpActionTimeout = serverReadTimeoutMs;
+}
 
-  // Set Headers
-  if (headers != NULL)
+/**
+ * Check if the answer of the server to the action started by startGet()/startPost() was received, without
+ * waiting. The other lines received meanwhile are kept for readURC()
+ * Returns 0 while the answer is awaited (or no request is started), then the code of doGet()/doPost()
+ */
+uint16_t SIM808Driver::pollHTTP()
+{
+  if (!httpPending)
   {
-    sendCommand_P(AT_CMD_HTTPPARA_USERDATA, headers);
-    if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-    {
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : initiateHTTP() - Unable to define Headers"));
-      return 702;
-    }
+    return 0;
   }
 
-  // Check if the firmware support HTTPSSL command
-  bool isSupportSSL = false;
-  char *version = getVersion();
-  int16_t rIdx = strIndex(version, "R");
-  if (rIdx > 0)
+  while (stream->available())
   {
-    uint8_t releaseInt = (version[rIdx + 1] - '0') * 10 + (version[rIdx + 2] - '0');
-
-    // The release should be greater or equals to 14 to support SSL stack
-    if (releaseInt >= 14)
+    if (!urcPut(stream->read()))
     {
-      isSupportSSL = true;
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : initiateHTTP() - Support of SSL enabled"));
+      continue;
     }
-    else
+    if (strncmp_P(urcBuffer, PSTR("+HTTPACTION: "), 13) == 0)
     {
-      isSupportSSL = false;
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : initiateHTTP() - Support of SSL disabled (SIM808 firware below R14)"));
+      // The rest of the request reads the answer from the internal buffer
+      httpPending = false;
+      strncpy(internalBuffer, urcBuffer, internalBufferSize - 1);
+      internalBuffer[internalBufferSize - 1] = 0;
+      SIM808_LOG(LOG_DEBUG, PSTR("Receive \"%s\""), internalBuffer);
+      return httpPendingPost ? finishPost() : finishGet();
     }
+    queueURC();
   }
 
-  // Send HTTPSSL command only if the version is greater or equals to 14
-  if (isSupportSSL)
+  if (millis() - httpActionStart > httpActionTimeout)
   {
-    // HTTP or HTTPS
-    if (strIndex(url, "https://") == 0)
-    {
-      sendCommand_P(AT_CMD_HTTPSSL_Y);
-      if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-      {
-        if (enableDebug)
-          debugStream->println(F("SIM808Driver : initiateHTTP() - Unable to switch to HTTPS"));
-        return 702;
-      }
-    }
-    else
-    {
-      sendCommand_P(AT_CMD_HTTPSSL_N);
-      if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-      {
-        if (enableDebug)
-          debugStream->println(F("SIM808Driver : initiateHTTP() - Unable to switch to HTTP"));
-        return 702;
-      }
-    }
+    httpPending = false;
+#if SIM808_METRICS
+    metrics.timeouts++;
+#endif
+    SIM808_LOG(LOG_ERROR, PSTR("pollHTTP() - Server timeout"));
+    return failResult(408);
   }
-
   return 0;
 }
 
 /**
- * Meta method to terminate the HTTP/S session on the module
+ * True while the answer of the server to startGet()/startPost() is awaited
  */
-uint16_t SIM808Driver::terminateHTTP()
+bool SIM808Driver::isHTTPPending()
 {
-  // Close HTTP connection
-  sendCommand_P(AT_CMD_HTTPTERM);
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : terminateHTTP() - Unable to close HTTP session"));
-    return 706;
-  }
-  return 0;
+  return httpPending;
 }
 
 /**
- * Return the size of data received after the last successful HTTP connection
+ * Wait for the answer of the server to the action started (blocking doGet()/doPost())
  */
-uint16_t SIM808Driver::getDataSizeReceived()
+uint16_t SIM808Driver::waitHTTP()
 {
-  return dataSize;
+  uint16_t rc = 0;
+  while (rc == 0 && httpPending)
+  {
+    rc = pollHTTP();
+  }
+  return rc;
 }
 
 /**
- * Return the buffer of data received after the last successful HTTP connection
+ * Size of the data announced by +HTTPACTION, sizeIdx is the position of the size in the internal buffer
+ * The body may be larger than 64KB when it is written on a data output
  */
-char *SIM808Driver::getDataReceived()
-{
-  return recvBuffer;
-}
-
-/*****************************************************************************************
- * GNSS FUNCTIONS
- *****************************************************************************************/
-
-/**
- * Power On GNSS on the module
-*/
-bool SIM808Driver::powerOnGNSS()
+uint32_t SIM808Driver::parseDataSize(int16_t sizeIdx)
 {
-  // Send Power on GNSS cmd
-  sendCommand_P(AT_CMD_CGNSPWR1);
-
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  uint32_t size = 0;
+  for (uint16_t i = 0; (internalBuffer[sizeIdx + i] - '0') >= 0 && (internalBuffer[sizeIdx + i] - '0') <= 9; i++)
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : powerOnGNSS() - Unable to Power on GNSS"));
-    return false;
+    size = size * 10 + (internalBuffer[sizeIdx + i] - '0');
   }
-  return true;
+  return size;
 }
 
 /**
- * Power Off GNSS on the module
-*/
-bool SIM808Driver::powerOffGNSS()
+ * Meta method to read the HTTP/S data announced by +HTTPACTION into the reception buffer
+ * The data is read byte per byte without any filtering to keep binary payloads intact
+ * With a data output, the bytes are written on it as they arrive and the reception buffer is left empty
+ */
+uint16_t SIM808Driver::readHTTPData(uint32_t size)
 {
-  // Send Power off GNSS cmd
-  sendCommand_P(AT_CMD_CGNSPWR0);
+  enterStage(STAGE_READ);
+  dataSize = size;
 
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  SIM808_LOG(LOG_INFO, PSTR("readHTTPData() - Data size received of %lu bytes"), (unsigned long)dataSize);
+
+  // Ask for reading and detect the start of the reading...
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPREAD, NULL, AT_RSP_HTTPREAD, 2))
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : powerOnGNSS() - Unable to Power off GNSS"));
-    return false;
+    return failResult(705);
   }
-  return true;
-}
 
-/**
- *  Get power status of GNSS
-*/
-SIM808Driver::GnssStatus SIM808Driver::getGnssPowerStatus()
-{
-  sendCommand_P(AT_CMD_CGNSPWR_TEST);
-  if (readResponse(DEFAULT_TIMEOUT))
+  // Read number of bytes defined in the dataSize, drop what does not fit in the buffer
+  // The last byte of the buffer is kept for the end of string of getDataReceived()
+  uint16_t storeSize = recvBufferSize > 0 ? recvBufferSize - 1 : 0;
+  uint32_t timerStart = millis();
+  for (uint32_t i = 0; i < dataSize;)
   {
-    // Check if there is an error
-    int16_t errIdx = strIndex(internalBuffer, "ERROR");
-    if (errIdx > 0)
+    if (stream->available())
     {
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : getGnssPowerStatus() - Error on getting GNSS Power"));
-      return GNSS_ERROR;
+      char c = stream->read();
+      if (dataOutput != NULL)
+      {
+        dataOutput->write((uint8_t)c);
+      }
+      else if (i < storeSize)
+      {
+        recvBuffer[i] = c;
+      }
+      i++;
+      timerStart = millis();
+    }
+    else if (millis() - timerStart > DEFAULT_TIMEOUT)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("readHTTPData() - Timeout while loading data from HTTP"));
+      return failResult(705);
     }
+  }
 
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "+CGNSPWR: ");
-    char value = internalBuffer[idx + 10];
+  lastResult.bytesReceived = dataSize;
+  if (dataOutput == NULL && storeSize < dataSize)
+  {
+    dataSize = storeSize;
+#if SIM808_METRICS
+    metrics.overflows++;
+#endif
+    SIM808_LOG(LOG_WARNING, PSTR("readHTTPData() - Buffer overflow while loading data from HTTP. Keep only first bytes..."));
+  }
 
-    if (value == '1')
-      return GNSS_POWER_ON;
-    else
-      return GNSS_POWER_OFF;
+  // End of string for getDataReceived() (the buffer may contain older data)
+  if (recvBufferSize > 0)
+  {
+    recvBuffer[dataOutput != NULL ? 0 : dataSize] = 0;
   }
-  if (enableDebug)
-    debugStream->println(F("SIM808Driver : getGnssPowerStatus() - Unable to get power status of GNSS"));
-  return GNSS_ERROR;
+
+  // We are expecting a final OK
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("readHTTPData() - Invalid end of data while reading HTTP result from the module"));
+    return failResult(705);
+  }
+
+  SIM808_LOG(LOG_DEBUG, PSTR("readHTTPData() - Received : %.*s"), (int)dataSize, recvBuffer);
+
+  return 0;
 }
 
+#if SIM808_FS
 /**
- * Turn on navigation data URC report, and report every GNSS FIX
-*/
-bool SIM808Driver::attachGNSS(uint8_t fix)
+ * Read a range of the HTTP/S data in the reception buffer, returns the number of bytes read (0 on error)
+ */
+uint16_t SIM808Driver::readHTTPChunk(uint32_t start, uint16_t size)
 {
-  // Check if GNSS is On
-  if (!getGnssPowerStatus())
+  if (size == 0 || size > recvBufferSize)
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : attachGNSS() - GNSS Power is off"));
-    return false;
+    return 0;
   }
 
-  char buff[3];
-  // Send Power off GNSS cmd
-  sendCommand_P(AT_CMD_CGNSURC, itoa(fix, buff, 10));
+  // Answer: +HTTPREAD: <size read> then the data
+  char cmdBuff[36];
+  sprintf_P(cmdBuff, PSTR("AT+HTTPREAD=%lu,%u"), (unsigned long)start, size);
+  sendCommand(cmdBuff);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_HTTPREAD, 2))
+  {
+    return 0;
+  }
+  int16_t idx = strIndex(internalBuffer, "+HTTPREAD: ");
+  if (idx < 0)
+  {
+    return 0;
+  }
+  uint16_t readSize = atoi(&internalBuffer[idx + 11]);
+  if (readSize > size)
+  {
+    return 0;
+  }
+
+  // Read the data as-is (binary)
+  uint32_t timerStart = millis();
+  for (uint16_t i = 0; i < readSize;)
+  {
+    if (stream->available())
+    {
+      recvBuffer[i++] = stream->read();
+      timerStart = millis();
+    }
+    else if (millis() - timerStart > DEFAULT_TIMEOUT)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("readHTTPChunk() - Timeout while loading data from HTTP"));
+      return 0;
+    }
+  }
 
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  // We are expecting a final OK
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : attachGNSS() - Unable to attach GNSS"));
-    return false;
+    SIM808_LOG(LOG_ERROR, PSTR("readHTTPChunk() - Invalid end of data while reading HTTP result from the module"));
+    return 0;
   }
-  return true;
+  return readSize;
 }
+#endif
 
 /**
- * Turn off GNSS navigation, GEO-fences and speed alarm URC report 
-*/
-bool SIM808Driver::detachGNSS()
+ * Read the headers of the HTTP/S answer with AT+HTTPHEAD and write them on the header output
+ */
+bool SIM808Driver::readHTTPHead()
 {
-  // Send Power off GNSS cmd
-  sendCommand_P(AT_CMD_CGNSURC, "0");
+  // Answer: +HTTPHEAD: <size> then the headers
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPHEAD, NULL, AT_RSP_HTTPHEAD, 2))
+  {
+    return false;
+  }
 
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK))
+  int16_t idx = strIndex(internalBuffer, "+HTTPHEAD: ");
+  if (idx < 0)
   {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : detachGNSS() - Unable to Power off GNSS"));
     return false;
   }
-  return true;
+  uint16_t size = atoi(&internalBuffer[idx + 11]);
+
+  SIM808_LOG(LOG_DEBUG, PSTR("readHTTPHead() - Headers of %u bytes"), size);
+
+  uint32_t timerStart = millis();
+  for (uint16_t i = 0; i < size;)
+  {
+    if (stream->available())
+    {
+      headerOutput->write((uint8_t)stream->read());
+      i++;
+      timerStart = millis();
+    }
+    else if (millis() - timerStart > DEFAULT_TIMEOUT)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("readHTTPHead() - Timeout while loading the headers"));
+      return false;
+    }
+  }
+
+  return readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK);
 }
 
 /**
- * Turn off GNSS navigation, GEO-fences and speed alarm URC report 
-*/
-SIM808Driver::GnssStatus SIM808Driver::getGnssInfo(SIM808Driver::GnssInfo *gnssInfo)
+ * Do HTTP/S GET on a URL built from a template in PROGMEM (headers template optional)
+ */
+uint16_t SIM808Driver::doGet_P(const char *urlTemplate, const char *headersTemplate, const char *const *values, uint8_t valueCount, uint16_t serverReadTimeoutMs)
 {
-  // get Info
-  sendCommand_P(AT_CMD_CGNSINF);
+  parameterTemplate = true;
+  templateValues = values;
+  templateValueCount = valueCount;
+  uint16_t rc = doGet(urlTemplate, headersTemplate, serverReadTimeoutMs);
+  parameterTemplate = false;
+  return rc;
+}
 
-  if (!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_CGNSINF, 4U))
-  {
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : getGnssInfo() - Unable to get GNSS Info"));
-    return GNSS_ERROR;
-  }
+/**
+ * Do HTTP/S POST on a URL built from a template in PROGMEM (headers template optional, content type in PROGMEM)
+ */
+uint16_t SIM808Driver::doPost_P(const char *urlTemplate, const char *headersTemplate, const char *contentType, const char *const *values, uint8_t valueCount, const char *payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
+{
+  return doPost_P(urlTemplate, headersTemplate, contentType, values, valueCount, (const uint8_t *)payload, strlen(payload), clientWriteTimeoutMs, serverReadTimeoutMs);
+}
 
-  return parseGnssData(gnssInfo);
+/**
+ * Do HTTP/S POST of a binary payload on a URL built from a template in PROGMEM
+ */
+uint16_t SIM808Driver::doPost_P(const char *urlTemplate, const char *headersTemplate, const char *contentType, const char *const *values, uint8_t valueCount, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
+{
+  parameterTemplate = true;
+  templateValues = values;
+  templateValueCount = valueCount;
+  uint16_t rc = doPost(urlTemplate, headersTemplate, contentType, payload, payloadSize, clientWriteTimeoutMs, serverReadTimeoutMs);
+  parameterTemplate = false;
+  return rc;
 }
 
-SIM808Driver::GnssStatus SIM808Driver::parseGnssData(SIM808Driver::GnssInfo *gnssInfo)
+/**
+ * Meta method to initiate the HTTP/S session on the module
+ */
+uint16_t SIM808Driver::initiateHTTP(const char *url, const char *headers, const char *extraHeader_P)
 {
-  // Check if get called after AT+CGNSINF
-  int16_t idx = strIndex(internalBuffer, "+CGNSINF: ");
-  // Otherwise check if get called on AT+CGNSURC UAC report
-  if (idx == -1)
-    idx = strIndex(internalBuffer, "+UGNSINF: ");
-  if (idx == -1)
-    return GNSS_ERROR;
+  // Init HTTP connection
+  enterStage(STAGE_INIT);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPINIT, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to init HTTP"));
+    return failResult(701);
+  }
 
-  // Extract power status of GNSS
-  char power = internalBuffer[idx + 10];
-  // Extract fix status
-  char fix = internalBuffer[idx + 12];
+  // Use the GPRS bearer
+  enterStage(STAGE_PARAMETERS);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPPARA_CID, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to define bearer"));
+    return failResult(702);
+  }
 
-  if (enableDebug)
+  // Define URL to look for
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPPARA_URL, url, AT_RSP_OK))
   {
-    debugStream->println(F("SIM808Driver : parseGnssData() - power:"));
-    debugStream->println(power);
-    debugStream->println(F("SIM808Driver : parseGnssData() - fix:"));
-    debugStream->println(fix);
+    SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to define the URL"));
+    return failResult(702);
   }
-  if (power == '1')
-    if (fix == '1')
+
+  // Set Headers (extra header from PROGMEM is appended to the ones of the user)
+  if (extraHeader_P != NULL)
+  {
+    // Streamed in the command line to avoid concatenating the headers in memory
+    txBegin();
+    txAppend_P(AT_CMD_HTTPPARA_USERDATA);
+    loadPolicy(txBuffer);
+    SIM808_LOG(LOG_DEBUG, PSTR("Send USERDATA with extra header"));
+
+    txPut('"');
+    if (headers != NULL)
+    {
+      txAppendParameter(headers);
+      txAppend("\\r\\n");
+    }
+    txAppend_P(extraHeader_P);
+    txPut('"');
+    txEnd();
+    if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to define Headers"));
+      return failResult(702);
+    }
+  }
+  else if (headers != NULL)
+  {
+    if (!sendCommandCheckAnswer_P(AT_CMD_HTTPPARA_USERDATA, headers, AT_RSP_OK))
     {
-      char *tok;
-      uint8_t i = 0;
-      float info[15];
+      SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to define Headers"));
+      return failResult(702);
+    }
+  }
 
-      int16_t idxEnd = strIndex(internalBuffer, "\r\n\r\nOK");
+#if SIM808_SSL
+  // Check once if the firmware support HTTPSSL command
+  enterStage(STAGE_SSL);
+  if (sslSupport == 0)
+  {
+    char *version = getVersion();
+    int16_t rIdx = strIndex(version, "R");
+    if (rIdx > 0)
+    {
+      uint8_t releaseInt = (version[rIdx + 1] - '0') * 10 + (version[rIdx + 2] - '0');
 
-      // Store it on the buffer
-      char *buffer = (char *)malloc(internalBufferSize);
-      for (uint16_t i = 0; i < idxEnd - idx - 14; i++)
+      // The release should be greater or equals to 14 to support SSL stack
+      if (releaseInt >= 14)
       {
-        buffer[i] = internalBuffer[idx + 14 + i];
+        sslSupport = 1;
+        SIM808_LOG(LOG_INFO, PSTR("initiateHTTP() - Support of SSL enabled"));
       }
-
-      // Split parameters by ',' and save in info[]
-      while ((tok = strtok_r(buffer, ",", &buffer)) != NULL)
+      else
       {
-        switch (i)
-        {
-        case 0:
-          strcpy_P(gnssInfo->utc, tok); // todo: fix join next tok
-          break;
-        case 1:
-          strcpy_P(gnssInfo->latitude, tok);
-          break;
-        case 2:
-          strcpy_P(gnssInfo->longitude, tok);
-          break;
-        case 6:
-          gnssInfo->fixMode = atoi(tok);
-          break;
-        case 10:
-          gnssInfo->gpsSatInView = atoi(tok);
-          break;
-        case 11:
-          gnssInfo->gnssSatUsed = atoi(tok);
-          break;
-        default:
-          info[i] = atof(tok);
-          break;
-        }
-
-        i++;
+        sslSupport = 2;
+        SIM808_LOG(LOG_INFO, PSTR("initiateHTTP() - Support of SSL disabled (SIM808 firware below R14)"));
       }
+    }
+  }
 
-      gnssInfo->altitude = info[3];
-      gnssInfo->speed = info[4];
-      gnssInfo->heading = info[5];
-      gnssInfo->HDOP = info[7];
-      gnssInfo->PDOP = info[8];
-      gnssInfo->VDOP = info[9];
-
-      return GNSS_FIX;
+  // Send HTTPSSL command only if the version is greater or equals to 14
+  if (sslSupport == 1)
+  {
+    // HTTP or HTTPS (the URL is in PROGMEM for a template)
+    bool https = parameterTemplate ? strncmp_P("https://", url, 8) == 0 : strIndex(url, "https://") == 0;
+    if (https)
+    {
+      if (!sendCommandCheckAnswer_P(AT_CMD_HTTPSSL_Y, NULL, AT_RSP_OK))
+      {
+        SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to switch to HTTPS"));
+        return failResult(702);
+      }
+      lastResult.secure = true;
     }
     else
     {
-      gnssInfo->fixMode = 0;
-      return GNSS_NOT_FIX;
+      if (!sendCommandCheckAnswer_P(AT_CMD_HTTPSSL_N, NULL, AT_RSP_OK))
+      {
+        SIM808_LOG(LOG_ERROR, PSTR("initiateHTTP() - Unable to switch to HTTP"));
+        return failResult(702);
+      }
     }
-  else if (enableDebug)
-    debugStream->println(F("SIM808Driver : getGnssInfo() - Unable to get GNSS Info, GNSS Power is off"));
-  return GNSS_POWER_OFF;
-}
+  }
+#endif // SIM808_SSL
 
-/*****************************************************************************************
- * BASE CONTROLL & CHECK FUNCTIONS
- *****************************************************************************************/
+  return 0;
+}
 
 /**
- * Force a reset of the module
+ * Meta method to terminate the HTTP/S session on the module
  */
-void SIM808Driver::reset()
+uint16_t SIM808Driver::terminateHTTP()
 {
-  if (pinReset != RESET_PIN_NOT_USED)
+  // Close HTTP connection
+  enterStage(STAGE_TERMINATE);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPTERM, NULL, AT_RSP_OK))
   {
-    // Some logging
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : Reset"));
-
-    // Reset the device
-    digitalWrite(pinReset, HIGH);
-    delay(500);
-    digitalWrite(pinReset, LOW);
-    delay(500);
-    digitalWrite(pinReset, HIGH);
-    delay(1000);
+    SIM808_LOG(LOG_ERROR, PSTR("terminateHTTP() - Unable to close HTTP session"));
+    return failResult(706);
   }
-  else
-  {
-    // Some logging
-    if (enableDebug)
-      debugStream->println(F("SIM808Driver : Reset requested but reset pin undefined"));
+  return 0;
+}
 
-    // Set power to minimum and back it to normal for soft ressetting
-    if (setPowerMode(POW_MINIMUM))
-    {
-      delay(1000);
-      setPowerMode(POW_NORMAL);
-    }
-  }
+#endif // SIM808_HTTP
 
-  // Purge the serial
-  stream->flush();
-  while (stream->available())
-  {
-    stream->read();
-  }
+/**
+ * Return the size of data received after the last successful HTTP connection
+ * (with a data output, the size of the whole body, which may be larger than 64KB)
+ */
+uint32_t SIM808Driver::getDataSizeReceived()
+{
+  return dataSize;
 }
 
 /**
- * Status function: Check if AT command works
+ * Return the buffer of data received after the last successful HTTP connection
  */
-bool SIM808Driver::isReady()
+char *SIM808Driver::getDataReceived()
 {
-  sendCommand_P(AT_CMD_BASE);
-  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+  return recvBuffer;
 }
 
 /**
- * Status function: Check the power mode
+ * Return the raw bytes received after the last successful HTTP connection
+ * Use getDataSizeReceived() for the length, the data may contain NUL bytes
  */
-SIM808Driver::PowerMode SIM808Driver::getPowerMode()
+const uint8_t *SIM808Driver::getRawDataReceived()
 {
-  sendCommand_P(AT_CMD_CFUN_TEST);
-  if (readResponse(DEFAULT_TIMEOUT))
-  {
-    // Check if there is an error
-    int16_t errIdx = strIndex(internalBuffer, "ERROR");
-    if (errIdx > 0)
-    {
-      return POW_ERROR;
-    }
-
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "+CFUN: ");
-    char value = internalBuffer[idx + 7];
-
-    // Prepare the clear output
-    switch (value)
-    {
-    case '0':
-      return POW_MINIMUM;
-    case '1':
-      return POW_NORMAL;
-    case '4':
-      return POW_SLEEP;
-    default:
-      return POW_UNKNOWN;
-    }
-  }
-  return POW_ERROR;
+  return (const uint8_t *)recvBuffer;
 }
 
+#if SIM808_HTTP
 /**
- * Status function: Get version of the module
+ * Enable/disable the gzip compression of the POST payloads
+ * When enabled, the payload is sent compressed with "Content-Encoding: gzip" if it is smaller
  */
-char *SIM808Driver::getVersion()
+void SIM808Driver::setPayloadCompression(bool enable)
 {
-  sendCommand_P(AT_CMD_ATI);
-  if (readResponse(DEFAULT_TIMEOUT))
-  {
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "SIM");
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx + 1);
+  enableCompression = enable;
+}
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for (uint16_t i = 0; i < idxEnd - idx; i++)
-    {
-      recvBuffer[i] = internalBuffer[idx + i];
-    }
-    return getDataReceived();
-  }
-  else
-  {
-    return NULL;
-  }
+/**
+ * Write the headers of the answers to doGet on an output (read with AT+HTTPHEAD, NULL to skip them)
+ */
+void SIM808Driver::setHeaderOutput(Print *output)
+{
+  headerOutput = output;
 }
 
 /**
- * Status function: Get firmware version
+ * Write the data received on an output instead of the reception buffer (NULL to use the reception buffer)
  */
-char *SIM808Driver::getFirmware()
+void SIM808Driver::setDataOutput(Print *output)
 {
-  sendCommand_P(AT_CMD_GMR);
-  if (readResponse(DEFAULT_TIMEOUT))
-  {
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "AT+GMR") + 9;
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx + 1);
+  dataOutput = output;
+}
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for (uint16_t i = 0; i < idxEnd - idx; i++)
+#if SIM808_SSL
+/**
+ * Set an option of the SSL stack of the module (kept until the module is restarted)
+ */
+bool SIM808Driver::setSSLOption(SSLOption option, bool enable)
+{
+  char cmdBuff[20];
+  sprintf_P(cmdBuff, PSTR("AT+SSLOPT=%u,%u"), option, enable ? 1 : 0);
+  sendCommand(cmdBuff);
+  return readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK);
+}
+
+#if SIM808_FS
+/**
+ * Store a certificate in a file of the module and load it in the SSL stack
+ * The CRC32 of the certificate is kept in a second file (<name>.crc): when it has not changed, the
+ * certificate is not written again (upload time and wear of the flash)
+ */
+bool SIM808Driver::setupSSLCertificate(const char *name, const uint8_t *certificate, uint16_t size, const char *password)
+{
+  char fingerprintName[32];
+  if (strlen(name) + 5 > sizeof(fingerprintName))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("setupSSLCertificate() - Name of the certificate too long"));
+    return false;
+  }
+  sprintf_P(fingerprintName, PSTR("%s.crc"), name);
+
+  char fingerprint[9];
+  sprintf_P(fingerprint, PSTR("%08lX"), (unsigned long)SIM808Gzip::crc32(0, certificate, size));
+
+  // Same size and same fingerprint: the certificate is already on the module
+  bool stored = false;
+  if (fileSize(name) == size && fileSize(fingerprintName) == 8)
+  {
+    // Answer: the 8 characters of the fingerprint then OK
+    sendFileCommand_P(AT_CMD_FSREAD, fingerprintName, ",0,8,0");
+    stored = readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK, 3) && strIndex(internalBuffer, fingerprint) >= 0;
+  }
+
+  if (stored)
+  {
+    SIM808_LOG(LOG_INFO, PSTR("setupSSLCertificate() - Certificate %s already stored"), fingerprint);
+  }
+  else
+  {
+    // The fingerprint is removed first, so an interrupted upload is done again
+    SIM808_LOG(LOG_INFO, PSTR("setupSSLCertificate() - Store the certificate %s"), fingerprint);
+    fileDelete(fingerprintName);
+    if (!fileWrite(name, certificate, size, false) || !fileWrite(fingerprintName, (const uint8_t *)fingerprint, 8, false))
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("setupSSLCertificate() - Unable to store the certificate"));
+      return false;
+    }
+  }
+
+  // AT+SSLSETCERT="<path>"[,"<password>"] then +SSLSETCERT: 0 when loaded
+  txBegin();
+  txAppend_P(AT_CMD_SSLSETCERT);
+  loadPolicy(txBuffer);
+  SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s\"%s\"\""), txBuffer, name);
+  txPut('"');
+  txAppend_P(FS_PATH);
+  txAppend(name);
+  txPut('"');
+  if (password != NULL)
+  {
+    txAppend_P(PSTR(",\""));
+    txAppend(password);
+    txPut('"');
+  }
+  txEnd();
+
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK) || !readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_SSLSETCERT))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("setupSSLCertificate() - Certificate refused by the module"));
+    return false;
+  }
+  return true;
+}
+#endif // SIM808_FS
+#endif // SIM808_SSL
+
+#endif // SIM808_HTTP
+
+#if SIM808_TCPIP
+/*****************************************************************************************
+ * TCP/UDP SOCKET FUNCTIONS
+ *****************************************************************************************/
+
+/**
+ * Bring up the TCP/IP stack of the module (independent from the HTTP bearer)
+ * Multi-connection mode, manual reception (CIPRXGET) and quick send (CIPQSEND) are used
+ */
+bool SIM808Driver::startTCPIP(const char *apn)
+{
+  // Reset the stack to a known state
+  if (!sendCommandCheckAnswer_P(AT_CMD_CIPSHUT, NULL, AT_RSP_SHUT_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to shut the TCP/IP stack"));
+    return false;
+  }
+
+  if (!sendCommandCheckAnswer_P(AT_CMD_CIPMUX1, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to enable multi-connection mode"));
+    return false;
+  }
+
+  if (!sendCommandCheckAnswer_P(AT_CMD_CIPRXGET1, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to enable manual reception"));
+    return false;
+  }
+
+  if (!sendCommandCheckAnswer_P(AT_CMD_CIPQSEND1, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to enable quick send mode"));
+    return false;
+  }
+
+  if (!sendCommandCheckAnswer_P(AT_CMD_CSTT, apn, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to define the APN"));
+    return false;
+  }
+
+  // Timout is max 85 seconds according to SIM808 specifications (see the policy table)
+  if (!sendCommandCheckAnswer_P(AT_CMD_CIICR, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to bring up the wireless connection"));
+    return false;
+  }
+
+  // The local IP is the only answer (no OK), the stack is not usable before this query
+  sendCommand_P(AT_CMD_CIFSR);
+  if (!readResponse(POLICY_TIMEOUT) || strIndex(internalBuffer, ".") < 0)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startTCPIP() - Unable to get the local IP"));
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Close all the connections and shut the TCP/IP stack
+ */
+bool SIM808Driver::stopTCPIP()
+{
+  return sendCommandCheckAnswer_P(AT_CMD_CIPSHUT, NULL, AT_RSP_SHUT_OK);
+}
+
+/**
+ * Open a TCP or UDP connection on the link number mux (0 to SOCKET_MAX_CONNECTIONS - 1)
+ */
+bool SIM808Driver::socketOpen(uint8_t mux, SocketType type, const char *host, uint16_t port, uint32_t connectTimeoutMs)
+{
+  if (mux >= SOCKET_MAX_CONNECTIONS)
+  {
+    return false;
+  }
+  startResult();
+  enterStage(STAGE_ACTION);
+
+  // The command is built in the internal buffer (cleaned by the reading of the answer)
+  snprintf_P(internalBuffer, internalBufferSize, PSTR("AT+CIPSTART=%u,\"%s\",\"%s\",\"%u\""), mux, type == SOCKET_UDP ? "UDP" : "TCP", host, port);
+  sendCommand(internalBuffer);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("socketOpen() - Connection refused by the module"));
+    failResult(0);
+    return false;
+  }
+
+  // Then wait for "<mux>, CONNECT OK" (or ALREADY CONNECT), "<mux>, CONNECT FAIL" otherwise
+  if (!readResponse(connectTimeoutMs))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("socketOpen() - Connection timeout"));
+    failResult(0);
+    return false;
+  }
+  if (strIndex(internalBuffer, "CONNECT OK") < 0 && strIndex(internalBuffer, "ALREADY CONNECT") < 0)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("socketOpen() - Unable to connect"));
+    failResult(0);
+    return false;
+  }
+
+  closeResult(0, STAGE_NONE);
+  return true;
+}
+
+/**
+ * Close the connection on the link number mux
+ */
+bool SIM808Driver::socketClose(uint8_t mux)
+{
+  char cmdBuff[20];
+  sprintf_P(cmdBuff, PSTR("AT+CIPCLOSE=%u"), mux);
+  sendCommand(cmdBuff);
+  return readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_CLOSE_OK);
+}
+
+/**
+ * Check if the connection on the link number mux is up
+ */
+bool SIM808Driver::socketConnected(uint8_t mux)
+{
+  char cmdBuff[20];
+  sprintf_P(cmdBuff, PSTR("AT+CIPSTATUS=%u"), mux);
+  sendCommand(cmdBuff);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK, 4))
+  {
+    return false;
+  }
+  return strIndex(internalBuffer, "\"CONNECTED\"") >= 0;
+}
+
+/**
+ * Send data on the link number mux (0 to SOCKET_MAX_CONNECTIONS - 1), from 1 to SOCKET_MAX_SEND bytes
+ * (maximum length of CIPSEND in multi-connection mode, larger data must be split by the caller)
+ * In quick send mode, the module answers as soon as the data is in its buffer, without waiting
+ * for the acknowledgment of the server. The call still blocks during the wait of the prompt, the
+ * write of the data at the baud rate of the link and the wait of DATA ACCEPT (each wait up to the
+ * timeout of the CIPSEND policy)
+ */
+bool SIM808Driver::socketSend(uint8_t mux, const uint8_t *data, uint16_t size)
+{
+  if (mux >= SOCKET_MAX_CONNECTIONS || data == NULL || size == 0 || size > SOCKET_MAX_SEND)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("socketSend() - Invalid link number or size"));
+    return false;
+  }
+  startResult();
+  enterStage(STAGE_SEND);
+  char cmdBuff[24];
+  sprintf_P(cmdBuff, PSTR("AT+CIPSEND=%u,%u"), mux, size);
+  sendCommand(cmdBuff);
+
+  // Wait for the prompt "> " (not followed by CRLF)
+  if (!readUntilAnswer_P(POLICY_TIMEOUT, AT_RSP_PROMPT, AT_RSP_ERROR))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("socketSend() - No prompt to send data"));
+    failResult(0);
+    return false;
+  }
+
+  stream->write(data, size);
+  stream->flush();
+  lastResult.bytesSent = size;
+
+  if (!readUntilAnswer_P(POLICY_TIMEOUT, AT_RSP_DATA_ACCEPT, AT_RSP_SEND_FAIL))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("socketSend() - Data not accepted"));
+    failResult(0);
+    return false;
+  }
+  closeResult(0, STAGE_NONE);
+  return true;
+}
+
+/**
+ * Number of bytes received on the link number mux and waiting in the module
+ */
+uint16_t SIM808Driver::socketAvailable(uint8_t mux)
+{
+  char cmdBuff[24];
+  sprintf_P(cmdBuff, PSTR("AT+CIPRXGET=4,%u"), mux);
+  sendCommand(cmdBuff);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK, 4))
+  {
+    return 0;
+  }
+
+  // Answer: +CIPRXGET: 4,<mux>,<len>
+  int16_t idx = strIndex(internalBuffer, "+CIPRXGET: 4,");
+  if (idx < 0)
+  {
+    return 0;
+  }
+  idx = strIndex(internalBuffer, ",", idx + 13);
+  if (idx < 0)
+  {
+    return 0;
+  }
+  return atoi(&internalBuffer[idx + 1]);
+}
+
+/**
+ * Read up to size bytes received on the link number mux (returns immediately with what is available)
+ * Returns the number of bytes read
+ */
+uint16_t SIM808Driver::socketRead(uint8_t mux, uint8_t *buffer, uint16_t size)
+{
+  startResult();
+  enterStage(STAGE_READ);
+  char cmdBuff[28];
+  sprintf_P(cmdBuff, PSTR("AT+CIPRXGET=2,%u,%u"), mux, size);
+  sendCommand(cmdBuff);
+
+  // Answer: +CIPRXGET: 2,<mux>,<read len>,<remaining len> then the data
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_CIPRXGET2, 2))
+  {
+    failResult(0);
+    return 0;
+  }
+  int16_t idx = strIndex(internalBuffer, "+CIPRXGET: 2,");
+  if (idx >= 0)
+  {
+    idx = strIndex(internalBuffer, ",", idx + 13);
+  }
+  if (idx < 0)
+  {
+    failResult(0);
+    return 0;
+  }
+  uint16_t readSize = atoi(&internalBuffer[idx + 1]);
+  if (readSize > size)
+  {
+    readSize = size;
+  }
+
+  // Read the data as-is (binary)
+  uint32_t timerStart = millis();
+  for (uint16_t i = 0; i < readSize;)
+  {
+    if (stream->available())
+    {
+      buffer[i++] = stream->read();
+      timerStart = millis();
+    }
+    else if (millis() - timerStart > DEFAULT_TIMEOUT)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("socketRead() - Timeout while reading data"));
+      lastResult.bytesReceived = i;
+      failResult(0);
+      return i;
+    }
+  }
+
+  // We are expecting a final OK
+  readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK);
+  lastResult.bytesReceived = readSize;
+  closeResult(0, STAGE_NONE);
+  return readSize;
+}
+
+#endif // SIM808_TCPIP
+
+#if SIM808_FS
+/*****************************************************************************************
+ * FILE SYSTEM FUNCTIONS
+ *****************************************************************************************/
+
+/**
+ * Create an empty file on the flash of the module
+ */
+bool SIM808Driver::fileCreate(const char *name)
+{
+  sendFileCommand_P(AT_CMD_FSCREATE, name);
+  return readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Delete a file from the flash of the module
+ */
+bool SIM808Driver::fileDelete(const char *name)
+{
+  sendFileCommand_P(AT_CMD_FSDEL, name);
+  return readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Size of a file in bytes, -1 if the file does not exist
+ */
+int32_t SIM808Driver::fileSize(const char *name)
+{
+  // Answer: +FSFLSIZE: <size>
+  sendFileCommand_P(AT_CMD_FSFLSIZE, name);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_FSFLSIZE))
+  {
+    return -1;
+  }
+  int16_t idx = strIndex(internalBuffer, "+FSFLSIZE: ");
+  if (idx < 0)
+  {
+    return -1;
+  }
+  return atol(&internalBuffer[idx + 11]);
+}
+
+/**
+ * Free space on the flash of the module in bytes, -1 on error
+ */
+int32_t SIM808Driver::fileFreeSpace()
+{
+  // Answer: +FSMEM: C:<size>bytes
+  if (!sendCommandCheckAnswer_P(AT_CMD_FSMEM, NULL, AT_RSP_FSMEM))
+  {
+    return -1;
+  }
+  int16_t idx = strIndex(internalBuffer, "C:");
+  if (idx < 0)
+  {
+    return -1;
+  }
+  return atol(&internalBuffer[idx + 2]);
+}
+
+/**
+ * Write a buffer in a file, at its end or from its beginning (append false)
+ * The file is created if it does not exist
+ */
+bool SIM808Driver::fileWrite(const char *name, const uint8_t *data, uint16_t size, bool append)
+{
+  if (!filePrepare(name, append))
+  {
+    return false;
+  }
+
+  for (uint16_t written = 0; written < size;)
+  {
+    uint16_t chunkSize = (size - written > FS_CHUNK_SIZE) ? FS_CHUNK_SIZE : size - written;
+    if (!fileWriteChunk(name, &data[written], NULL, chunkSize))
+    {
+      return false;
+    }
+    written += chunkSize;
+  }
+  return true;
+}
+
+/**
+ * Write size bytes read from a source in a file, at its end or from its beginning (append false)
+ * The bytes go from the source to the module without any buffer, chunk per chunk
+ * Returns the number of bytes written
+ */
+uint32_t SIM808Driver::fileWrite(const char *name, Stream *source, uint32_t size, bool append)
+{
+  if (!filePrepare(name, append))
+  {
+    return 0;
+  }
+
+  uint32_t written = 0;
+  while (written < size)
+  {
+    uint16_t chunkSize = (size - written > FS_CHUNK_SIZE) ? FS_CHUNK_SIZE : size - written;
+    if (!fileWriteChunk(name, NULL, source, chunkSize))
+    {
+      break;
+    }
+    written += chunkSize;
+  }
+  return written;
+}
+
+/**
+ * Read size bytes of a file from a position and write them on an output, chunk per chunk
+ * Returns the number of bytes read
+ */
+uint32_t SIM808Driver::fileRead(const char *name, uint32_t position, uint32_t size, Print *output)
+{
+  // The module does not tell the size read, the request is kept inside the file
+  int32_t length = fileSize(name);
+  if (length < 0 || position >= (uint32_t)length)
+  {
+    return 0;
+  }
+  if (size > (uint32_t)length - position)
+  {
+    size = length - position;
+  }
+
+  uint32_t done = 0;
+  while (done < size)
+  {
+    uint16_t chunkSize = (size - done > FS_CHUNK_SIZE) ? FS_CHUNK_SIZE : size - done;
+
+    // Mode 1: read from the position
+    char suffix[24];
+    sprintf_P(suffix, PSTR(",1,%u,%lu"), chunkSize, (unsigned long)(position + done));
+    sendFileCommand_P(AT_CMD_FSREAD, name, suffix);
+
+    // The data follows the first CRLF (after the echo of the command when enabled)
+    if (!readUntilAnswer_P(POLICY_TIMEOUT, AT_RSP_CRLF, AT_RSP_ERROR))
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("fileRead() - Unable to read the file"));
+      break;
+    }
+
+    // Read the data as-is (binary)
+    uint32_t timerStart = millis();
+    for (uint16_t i = 0; i < chunkSize;)
+    {
+      if (stream->available())
+      {
+        output->write((uint8_t)stream->read());
+        i++;
+        timerStart = millis();
+      }
+      else if (millis() - timerStart > DEFAULT_TIMEOUT)
+      {
+        SIM808_LOG(LOG_ERROR, PSTR("fileRead() - Timeout while reading the file"));
+        return done + i;
+      }
+    }
+
+    // We are expecting a final OK
+    if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("fileRead() - Invalid end of data while reading the file"));
+      return done + chunkSize;
+    }
+    done += chunkSize;
+  }
+  return done;
+}
+
+/**
+ * Send a file command (from PROGMEM) followed by the path of the file and the end of the command
+ */
+void SIM808Driver::sendFileCommand_P(const char *command, const char *name, const char *suffix)
+{
+  txBegin();
+  txAppend_P(command);
+  loadPolicy(txBuffer);
+  SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s%s\""), txBuffer, name);
+
+  txAppend_P(FS_PATH);
+  txAppend(name);
+  if (suffix != NULL)
+  {
+    txAppend(suffix);
+  }
+  txEnd();
+}
+
+/**
+ * Create the file if it does not exist, or again from an empty file when not appending
+ */
+bool SIM808Driver::filePrepare(const char *name, bool append)
+{
+  if (append && fileSize(name) >= 0)
+  {
+    return true;
+  }
+  if (!append)
+  {
+    // The write mode 0 of the module does not truncate the file
+    fileDelete(name);
+  }
+  if (!fileCreate(name))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("filePrepare() - Unable to create the file"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Append a chunk (up to FS_CHUNK_SIZE bytes) to a file, from a buffer or from a source when data is NULL
+ */
+bool SIM808Driver::fileWriteChunk(const char *name, const uint8_t *data, Stream *source, uint16_t size)
+{
+  // Mode 1: append, 10 seconds to send the data
+  char suffix[20];
+  sprintf_P(suffix, PSTR(",1,%u,10"), size);
+  sendFileCommand_P(AT_CMD_FSWRITE, name, suffix);
+
+  // Wait for the prompt "> " (not followed by CRLF)
+  if (!readUntilAnswer_P(POLICY_TIMEOUT, AT_RSP_PROMPT, AT_RSP_ERROR))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("fileWriteChunk() - No prompt to write the file"));
+    return false;
+  }
+
+  if (data != NULL)
+  {
+    stream->write(data, size);
+  }
+  else if (!writeFromSource(source, size))
+  {
+    // The module closes the input after its own timeout and keeps the bytes received
+    return false;
+  }
+  stream->flush();
+
+  // The data may be echoed, the OK is searched whatever the CRLF
+  if (!readUntilAnswer_P(POLICY_TIMEOUT, AT_RSP_OK, AT_RSP_ERROR))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("fileWriteChunk() - Data not written"));
+    return false;
+  }
+  return true;
+}
+
+#if SIM808_HTTP
+/**
+ * Do HTTP/S GET on a specific URL (with optional headers) and store the body in a file of the module
+ * The SIM808 can not write the HTTP data in a file by itself: the body is read in ranges of the size of
+ * the reception buffer (AT+HTTPREAD=<start>,<size>) and each range is appended to the file, so every
+ * byte is relayed by the board (twice on the serial)
+ */
+uint16_t SIM808Driver::doGetToFile(const char *url, const char *headers, const char *name, uint16_t serverReadTimeoutMs)
+{
+  // Cleanup the receive buffer
+  initRecvBuffer();
+  dataSize = 0;
+  fileDataSize = 0;
+  startResult();
+
+  // Initiate HTTP/S session
+  bearerLastActivity = millis();
+  uint16_t initRC = initiateHTTP(url, headers);
+  if (initRC > 0)
+  {
+    return initRC;
+  }
+
+  // Start HTTP GET action
+  enterStage(STAGE_ACTION);
+  if (!sendCommandCheckAnswer_P(AT_CMD_HTTPACTION0, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("doGetToFile() - Unable to initiate GET action"));
+    return failResult(703);
+  }
+
+  // Wait answer from the server
+  if (!readResponse(serverReadTimeoutMs))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("doGetToFile() - Server timeout"));
+    return failResult(408);
+  }
+
+  // Extract status information (+HTTPACTION: 0,<status>,<size>)
+  int16_t idxBase = strIndex(internalBuffer, "+HTTPACTION: 0,");
+  int16_t idxSize = idxBase < 0 ? -1 : strIndex(internalBuffer, ",", idxBase + 15);
+  uint16_t httpRC = idxBase < 0 ? 0 : atoi(&internalBuffer[idxBase + 15]);
+  if (httpRC < 100 || idxSize < 0)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("doGetToFile() - Invalid answer on HTTP GET"));
+    return failResult(703);
+  }
+
+  SIM808_LOG(LOG_INFO, PSTR("doGetToFile() - HTTP status %u"), httpRC);
+
+  // 6xx are errors of the module (network, DNS, SSL...) and not of the server
+  RequestStage failedStage = STAGE_NONE;
+  if (httpRC >= 600)
+  {
+    lastResult.moduleError = httpRC;
+    failedStage = STAGE_ACTION;
+  }
+
+  // The body may be larger than 64KB
+  uint32_t size = strtoul(&internalBuffer[idxSize + 1], NULL, 10);
+
+  if (httpRC == 200)
+  {
+    enterStage(STAGE_READ);
+    if (!filePrepare(name, false))
+    {
+      return failResult(708);
+    }
+
+    uint16_t rangeSize = (recvBufferSize > FS_CHUNK_SIZE) ? FS_CHUNK_SIZE : recvBufferSize;
+    while (fileDataSize < size)
+    {
+      uint16_t readSize = readHTTPChunk(fileDataSize, (size - fileDataSize > rangeSize) ? rangeSize : size - fileDataSize);
+      if (readSize == 0)
+      {
+        return failResult(705);
+      }
+      if (!fileWriteChunk(name, (const uint8_t *)recvBuffer, NULL, readSize))
+      {
+        return failResult(708);
+      }
+      fileDataSize += readSize;
+      lastResult.bytesReceived = fileDataSize;
+    }
+
+    SIM808_LOG(LOG_INFO, PSTR("doGetToFile() - %lu bytes stored"), (unsigned long)fileDataSize);
+
+    // The reception buffer only holds the last range
+    if (recvBufferSize > 0)
+    {
+      recvBuffer[0] = 0;
+    }
+  }
+
+  // Terminate HTTP/S session
+  uint16_t termRC = terminateHTTP();
+  if (termRC > 0)
+  {
+    return termRC;
+  }
+
+  return closeResult(httpRC, failedStage);
+}
+
+/**
+ * Size of the body stored in the file by the last doGetToFile()
+ */
+uint32_t SIM808Driver::getFileDataSize()
+{
+  return fileDataSize;
+}
+#endif // SIM808_HTTP
+
+#endif // SIM808_FS
+
+#if SIM808_FTP
+/*****************************************************************************************
+ * FTP FUNCTIONS
+ *****************************************************************************************/
+
+/**
+ * Define the FTP server and the account of the transfers (the strings are kept by the caller)
+ */
+void SIM808Driver::setupFTP(const char *server, uint16_t port, const char *user, const char *password)
+{
+  ftpServer = server;
+  ftpPort = port;
+  ftpUser = user;
+  ftpPassword = password;
+}
+
+/**
+ * Upload size bytes read from a source in the file path/name of the FTP server
+ * The data goes in chunks of the size given by the module (up to 1360 bytes), the next chunk is sent
+ * when the module tells that the previous one was sent to the server
+ * The bytes confirmed by the module are given by getLastResult().bytesSent
+ */
+bool SIM808Driver::ftpPut(const char *path, const char *name, Stream *source, uint32_t size, bool append, uint32_t timeoutMs)
+{
+  startResult();
+  bearerLastActivity = millis();
+
+  // Setup FTP session
+  enterStage(STAGE_PARAMETERS);
+  if (!ftpSetup(path, name, true) || !sendCommandCheckAnswer_P(append ? AT_CMD_FTPPUTOPT_APPE : AT_CMD_FTPPUTOPT_STOR, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("ftpPut() - Unable to define the FTP parameters"));
+    failResult(0);
+    return false;
+  }
+
+  // Open the session: +FTPPUT: 1,1,<max length> when ready, +FTPPUT: 1,<error> otherwise
+  enterStage(STAGE_ACTION);
+  int16_t status = -1;
+  if (sendCommandCheckAnswer_P(AT_CMD_FTPPUT1, NULL, AT_RSP_OK))
+  {
+    status = readFTPStatus(AT_RSP_FTPPUT1, timeoutMs);
+  }
+
+  enterStage(STAGE_SEND);
+  while (status == 1 && lastResult.bytesSent < size)
+  {
+    int16_t idx = strIndex(internalBuffer, ",");
+    uint16_t maxLength = idx < 0 ? 0 : atoi(&internalBuffer[idx + 1]);
+    if (maxLength == 0)
+    {
+      break;
+    }
+
+    uint16_t chunkSize = (size - lastResult.bytesSent > maxLength) ? maxLength : size - lastResult.bytesSent;
+    char cmdBuff[24];
+    sprintf_P(cmdBuff, PSTR("AT+FTPPUT=2,%u"), chunkSize);
+    sendCommand(cmdBuff);
+
+    // Answer: +FTPPUT: 2,<length accepted> then the module waits for the data
+    if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_FTPPUT2, 2))
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("ftpPut() - Data refused by the module"));
+      failResult(0);
+      return false;
+    }
+    idx = strIndex(internalBuffer, "+FTPPUT: 2,");
+    uint16_t accepted = idx < 0 ? 0 : atoi(&internalBuffer[idx + 11]);
+    if (accepted == 0 || accepted > chunkSize)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("ftpPut() - Data refused by the module"));
+      failResult(0);
+      return false;
+    }
+
+    if (!writeFromSource(source, accepted))
+    {
+      failResult(0);
+      return false;
+    }
+    stream->flush();
+
+    // The data may be echoed, the OK is searched whatever the CRLF
+    if (!readUntilAnswer_P(POLICY_TIMEOUT, AT_RSP_OK, AT_RSP_ERROR))
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("ftpPut() - Data not accepted"));
+      failResult(0);
+      return false;
+    }
+
+    // Ready for the next chunk once this one is sent to the server
+    status = readFTPStatus(AT_RSP_FTPPUT1, timeoutMs);
+    if (status == 1)
+    {
+      lastResult.bytesSent += accepted;
+    }
+  }
+
+  if (status != 1 || lastResult.bytesSent < size)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("ftpPut() - FTP error %d"), status);
+    if (status > 1)
+    {
+      lastResult.moduleError = status;
+    }
+    failResult(0);
+    return false;
+  }
+
+  // Close the session: +FTPPUT: 1,0 when the file is complete on the server
+  enterStage(STAGE_TERMINATE);
+  if (!sendCommandCheckAnswer_P(AT_CMD_FTPPUT_END, NULL, AT_RSP_OK) || readFTPStatus(AT_RSP_FTPPUT1, timeoutMs) != 0)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("ftpPut() - Unable to close the FTP session"));
+    failResult(0);
+    return false;
+  }
+
+  SIM808_LOG(LOG_INFO, PSTR("ftpPut() - %lu bytes sent"), (unsigned long)lastResult.bytesSent);
+  closeResult(0, STAGE_NONE);
+  return true;
+}
+
+/**
+ * Download the file path/name of the FTP server from an offset and write it on an output
+ * The data is read in chunks of FTP_CHUNK_SIZE bytes as it arrives in the module
+ */
+bool SIM808Driver::ftpGet(const char *path, const char *name, Print *output, uint32_t offset, uint32_t timeoutMs)
+{
+  startResult();
+  bearerLastActivity = millis();
+
+  // Setup FTP session
+  enterStage(STAGE_PARAMETERS);
+  bool setup = ftpSetup(path, name, false);
+  if (setup && offset > 0)
+  {
+    char cmdBuff[28];
+    sprintf_P(cmdBuff, PSTR("AT+FTPREST=%lu"), (unsigned long)offset);
+    sendCommand(cmdBuff);
+    setup = readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK);
+  }
+  if (!setup)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("ftpGet() - Unable to define the FTP parameters"));
+    failResult(0);
+    return false;
+  }
+
+  // Open the session: +FTPGET: 1,1 when data is available, +FTPGET: 1,<error> otherwise
+  enterStage(STAGE_ACTION);
+  int16_t status = -1;
+  if (sendCommandCheckAnswer_P(AT_CMD_FTPGET1, NULL, AT_RSP_OK))
+  {
+    status = readFTPStatus(AT_RSP_FTPGET1, timeoutMs);
+  }
+
+  enterStage(STAGE_READ);
+  bool finished = false;
+  while (status == 1)
+  {
+    // A status received since the last read would be dropped by the next command
+    // (+FTPGET: 1,0 is sent when the server has sent the whole file, the module may still hold data)
+    if (!finished && stream->available())
+    {
+      int16_t pending = readFTPStatus(AT_RSP_FTPGET1, DEFAULT_TIMEOUT);
+      if (pending != 0 && pending != 1)
+      {
+        status = pending;
+        break;
+      }
+      finished = pending == 0;
+    }
+
+    char cmdBuff[24];
+    sprintf_P(cmdBuff, PSTR("AT+FTPGET=2,%u"), FTP_CHUNK_SIZE);
+    sendCommand(cmdBuff);
+
+    // Answer: +FTPGET: 2,<length> then the data
+    if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_FTPGET2, 2))
+    {
+      status = finished ? 0 : -1;
+      break;
+    }
+    int16_t idx = strIndex(internalBuffer, "+FTPGET: 2,");
+    uint16_t readSize = idx < 0 ? 0 : atoi(&internalBuffer[idx + 11]);
+    if (readSize > FTP_CHUNK_SIZE)
+    {
+      status = -1;
+      break;
+    }
+
+    // Nothing in the module: wait for more data or for the end of the file
+    if (readSize == 0)
+    {
+      status = finished ? 0 : readFTPStatus(AT_RSP_FTPGET1, timeoutMs);
+      continue;
+    }
+
+    // Read the data as-is (binary)
+    uint32_t timerStart = millis();
+    for (uint16_t i = 0; i < readSize;)
+    {
+      if (stream->available())
+      {
+        output->write((uint8_t)stream->read());
+        i++;
+        timerStart = millis();
+      }
+      else if (millis() - timerStart > DEFAULT_TIMEOUT)
+      {
+        SIM808_LOG(LOG_ERROR, PSTR("ftpGet() - Timeout while reading data"));
+        lastResult.bytesReceived += i;
+        failResult(0);
+        return false;
+      }
+    }
+    lastResult.bytesReceived += readSize;
+
+    // We are expecting a final OK
+    if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+    {
+      status = -1;
+      break;
+    }
+  }
+
+  if (status != 0)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("ftpGet() - FTP error %d"), status);
+    if (status > 1)
+    {
+      lastResult.moduleError = status;
+    }
+    failResult(0);
+    return false;
+  }
+
+  SIM808_LOG(LOG_INFO, PSTR("ftpGet() - %lu bytes received"), (unsigned long)lastResult.bytesReceived);
+  closeResult(0, STAGE_NONE);
+  return true;
+}
+
+/**
+ * Send the parameters of a FTP session: server, account, binary type and file to put or to get
+ */
+bool SIM808Driver::ftpSetup(const char *path, const char *name, bool put)
+{
+  if (ftpServer == NULL)
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("ftpSetup() - No FTP server, call setupFTP() first"));
+    return false;
+  }
+
+  if (!sendCommandCheckAnswer_P(AT_CMD_FTPCID, NULL, AT_RSP_OK) ||
+      !sendCommandCheckAnswer_P(AT_CMD_FTPSERV, ftpServer, AT_RSP_OK))
+  {
+    return false;
+  }
+
+  char cmdBuff[20];
+  sprintf_P(cmdBuff, PSTR("AT+FTPPORT=%u"), ftpPort);
+  sendCommand(cmdBuff);
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+  {
+    return false;
+  }
+
+  if ((ftpUser != NULL && !sendCommandCheckAnswer_P(AT_CMD_FTPUN, ftpUser, AT_RSP_OK)) ||
+      (ftpPassword != NULL && !sendCommandCheckAnswer_P(AT_CMD_FTPPW, ftpPassword, AT_RSP_OK)) ||
+      !sendCommandCheckAnswer_P(AT_CMD_FTPTYPE, NULL, AT_RSP_OK))
+  {
+    return false;
+  }
+
+  return sendCommandCheckAnswer_P(put ? AT_CMD_FTPPUTNAME : AT_CMD_FTPGETNAME, name, AT_RSP_OK) &&
+         sendCommandCheckAnswer_P(put ? AT_CMD_FTPPUTPATH : AT_CMD_FTPGETPATH, path, AT_RSP_OK);
+}
+
+/**
+ * Wait for the status URC of the FTP session and read the rest of its line in the internal buffer
+ * Returns the status (1: ready, 0: end of the session, 61 to 86: FTP error), -1 on timeout
+ */
+int16_t SIM808Driver::readFTPStatus(const char *urc, uint32_t timeout)
+{
+  if (!readUntilAnswer_P(timeout, urc, NULL) || !readResponse(POLICY_TIMEOUT, 1))
+  {
+    return -1;
+  }
+  return atoi(internalBuffer);
+}
+
+#if SIM808_FS
+/**
+ * Upload a file of the module (written by fileWrite()) in the file path/name of the FTP server
+ * The module reads the file and sends it by itself, the board only waits for the end of the transfer
+ */
+bool SIM808Driver::ftpPutFromFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs)
+{
+  return startFTPFile(path, name, fileName, true, timeoutMs) && waitFTP();
+}
+
+/**
+ * Download the file path/name of the FTP server in a file of the FTP directory of the module
+ * The module receives the file and writes it by itself, the board only waits for the end of the transfer
+ */
+bool SIM808Driver::ftpGetToFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs)
+{
+  return startFTPFile(path, name, fileName, false, timeoutMs) && waitFTP();
+}
+
+/**
+ * Start the upload of a file of the module, its end is read by pollFTP()
+ */
+bool SIM808Driver::startFTPPutFromFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs)
+{
+  return startFTPFile(path, name, fileName, true, timeoutMs);
+}
+
+/**
+ * Start the download of a file in the module, its end is read by pollFTP()
+ */
+bool SIM808Driver::startFTPGetToFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs)
+{
+  return startFTPFile(path, name, fileName, false, timeoutMs);
+}
+
+/**
+ * Send the parameters of the session and give the transfer of the file to the module
+ * The module answers OK at once, then +FTPPUTFRMFS: <status>,<size> or +FTPGETTOFS: <status>,<size> at the
+ * end of the transfer (read by pollFTP()). The firmwares without the FTP application of the SIM800 series
+ * answer ERROR
+ */
+bool SIM808Driver::startFTPFile(const char *path, const char *name, const char *fileName, bool put, uint32_t timeoutMs)
+{
+  startResult();
+  bearerLastActivity = millis();
+
+  // Setup FTP session
+  enterStage(STAGE_PARAMETERS);
+  if (!ftpSetup(path, name, put) || (put && !sendCommandCheckAnswer_P(AT_CMD_FTPPUTOPT_STOR, NULL, AT_RSP_OK)))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startFTPFile() - Unable to define the FTP parameters"));
+    failResult(0);
+    return false;
+  }
+
+  enterStage(STAGE_ACTION);
+  if (put)
+  {
+    sendFileCommand_P(AT_CMD_FTPPUTFRMFS, fileName, "\"");
+  }
+  else
+  {
+    sendCommand_P(AT_CMD_FTPGETTOFS, fileName);
+  }
+  if (!readResponseCheckAnswer_P(POLICY_TIMEOUT, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("startFTPFile() - Transfer refused, the firmware may not support it"));
+    failResult(0);
+    return false;
+  }
+
+  // The session is opened and the file transferred by the module
+  enterStage(put ? STAGE_SEND : STAGE_READ);
+  ftpPending = true;
+  ftpPendingPut = put;
+  ftpStart = millis();
+  ftpTimeout = timeoutMs;
+  return true;
+}
+
+/**
+ * Check if the file transfer started by startFTPPutFromFile()/startFTPGetToFile() is over, without waiting.
+ * The other lines received meanwhile are kept for readURC()
+ * Returns 0 while the transfer runs (or no transfer is started), 1 when the file was transferred, -1 on
+ * failure: the FTP error is given by getLastResult().moduleError
+ */
+int8_t SIM808Driver::pollFTP()
+{
+  if (!ftpPending)
+  {
+    return 0;
+  }
+
+  const char *urc = ftpPendingPut ? AT_RSP_FTPPUTFRMFS : AT_RSP_FTPGETTOFS;
+  uint8_t urcLength = strlen_P(urc);
+  while (stream->available())
+  {
+    if (!urcPut(stream->read()))
+    {
+      continue;
+    }
+    if (strncmp_P(urcBuffer, urc, urcLength) != 0)
+    {
+      queueURC();
+      continue;
+    }
+
+    ftpPending = false;
+    SIM808_LOG(LOG_DEBUG, PSTR("Receive \"%s\""), urcBuffer);
+    int16_t status = atoi(&urcBuffer[urcLength]);
+    const char *size = strchr(&urcBuffer[urcLength], ',');
+    if (status != 0)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("pollFTP() - FTP error %d"), status);
+      lastResult.moduleError = status;
+      failResult(0);
+      return -1;
+    }
+    if (size != NULL)
+    {
+      if (ftpPendingPut)
+      {
+        lastResult.bytesSent = strtoul(size + 1, NULL, 10);
+      }
+      else
+      {
+        lastResult.bytesReceived = strtoul(size + 1, NULL, 10);
+      }
+    }
+    SIM808_LOG(LOG_INFO, PSTR("pollFTP() - File transferred"));
+    closeResult(0, STAGE_NONE);
+    return 1;
+  }
+
+  if (millis() - ftpStart > ftpTimeout)
+  {
+    ftpPending = false;
+#if SIM808_METRICS
+    metrics.timeouts++;
+#endif
+    SIM808_LOG(LOG_ERROR, PSTR("pollFTP() - Timeout of the transfer"));
+    failResult(0);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * True while the file transfer started by startFTPPutFromFile()/startFTPGetToFile() runs
+ */
+bool SIM808Driver::isFTPPending()
+{
+  return ftpPending;
+}
+
+/**
+ * Wait for the end of the file transfer started (blocking ftpPutFromFile()/ftpGetToFile())
+ */
+bool SIM808Driver::waitFTP()
+{
+  int8_t rc = 0;
+  while (rc == 0 && ftpPending)
+  {
+    rc = pollFTP();
+  }
+  return rc > 0;
+}
+#endif
+#endif // SIM808_FTP
+
+#if SIM808_GNSS
+/*****************************************************************************************
+ * GNSS FUNCTIONS
+ *****************************************************************************************/
+
+/**
+ * Power On GNSS on the module
+*/
+bool SIM808Driver::powerOnGNSS()
+{
+  // Send Power on GNSS cmd
+  if (!sendCommandCheckAnswer_P(AT_CMD_CGNSPWR1, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("powerOnGNSS() - Unable to Power on GNSS"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Power Off GNSS on the module
+*/
+bool SIM808Driver::powerOffGNSS()
+{
+  // Send Power off GNSS cmd
+  if (!sendCommandCheckAnswer_P(AT_CMD_CGNSPWR0, NULL, AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("powerOnGNSS() - Unable to Power off GNSS"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ *  Get power status of GNSS
+*/
+SIM808Driver::GnssStatus SIM808Driver::getGnssPowerStatus()
+{
+  sendCommand_P(AT_CMD_CGNSPWR_TEST);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Check if there is an error
+    int16_t errIdx = strIndex(internalBuffer, "ERROR");
+    if (errIdx >= 0)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("getGnssPowerStatus() - Error on getting GNSS Power"));
+      return GNSS_ERROR;
+    }
+
+    // Extract the value
+    int16_t idx = strIndex(internalBuffer, "+CGNSPWR: ");
+    if (idx < 0)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("getGnssPowerStatus() - Invalid answer"));
+      return GNSS_ERROR;
+    }
+    char value = internalBufferAt(idx + 10);
+
+    if (value == '1')
+      return GNSS_POWER_ON;
+    else
+      return GNSS_POWER_OFF;
+  }
+  SIM808_LOG(LOG_ERROR, PSTR("getGnssPowerStatus() - Unable to get power status of GNSS"));
+  return GNSS_ERROR;
+}
+
+/**
+ * Turn on navigation data URC report, and report every GNSS FIX
+*/
+bool SIM808Driver::attachGNSS(uint8_t fix)
+{
+  // Check if GNSS is On
+  if (!getGnssPowerStatus())
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("attachGNSS() - GNSS Power is off"));
+    return false;
+  }
+
+  char buff[4];
+  // Send Power off GNSS cmd
+  if (!sendCommandCheckAnswer_P(AT_CMD_CGNSURC, itoa(fix, buff, 10), AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("attachGNSS() - Unable to attach GNSS"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Turn off GNSS navigation, GEO-fences and speed alarm URC report 
+*/
+bool SIM808Driver::detachGNSS()
+{
+  // Send Power off GNSS cmd
+  if (!sendCommandCheckAnswer_P(AT_CMD_CGNSURC, "0", AT_RSP_OK))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("detachGNSS() - Unable to Power off GNSS"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Turn off GNSS navigation, GEO-fences and speed alarm URC report 
+*/
+SIM808Driver::GnssStatus SIM808Driver::getGnssInfo(SIM808Driver::GnssInfo *gnssInfo)
+{
+  // get Info
+  if (!sendCommandCheckAnswer_P(AT_CMD_CGNSINF, NULL, AT_RSP_CGNSINF, 4U))
+  {
+    SIM808_LOG(LOG_ERROR, PSTR("getGnssInfo() - Unable to get GNSS Info"));
+    return GNSS_ERROR;
+  }
+
+  return parseGnssData(gnssInfo);
+}
+
+SIM808Driver::GnssStatus SIM808Driver::parseGnssData(SIM808Driver::GnssInfo *gnssInfo)
+{
+  // Check if get called after AT+CGNSINF
+  int16_t idx = strIndex(internalBuffer, "+CGNSINF: ");
+  // Otherwise check if get called on AT+CGNSURC UAC report
+  if (idx == -1)
+    idx = strIndex(internalBuffer, "+UGNSINF: ");
+  if (idx == -1)
+    return GNSS_ERROR;
+
+  // Extract power status of GNSS
+  char power = internalBufferAt(idx + 10);
+  // Extract fix status
+  char fix = internalBufferAt(idx + 12);
+
+  SIM808_LOG(LOG_DEBUG, PSTR("parseGnssData() - power: %c fix: %c"), power, fix);
+  if (power == '1')
+    if (fix == '1')
+    {
+      float info[GNSS_PARSED_FIELDS];
+      memset(info, 0, sizeof(info));
+
+      int16_t idxEnd = strIndex(internalBuffer, "\r\n", idx);
+      if (idxEnd < idx + 14)
+      {
+        return GNSS_ERROR;
+      }
+
+      // Split in place in the internal buffer (no copy), from the UTC field
+      // Empty fields are kept (strtok would skip them and shift the next ones):
+      // utc,lat,lon,alt,speed,course,fix mode,(reserved),HDOP,PDOP,VDOP,(reserved),GPS sats in view,GNSS sats used...
+      internalBuffer[idxEnd] = 0;
+      char *tok = internalBuffer + idx + 14;
+      for (uint8_t i = 0; tok != NULL && i < GNSS_PARSED_FIELDS; i++)
+      {
+        char *next = strchr(tok, ',');
+        if (next != NULL)
+        {
+          *next++ = 0;
+        }
+
+        switch (i)
+        {
+        case 0:
+          copyField(gnssInfo->utc, tok, sizeof(gnssInfo->utc));
+          break;
+        case 1:
+          copyField(gnssInfo->latitude, tok, sizeof(gnssInfo->latitude));
+          break;
+        case 2:
+          copyField(gnssInfo->longitude, tok, sizeof(gnssInfo->longitude));
+          break;
+        case 6:
+          gnssInfo->fixMode = atoi(tok);
+          break;
+        case 12:
+          gnssInfo->gpsSatInView = atoi(tok);
+          break;
+        case 13:
+          gnssInfo->gnssSatUsed = atoi(tok);
+          break;
+        default:
+          info[i] = atof(tok);
+          break;
+        }
+
+        tok = next;
+      }
+
+      gnssInfo->altitude = info[3];
+      gnssInfo->speed = info[4];
+      gnssInfo->heading = info[5];
+      gnssInfo->HDOP = info[8];
+      gnssInfo->PDOP = info[9];
+      gnssInfo->VDOP = info[10];
+
+      return GNSS_FIX;
+    }
+    else
+    {
+      gnssInfo->fixMode = 0;
+      return GNSS_NOT_FIX;
+    }
+  else
+    SIM808_LOG(LOG_ERROR, PSTR("getGnssInfo() - Unable to get GNSS Info, GNSS Power is off"));
+  return GNSS_POWER_OFF;
+}
+
+/**
+ * Copy a field of an answer in a string of a given size (truncated if too long)
+ */
+void SIM808Driver::copyField(char *destination, const char *field, uint8_t size)
+{
+  strncpy(destination, field, size - 1);
+  destination[size - 1] = 0;
+}
+
+#endif // SIM808_GNSS
+
+/*****************************************************************************************
+ * BASE CONTROLL & CHECK FUNCTIONS
+ *****************************************************************************************/
+
+/**
+ * Force a reset of the module
+ */
+void SIM808Driver::reset()
+{
+  if (pinReset != (uint8_t)RESET_PIN_NOT_USED)
+  {
+    // Some logging
+    SIM808_LOG(LOG_DEBUG, PSTR("Reset"));
+
+    // Reset the device
+    digitalWrite(pinReset, HIGH);
+    delay(500);
+    digitalWrite(pinReset, LOW);
+    delay(500);
+    digitalWrite(pinReset, HIGH);
+    delay(1000);
+  }
+  else
+  {
+    // Some logging
+    SIM808_LOG(LOG_WARNING, PSTR("Reset requested but reset pin undefined"));
+
+    // Set power to minimum and back it to normal for soft ressetting
+    if (setPowerMode(POW_MINIMUM))
+    {
+      delay(1000);
+      setPowerMode(POW_NORMAL);
+    }
+  }
+
+  // Purge the serial
+  stream->flush();
+  while (stream->available())
+  {
+    stream->read();
+  }
+
+  // The module is back to its default echo mode
+  echoConfigured = false;
+}
+
+/**
+ * Status function: Check if AT command works
+ */
+bool SIM808Driver::isReady()
+{
+  if (!sendCommandCheckAnswer_P(AT_CMD_BASE, NULL, AT_RSP_OK))
+  {
+    return false;
+  }
+
+  // First answer of the module: set the echo mode of the configuration
+  if (!echoConfigured)
+  {
+    echoConfigured = setEcho(SIM808_ECHO);
+  }
+  return true;
+}
+
+/**
+ * Check if the module answers with a single try, waiting at most timeoutMs
+ */
+bool SIM808Driver::isReady(uint16_t timeoutMs)
+{
+  sendCommand_P(AT_CMD_BASE);
+  if (!readResponseCheckAnswer_P(timeoutMs, AT_RSP_OK))
+  {
+    return false;
+  }
+
+  // First answer of the module: set the echo mode of the configuration
+  if (!echoConfigured)
+  {
+    echoConfigured = setEcho(SIM808_ECHO);
+  }
+  return true;
+}
+
+/**
+ * Read the lines sent by the module outside of the commands (URC), without waiting
+ * The lines kept before the last commands come first. The empty lines and the leftovers of the answers
+ * are skipped, the end of a line longer than the buffer is dropped
+ */
+const char *SIM808Driver::readURC()
+{
+  if (urcQueueCount > 0)
+  {
+    strcpy(urcBuffer, urcQueue[urcQueueHead]);
+    urcQueueHead = (urcQueueHead + 1) % URC_QUEUE_SIZE;
+    urcQueueCount--;
+  }
+#if SIM808_HTTP
+  else if (httpPending)
+  {
+    // The serial is read by pollHTTP(), which keeps the URCs
+    return NULL;
+  }
+#endif
+#if SIM808_FTP && SIM808_FS
+  else if (ftpPending)
+  {
+    // The serial is read by pollFTP(), which keeps the URCs
+    return NULL;
+  }
+#endif
+  else
+  {
+    bool complete = false;
+    while (!complete && stream->available())
+    {
+      complete = urcPut(stream->read());
+    }
+    if (!complete)
+    {
+      return NULL;
+    }
+  }
+  SIM808_LOG(LOG_DEBUG, PSTR("URC \"%s\""), urcBuffer);
+  return urcBuffer;
+}
+
+/**
+ * Add a byte to the URC line being received
+ * The echo and the result codes of a late answer (AT..., OK, ERROR) are not URCs, they are skipped
+ */
+bool SIM808Driver::urcPut(char c)
+{
+  if (c == '\n')
+  {
+    bool complete = urcUsed > 0;
+    urcBuffer[urcUsed] = 0;
+    urcUsed = 0;
+    return complete && strncmp_P(urcBuffer, PSTR("AT"), 2) != 0 && strcmp_P(urcBuffer, AT_RSP_OK) != 0 && strcmp_P(urcBuffer, AT_RSP_ERROR) != 0;
+  }
+  if (c != '\r' && urcUsed < URC_BUFFER_SIZE - 1)
+  {
+    urcBuffer[urcUsed++] = c;
+  }
+  return false;
+}
+
+/**
+ * Enable/disable the echo of the commands by the module (ATE1/ATE0)
+ * Without echo, the bytes of each command are not sent back and scanned again by the driver
+ */
+bool SIM808Driver::setEcho(bool enable)
+{
+  return sendCommandCheckAnswer_P(enable ? AT_CMD_ATE1 : AT_CMD_ATE0, NULL, AT_RSP_OK);
+}
+
+/**
+ * Ask the module to give numeric error codes (+CME ERROR: <n>) instead of a plain ERROR
+ */
+bool SIM808Driver::enableModuleErrorCodes()
+{
+  return sendCommandCheckAnswer_P(AT_CMD_CMEE1, NULL, AT_RSP_OK);
+}
+
+/**
+ * Detailed result of the last network call (HTTP, GPRS connection, socket)
+ */
+const SIM808Driver::RequestResult &SIM808Driver::getLastResult()
+{
+  return lastResult;
+}
+
+#if SIM808_METRICS
+/**
+ * Copy the counters and the histograms since the last reset
+ */
+void SIM808Driver::getMetrics(Metrics *snapshot)
+{
+  memcpy(snapshot, &metrics, sizeof(Metrics));
+}
+
+/**
+ * Reset all the counters and the histograms
+ */
+void SIM808Driver::resetMetrics()
+{
+  memset(&metrics, 0, sizeof(Metrics));
+}
+
+/**
+ * Upper limit (ms, excluded) of a bucket of the latency histograms, 0 for the last one
+ */
+uint32_t SIM808Driver::getMetricsBucketLimit(uint8_t bucket)
+{
+  return bucket < METRICS_BUCKETS - 1 ? pgm_read_dword(&METRICS_BUCKET_LIMITS[bucket]) : 0;
+}
+#endif // SIM808_METRICS
+
+/**
+ * Status function: Check the power mode
+ */
+SIM808Driver::PowerMode SIM808Driver::getPowerMode()
+{
+  sendCommand_P(AT_CMD_CFUN_TEST);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Check if there is an error
+    int16_t errIdx = strIndex(internalBuffer, "ERROR");
+    if (errIdx >= 0)
+    {
+      return POW_ERROR;
+    }
+
+    // Extract the value
+    int16_t idx = strIndex(internalBuffer, "+CFUN: ");
+    if (idx < 0)
+    {
+      return POW_ERROR;
+    }
+    char value = internalBufferAt(idx + 7);
+
+    // Prepare the clear output
+    switch (value)
+    {
+    case '0':
+      return POW_MINIMUM;
+    case '1':
+      return POW_NORMAL;
+    case '4':
+      return POW_SLEEP;
+    default:
+      return POW_UNKNOWN;
+    }
+  }
+  return POW_ERROR;
+}
+
+#if SIM808_STATUS || (SIM808_HTTP && SIM808_SSL)
+/**
+ * Status function: Get version of the module
+ */
+char *SIM808Driver::getVersion()
+{
+  sendCommand_P(AT_CMD_ATI);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Extract the value and store it on the recv buffer (not used at the moment)
+    int16_t idx = strIndex(internalBuffer, "SIM");
+    return copyToRecvBuffer(idx, strIndex(internalBuffer, "\r", idx + 1));
+  }
+  else
+  {
+    return NULL;
+  }
+}
+
+#endif
+
+#if SIM808_STATUS
+/**
+ * Status function: Get firmware version
+ */
+char *SIM808Driver::getFirmware()
+{
+  sendCommand_P(AT_CMD_GMR);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Extract the value and store it on the recv buffer (not used at the moment)
+    int16_t idx = informationIndex();
+    return copyToRecvBuffer(idx, strIndex(internalBuffer, "\r", idx + 1));
+  }
+  else
+  {
+    return NULL;
+  }
+}
+
+/**
+ * Status function: Requests the simcard number
+ */
+char *SIM808Driver::getSimCardNumber()
+{
+  sendCommand_P(AT_CMD_SIM_CARD);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Extract the value and store it on the recv buffer (not used at the moment)
+    int16_t idx = informationIndex();
+    return copyToRecvBuffer(idx, strIndex(internalBuffer, "\r", idx + 1));
+  }
+  else
+  {
+    return NULL;
+  }
+}
+
+/**
+ * Status function: Check if the module is registered on the network
+ */
+SIM808Driver::NetworkRegistration SIM808Driver::getRegistrationStatus()
+{
+  sendCommand_P(AT_CMD_CREG_TEST);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Check if there is an error
+    int16_t errIdx = strIndex(internalBuffer, "ERROR");
+    if (errIdx >= 0)
+    {
+      return NET_ERROR;
+    }
+
+    // Extract the value
+    int16_t idx = strIndex(internalBuffer, "+CREG: ");
+    if (idx < 0)
+    {
+      return NET_ERROR;
+    }
+    char value = internalBufferAt(idx + 9);
+
+    // Prepare the clear output
+    switch (value)
+    {
+    case '0':
+      return NET_NOT_REGISTERED;
+    case '1':
+      return NET_REGISTERED_HOME;
+    case '2':
+      return NET_SEARCHING;
+    case '3':
+      return NET_DENIED;
+    case '5':
+      return NET_REGISTERED_ROAMING;
+    default:
+      return NET_UNKNOWN;
+    }
+  }
+
+  return NET_ERROR;
+}
+
+/**
+ * Enable/disable the URC +CREG: <stat> sent by the module when the registration changes
+ */
+bool SIM808Driver::setRegistrationURC(bool enable)
+{
+  return sendCommandCheckAnswer_P(enable ? AT_CMD_CREG1 : AT_CMD_CREG0, NULL, AT_RSP_OK);
+}
+
+#endif // SIM808_STATUS
+
+/**
+ * Setup the GPRS connectivity
+ * As input, give the APN string of the operator
+ */
+bool SIM808Driver::setupGPRS(const char *apn)
+{
+  // Prepare the GPRS connection as the bearer
+  if (!sendCommandCheckAnswer_P(AT_CMD_SAPBR_GPRS, NULL, AT_RSP_OK))
+  {
+    return false;
+  }
+
+  // Set the config of the bearer with the APN
+  return sendCommandCheckAnswer_P(AT_CMD_SAPBR_APN, apn, AT_RSP_OK);
+}
+
+/**
+ * Open the GPRS connectivity
+ * The bearer is opened only if it is not already up
+ */
+bool SIM808Driver::connectGPRS()
+{
+  startResult();
+  enterStage(STAGE_BEARER);
+  BearerStatus status = getBearerStatus();
+  if (status == BEARER_CONNECTED)
+  {
+    bearerLastActivity = millis();
+    closeResult(0, STAGE_NONE);
+    return true;
+  }
+
+  uint32_t timerStart = millis();
+  // Timout is max 85 seconds according to SIM808 specifications (see the policy table)
+  if (!sendCommandCheckAnswer_P(AT_CMD_SAPBR1, NULL, AT_RSP_OK))
+  {
+    bearerStatus = BEARER_ERROR;
+    failResult(0);
+    return false;
+  }
+  bearerConnectTime = millis() - timerStart;
+  bearerConnectCount++;
+
+  SIM808_LOG(LOG_INFO, PSTR("connectGPRS() - Bearer up in %lu ms"), (unsigned long)bearerConnectTime);
+
+  // Get the IP assigned
+  getBearerStatus();
+  bearerLastActivity = millis();
+  closeResult(0, STAGE_NONE);
+  return true;
+}
+
+/**
+ * Close the GPRS connectivity
+ * Nothing is sent if the bearer is already closed
+ */
+bool SIM808Driver::disconnectGPRS()
+{
+  if (getBearerStatus() == BEARER_CLOSED)
+  {
+    return true;
+  }
+
+  // Timout is max 65 seconds according to SIM808 specifications (see the policy table)
+  if (!sendCommandCheckAnswer_P(AT_CMD_SAPBR0, NULL, AT_RSP_OK))
+  {
+    return false;
+  }
+  bearerStatus = BEARER_CLOSED;
+  bearerIp[0] = 0;
+  return true;
+}
+
+/**
+ * Query the status of the GPRS bearer (and its IP) with AT+SAPBR=2,1
+ * Answer expected: +SAPBR: 1,<status>,"<ip>"
+ */
+SIM808Driver::BearerStatus SIM808Driver::getBearerStatus()
+{
+  if (!sendCommandCheckAnswer_P(AT_CMD_SAPBR2, NULL, AT_RSP_OK, 4))
+  {
+    bearerStatus = BEARER_ERROR;
+    return bearerStatus;
+  }
+
+  int16_t idx = strIndex(internalBuffer, "+SAPBR: 1,");
+  if (idx < 0)
+  {
+    bearerStatus = BEARER_ERROR;
+    return bearerStatus;
+  }
+
+  switch (internalBufferAt(idx + 10))
+  {
+  case '0':
+    bearerStatus = BEARER_CONNECTING;
+    break;
+  case '1':
+    bearerStatus = BEARER_CONNECTED;
+    break;
+  case '2':
+    bearerStatus = BEARER_CLOSING;
+    break;
+  case '3':
+    bearerStatus = BEARER_CLOSED;
+    break;
+  default:
+    bearerStatus = BEARER_ERROR;
+  }
+
+  // Extract the IP between the quotes
+  bearerIp[0] = 0;
+  int16_t idxIp = strIndex(internalBuffer, "\"", idx);
+  if (bearerStatus == BEARER_CONNECTED && idxIp > 0)
+  {
+    uint8_t i = 0;
+    while (i < sizeof(bearerIp) - 1 && internalBuffer[idxIp + 1 + i] != '"' && internalBuffer[idxIp + 1 + i] != 0)
+    {
+      bearerIp[i] = internalBuffer[idxIp + 1 + i];
+      i++;
+    }
+    bearerIp[i] = 0;
+  }
+
+  return bearerStatus;
+}
+
+/**
+ * Close the bearer if it was not used since the idle timeout (to call in the loop)
+ * Returns true if the bearer was closed
+ */
+bool SIM808Driver::maintainGPRS()
+{
+  if (bearerIdleTimeout == 0 || bearerStatus != BEARER_CONNECTED)
+  {
+    return false;
+  }
+  if (millis() - bearerLastActivity < bearerIdleTimeout)
+  {
+    return false;
+  }
+
+  SIM808_LOG(LOG_INFO, PSTR("maintainGPRS() - Bearer idle, disconnect"));
+  return disconnectGPRS();
+}
+
+/**
+ * Define the time the bearer is kept up without activity (0 to disable, default)
+ */
+void SIM808Driver::setBearerIdleTimeout(uint32_t timeoutMs)
+{
+  bearerIdleTimeout = timeoutMs;
+}
+
+/**
+ * Return the IP assigned to the bearer (empty if not connected) at the last status query
+ */
+const char *SIM808Driver::getBearerIp()
+{
+  return bearerIp;
+}
+
+/**
+ * Return the duration of the last bearer opening in milli-seconds
+ */
+uint32_t SIM808Driver::getBearerConnectTime()
+{
+  return bearerConnectTime;
+}
+
+/**
+ * Return the number of times the bearer was opened
+ */
+uint16_t SIM808Driver::getBearerConnectCount()
+{
+  return bearerConnectCount;
+}
+
+/**
+ * Define the power mode
+ * Available : POW_MINIMUM, POW_NORMAL, POW_SLEEP
+ * Return true is the mode is correctly switched
+ */
+bool SIM808Driver::setPowerMode(PowerMode powerMode)
+{
+  // Check if the power mode requested is not ERROR or UNKNOWN
+  if (powerMode == POW_ERROR || powerMode == POW_UNKNOWN)
+  {
+    return false;
+  }
+
+  // Check the current power mode
+  PowerMode currentPowerMode = getPowerMode();
+
+  // If the current power mode is undefined, abord
+  if (currentPowerMode == POW_ERROR || currentPowerMode == POW_UNKNOWN)
+  {
+    return false;
+  }
+
+  // If the current power mode is the same that the requested power mode, say it's OK
+  if (currentPowerMode == powerMode)
+  {
+    return true;
+  }
+
+  // If POW_SLEEP or POW_MINIMUM, only POW_NORMAL is allowed
+  if ((currentPowerMode == POW_SLEEP || currentPowerMode == POW_MINIMUM) && (powerMode != POW_NORMAL))
+  {
+    return false;
+  }
+
+  // Send the command
+  switch (powerMode)
+  {
+  case POW_MINIMUM:
+    sendCommand_P(AT_CMD_CFUN0);
+    break;
+  case POW_SLEEP:
+    sendCommand_P(AT_CMD_CFUN4);
+    break;
+  case POW_NORMAL:
+  default:
+    sendCommand_P(AT_CMD_CFUN1);
+  }
+
+  // Read but don't care about the result
+  purgeSerial();
+
+  // Check the current power mode
+  currentPowerMode = getPowerMode();
+
+  // If the current power mode is the same that the requested power mode, say it's OK
+  return currentPowerMode == powerMode;
+}
+
+#if SIM808_STATUS
+/**
+ * Status function: Check the strengh of the signal
+ */
+uint8_t SIM808Driver::getSignal()
+{
+  sendCommand_P(AT_CMD_CSQ);
+  if (readResponse(POLICY_TIMEOUT))
+  {
+    // Answer: +CSQ: <rssi>,<ber>
+    int16_t idx = strIndex(internalBuffer, "+CSQ: ");
+    if (idx < 0)
+    {
+      return 0;
+    }
+    int16_t value = atoi(&internalBuffer[idx + 6]);
+    if (value < 0 || value > 31)
+    {
+      return 0;
+    }
+    return value;
+  }
+  return 0;
+}
+
+#endif // SIM808_STATUS
+
+/*****************************************************************************************
+ * HELPERS
+ *****************************************************************************************/
+
+/**
+ * Find string "findStr" in another string "str" (from startIdx)
+ * Returns the index of the first occurrence, -1 if not found
+ */
+int16_t SIM808Driver::strIndex(const char *str, const char *findStr, uint16_t startIdx)
+{
+  if (str == NULL || findStr[0] == 0 || startIdx >= strlen(str))
+  {
+    return -1;
+  }
+  const char *found = strstr(str + startIdx, findStr);
+  return found != NULL ? found - str : -1;
+}
+
+/**
+ * Character of the internal buffer at idx, 0 if idx is out of the buffer
+ * The buffer is zeroed before each reading, so the characters after the answer are 0 too
+ */
+char SIM808Driver::internalBufferAt(int16_t idx)
+{
+  if (idx < 0 || idx >= internalBufferSize)
+  {
+    return 0;
+  }
+  return internalBuffer[idx];
+}
+
+/**
+ * Index of the information answer without prefix (e.g. AT+GMR, AT+CCID) in the internal buffer
+ * The echo of the command (if any) and the empty lines are skipped, -1 if there is no answer
+ */
+int16_t SIM808Driver::informationIndex()
+{
+  int16_t idx = 0;
+  if (internalBuffer[0] == 'A' && internalBuffer[1] == 'T')
+  {
+    idx = strIndex(internalBuffer, "\r");
+    if (idx < 0)
     {
-      recvBuffer[i] = internalBuffer[idx + i];
+      return -1;
     }
-    return getDataReceived();
+  }
+
+  while (internalBuffer[idx] == '\r' || internalBuffer[idx] == '\n')
+  {
+    idx++;
+  }
+  return internalBuffer[idx] != 0 ? idx : -1;
+}
+
+/**
+ * Copy the part [idx, idxEnd[ of the internal buffer as a string in the reception buffer
+ * Returns NULL if the bounds are not valid
+ */
+char *SIM808Driver::copyToRecvBuffer(int16_t idx, int16_t idxEnd)
+{
+  if (idx < 0 || idxEnd <= idx || recvBufferSize == 0)
+  {
+    return NULL;
+  }
+
+  initRecvBuffer();
+  for (int16_t i = 0; i < idxEnd - idx && i < recvBufferSize - 1; i++)
+  {
+    recvBuffer[i] = internalBuffer[idx + i];
+  }
+  return getDataReceived();
+}
+
+/**
+ * Init internal buffer
+ */
+void SIM808Driver::initInternalBuffer()
+{
+  for (uint16_t i = 0; i < internalBufferSize; i++)
+  {
+    internalBuffer[i] = 0;
+  }
+}
+
+/**
+ * Init recv buffer
+ */
+void SIM808Driver::initRecvBuffer()
+{
+  // Cleanup the receive buffer
+  for (uint16_t i = 0; i < recvBufferSize; i++)
+  {
+    recvBuffer[i] = 0;
+  }
+}
+
+/*****************************************************************************************
+ * LOW LEVEL FUNCTIONS TO COMMUNICATE WITH THE SIM808 MODULE
+ *****************************************************************************************/
+
+/**
+ * Send AT command to the module
+ */
+void SIM808Driver::sendCommand(const char *command)
+{
+  txBegin();
+  loadPolicy(command);
+  SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s\""), command);
+
+  txAppend(command);
+  txEnd();
+}
+
+/**
+ * Send AT command coming from the PROGMEM
+ */
+void SIM808Driver::sendCommand_P(const char *command)
+{
+  // The commands in PROGMEM are shorter than the staging buffer, the policy is found from it
+  txBegin();
+  txAppend_P(command);
+  loadPolicy(txBuffer);
+  SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s\""), txBuffer);
+
+  txEnd();
+}
+
+/**
+ * Send AT command to the module with a parameter
+ */
+void SIM808Driver::sendCommand(const char *command, const char *parameter)
+{
+  txBegin();
+  loadPolicy(command);
+  SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s\"%s\"\""), command, parameter);
+
+  txAppend(command);
+  txPut('"');
+  txAppendParameter(parameter);
+  txPut('"');
+  txEnd();
+}
+
+/**
+ * Send AT command coming from the PROGMEM with a parameter
+ */
+void SIM808Driver::sendCommand_P(const char *command, const char *parameter)
+{
+  txBegin();
+  txAppend_P(command);
+  loadPolicy(txBuffer);
+#if SIM808_HTTP
+  if (parameterTemplate)
+  {
+    SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s\" with a template"), txBuffer);
   }
   else
+#endif
+    SIM808_LOG(LOG_DEBUG, PSTR("Send \"%s\"%s\"\""), txBuffer, parameter);
+
+  txPut('"');
+  txAppendParameter(parameter);
+  txPut('"');
+  txEnd();
+}
+
+/**
+ * Start a command line: the pending debug messages are written, the URCs received are kept and the
+ * other stale bytes are dropped
+ */
+void SIM808Driver::txBegin()
+{
+  // Nothing is expected from the module before the command, the pending messages can be written
+  flushLog();
+  // A late answer of a previous command would be taken for the answer of this one, the URCs are kept
+  keepURC();
+
+  txUsed = 0;
+  txBuffer[0] = 0;
+#if SIM808_METRICS
+  txStart = micros();
+  metrics.commands++;
+#endif
+}
+
+/**
+ * Append a string to the command line
+ */
+void SIM808Driver::txAppend(const char *data)
+{
+  while (*data)
   {
-    return NULL;
+    txPut(*data++);
   }
 }
 
 /**
- * Status function: Requests the simcard number
+ * Append a string from PROGMEM to the command line (no copy in RAM)
  */
-char *SIM808Driver::getSimCardNumber()
+void SIM808Driver::txAppend_P(const char *data)
 {
-  sendCommand_P(AT_CMD_SIM_CARD);
-  if (readResponse(DEFAULT_TIMEOUT))
+  char c;
+  while ((c = pgm_read_byte(data++)) != 0)
   {
-    int16_t idx = strIndex(internalBuffer, "AT+CCID") + 10;
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx + 1);
-
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for (uint16_t i = 0; i < idxEnd - idx; i++)
-    {
-      recvBuffer[i] = internalBuffer[idx + i];
-    }
-    return getDataReceived();
+    txPut(c);
   }
-  else
+}
+
+/**
+ * Append a parameter to the command line, from a template in PROGMEM during doGet_P/doPost_P
+ */
+void SIM808Driver::txAppendParameter(const char *parameter)
+{
+#if SIM808_HTTP
+  if (parameterTemplate)
   {
-    return NULL;
+    txAppendTemplate_P(parameter);
+    return;
   }
+#endif
+  txAppend(parameter);
 }
 
+#if SIM808_HTTP
 /**
- * Status function: Check if the module is registered on the network
+ * Append a template from PROGMEM, the placeholders {0} to {9} being replaced by the values of the request
+ * (placeholders without value are written as is)
  */
-SIM808Driver::NetworkRegistration SIM808Driver::getRegistrationStatus()
+void SIM808Driver::txAppendTemplate_P(const char *data)
 {
-  sendCommand_P(AT_CMD_CREG_TEST);
-  if (readResponse(DEFAULT_TIMEOUT))
+  char c;
+  while ((c = pgm_read_byte(data++)) != 0)
   {
-    // Check if there is an error
-    int16_t errIdx = strIndex(internalBuffer, "ERROR");
-    if (errIdx > 0)
+    char index = pgm_read_byte(data);
+    if (c == '{' && index >= '0' && index <= '9' && pgm_read_byte(data + 1) == '}' && index - '0' < templateValueCount)
     {
-      return NET_ERROR;
+      const char *value = templateValues[index - '0'];
+      if (value != NULL)
+      {
+        txAppend(value);
+      }
+      data += 2;
     }
-
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "+CREG: ");
-    char value = internalBuffer[idx + 9];
-
-    // Prepare the clear output
-    switch (value)
+    else
     {
-    case '0':
-      return NET_NOT_REGISTERED;
-    case '1':
-      return NET_REGISTERED_HOME;
-    case '2':
-      return NET_SEARCHING;
-    case '3':
-      return NET_DENIED;
-    case '5':
-      return NET_REGISTERED_ROAMING;
-    default:
-      return NET_UNKNOWN;
+      txPut(c);
     }
   }
-
-  return NET_ERROR;
 }
+#endif
 
 /**
- * Setup the GPRS connectivity
- * As input, give the APN string of the operator
+ * Append a character to the command line, the staging buffer is written when full
  */
-bool SIM808Driver::setupGPRS(const char *apn)
+void SIM808Driver::txPut(char c)
 {
-  // Prepare the GPRS connection as the bearer
-  sendCommand_P(AT_CMD_SAPBR_GPRS);
-  if (!readResponseCheckAnswer_P(20000, AT_RSP_OK))
+  if (txUsed >= sizeof(txBuffer) - 1)
   {
-    return false;
+    txWrite();
   }
-
-  // Set the config of the bearer with the APN
-  sendCommand_P(AT_CMD_SAPBR_APN, apn);
-  return readResponseCheckAnswer_P(20000, AT_RSP_OK);
+  txBuffer[txUsed++] = c;
+  txBuffer[txUsed] = 0;
 }
 
 /**
- * Open the GPRS connectivity
+ * Write the staging buffer on the module
  */
-bool SIM808Driver::connectGPRS()
+void SIM808Driver::txWrite()
 {
-  sendCommand_P(AT_CMD_SAPBR1);
-  // Timout is max 85 seconds according to SIM808 specifications
-  // We will wait for 65s to be within uint16_t
-  return readResponseCheckAnswer_P(65000, AT_RSP_OK);
+  stream->write((const uint8_t *)txBuffer, txUsed);
+#if SIM808_METRICS
+  metrics.txBytes += txUsed;
+#endif
+  txUsed = 0;
+  txBuffer[0] = 0;
 }
 
 /**
- * Close the GPRS connectivity
+ * End the command line and write it, the answer is left to the reading functions
  */
-bool SIM808Driver::disconnectGPRS()
+void SIM808Driver::txEnd()
 {
-  sendCommand_P(AT_CMD_SAPBR0);
-  // Timout is max 65 seconds according to SIM808 specifications
-  return readResponseCheckAnswer_P(65000, AT_RSP_OK);
+  txPut('\r');
+  txPut('\n');
+  txWrite();
+#if SIM808_METRICS
+  metrics.txTime += micros() - txStart;
+#endif
 }
 
+#if SIM808_FS || SIM808_FTP
 /**
- * Define the power mode
- * Available : POW_MINIMUM, POW_NORMAL, POW_SLEEP
- * Return true is the mode is correctly switched
+ * Write size bytes read from a source on the module, without any buffer
+ * False if the source has no more data before the end
  */
-bool SIM808Driver::setPowerMode(PowerMode powerMode)
+bool SIM808Driver::writeFromSource(Stream *source, uint16_t size)
 {
-  // Check if the power mode requested is not ERROR or UNKNOWN
-  if (powerMode == POW_ERROR || powerMode == POW_UNKNOWN)
-  {
-    return false;
-  }
-
-  // Check the current power mode
-  PowerMode currentPowerMode = getPowerMode();
-
-  // If the current power mode is undefined, abord
-  if (currentPowerMode == POW_ERROR || currentPowerMode == POW_UNKNOWN)
-  {
-    return false;
-  }
-
-  // If the current power mode is the same that the requested power mode, say it's OK
-  if (currentPowerMode == powerMode)
+  uint32_t timerStart = millis();
+  for (uint16_t i = 0; i < size;)
   {
-    return true;
+    if (source->available())
+    {
+      stream->write((uint8_t)source->read());
+      i++;
+      timerStart = millis();
+    }
+    else if (millis() - timerStart > DEFAULT_TIMEOUT)
+    {
+      SIM808_LOG(LOG_ERROR, PSTR("writeFromSource() - Timeout while reading the source"));
+      return false;
+    }
   }
+  return true;
+}
+#endif
 
-  // If POW_SLEEP or POW_MINIMUM, only POW_NORMAL is allowed
-  if ((currentPowerMode == POW_SLEEP || currentPowerMode == POW_MINIMUM) && (powerMode != POW_NORMAL))
+/**
+ * Send AT command coming from the PROGMEM (with a parameter if not NULL) and expect a specific answer
+ * The command is retried following its policy when it is idempotent
+ */
+bool SIM808Driver::sendCommandCheckAnswer_P(const char *command, const char *parameter, const char *expectedAnswer, uint8_t crlfToWait)
+{
+  for (uint8_t attempt = 0;; attempt++)
   {
-    return false;
-  }
+    if (parameter != NULL)
+    {
+      sendCommand_P(command, parameter);
+    }
+    else
+    {
+      sendCommand_P(command);
+    }
 
-  // Send the command
-  char value;
-  switch (powerMode)
-  {
-  case POW_MINIMUM:
-    sendCommand_P(AT_CMD_CFUN0);
-    break;
-  case POW_SLEEP:
-    sendCommand_P(AT_CMD_CFUN4);
-    break;
-  case POW_NORMAL:
-  default:
-    sendCommand_P(AT_CMD_CFUN1);
-  }
+    if (readResponseCheckAnswer_P(POLICY_TIMEOUT, expectedAnswer, crlfToWait))
+    {
+      return true;
+    }
 
-  // Read but don't care about the result
-  purgeSerial();
+    if (!currentPolicy.idempotent || attempt >= currentPolicy.retries)
+    {
+      return false;
+    }
 
-  // Check the current power mode
-  currentPowerMode = getPowerMode();
+    SIM808_LOG(LOG_WARNING, PSTR("Retry command"));
+#if SIM808_METRICS
+    metrics.retries++;
+#endif
 
-  // If the current power mode is the same that the requested power mode, say it's OK
-  return currentPowerMode == powerMode;
+    // Exponential backoff between the attempts
+    delay((uint32_t)currentPolicy.backoff << attempt);
+  }
 }
 
 /**
- * Status function: Check the strengh of the signal
+ * Load the policy of the command (default policy if not found in the table)
  */
-uint8_t SIM808Driver::getSignal()
+void SIM808Driver::loadPolicy(const char *command)
 {
-  sendCommand_P(AT_CMD_CSQ);
-  if (readResponse(DEFAULT_TIMEOUT))
+  for (uint8_t i = 0; i < sizeof(COMMAND_POLICIES) / sizeof(COMMAND_POLICIES[0]); i++)
   {
-    int16_t idxBase = strIndex(internalBuffer, "AT+CSQ");
-    if (idxBase != 0)
-    {
-      return 0;
-    }
-    int16_t idxEnd = strIndex(internalBuffer, ",", idxBase);
-    uint8_t value = internalBuffer[idxEnd - 1] - '0';
-    if (internalBuffer[idxEnd - 2] != ' ')
-    {
-      value += (internalBuffer[idxEnd - 2] - '0') * 10;
-    }
-    if (value > 31)
+    const char *prefix = (const char *)pgm_read_ptr(&COMMAND_POLICIES[i].command);
+    uint8_t length = strlen_P(prefix);
+    // The bare "AT" prefix only matches the AT command itself
+    if (strncmp_P(command, prefix, length) == 0 && (length > 2 || command[length] == 0))
     {
-      return 0;
+      memcpy_P(&currentPolicy, &COMMAND_POLICIES[i], sizeof(CommandPolicy));
+      return;
     }
-    return value;
   }
-  return 0;
+
+  currentPolicy.command = NULL;
+  currentPolicy.timeout = DEFAULT_TIMEOUT;
+  currentPolicy.retries = 0;
+  currentPolicy.backoff = 0;
+  currentPolicy.idempotent = false;
 }
 
-/*****************************************************************************************
- * HELPERS
- *****************************************************************************************/
+/**
+ * Start a new result for a network call (all the counters are cleared)
+ */
+void SIM808Driver::startResult()
+{
+  memset(&lastResult, 0, sizeof(RequestResult));
+  currentStage = STAGE_NONE;
+  stageStart = millis();
+}
 
 /**
- * Find string "findStr" in another string "str"
- * Returns true if found, false elsewhere
+ * Account the time spent in the current stage and enter the next one
  */
-int16_t SIM808Driver::strIndex(const char *str, const char *findStr, uint16_t startIdx)
+void SIM808Driver::enterStage(RequestStage stage)
 {
-  int16_t firstIndex = -1;
-  int16_t sizeMatch = 0;
-  for (int16_t i = startIdx; i < strlen(str); i++)
+  uint32_t now = millis();
+  lastResult.stageTime[currentStage] += now - stageStart;
+#if SIM808_METRICS
+  if (currentStage != STAGE_NONE)
   {
-    if (sizeMatch >= strlen(findStr))
+    uint8_t bucket = 0;
+    while (bucket < METRICS_BUCKETS - 1 && now - stageStart >= getMetricsBucketLimit(bucket))
     {
-      break;
+      bucket++;
     }
-    if (str[i] == findStr[sizeMatch])
+    if (metrics.stageLatency[currentStage][bucket] < 0xFFFF)
     {
-      if (firstIndex < 0)
-      {
-        firstIndex = i;
-      }
-      sizeMatch++;
+      metrics.stageLatency[currentStage][bucket]++;
     }
-    else
+    if (currentStage == STAGE_ACTION && lastResult.secure && metrics.secureActionLatency[bucket] < 0xFFFF)
     {
-      firstIndex = -1;
-      sizeMatch = 0;
+      metrics.secureActionLatency[bucket]++;
     }
   }
+#endif
+  stageStart = now;
+  currentStage = stage;
+}
 
-  if (sizeMatch >= strlen(findStr))
+/**
+ * End the result with its return code and the stage which failed (STAGE_NONE if successful)
+ */
+uint16_t SIM808Driver::closeResult(uint16_t code, RequestStage failedStage)
+{
+  // The bearer was used until now: a long transfer does not count as idle time (see maintainGPRS())
+  if (currentStage > STAGE_BEARER)
   {
-    return firstIndex;
+    bearerLastActivity = millis();
   }
-  else
+  enterStage(STAGE_NONE);
+  flushLog();
+  lastResult.code = code;
+  lastResult.stage = failedStage;
+#if SIM808_METRICS
+  metrics.bytesSent += lastResult.bytesSent;
+  metrics.bytesReceived += lastResult.bytesReceived;
+  if (lastResult.secure && (lastResult.moduleError == 605 || lastResult.moduleError == 606))
   {
-    return -1;
+    metrics.sslErrors++;
   }
+#endif
+  return code;
 }
 
 /**
- * Init internal buffer
+ * End the result on a failure of the current stage
  */
-void SIM808Driver::initInternalBuffer()
+uint16_t SIM808Driver::failResult(uint16_t code)
 {
-  for (uint16_t i = 0; i < internalBufferSize; i++)
-  {
-    internalBuffer[i] = 0;
-  }
+  return closeResult(code, currentStage);
 }
 
 /**
- * Init recv buffer
+ * Write the pending log messages on the debug stream (oldest first)
+ * Called before sending a command and at the end of the network calls, when nothing is received
  */
-void SIM808Driver::initRecvBuffer()
+void SIM808Driver::flushLog()
 {
-  // Cleanup the receive buffer
-  for (uint16_t i = 0; i < recvBufferSize; i++)
+#if SIM808_DEBUG
+  while (logUsed > 0)
+  {
+    uint16_t tail = (logHead + SIM808_LOG_BUFFER - logUsed) % SIM808_LOG_BUFFER;
+    uint8_t level = logBuffer[tail];
+    tail = (tail + 1) % SIM808_LOG_BUFFER;
+    logUsed--;
+
+    debugStream->print(F("SIM808Driver "));
+    debugStream->print(level == LOG_ERROR ? 'E' : level == LOG_WARNING ? 'W' : level == LOG_INFO ? 'I' : 'D');
+    debugStream->print(F(" : "));
+    while (logBuffer[tail] != 0)
+    {
+      debugStream->print(logBuffer[tail]);
+      tail = (tail + 1) % SIM808_LOG_BUFFER;
+      logUsed--;
+    }
+    logUsed--;
+    debugStream->println();
+  }
+
+  if (logDropped > 0)
   {
-    recvBuffer[i] = 0;
+    debugStream->print(F("SIM808Driver W : "));
+    debugStream->print(logDropped);
+    debugStream->println(F(" messages lost (log buffer full)"));
+    logDropped = 0;
   }
+#endif
 }
 
-/*****************************************************************************************
- * LOW LEVEL FUNCTIONS TO COMMUNICATE WITH THE SIM808 MODULE
- *****************************************************************************************/
-
+#if SIM808_DEBUG
 /**
- * Send AT command to the module
+ * Format a message (format in PROGMEM) and store it in the log buffer with its level
+ * The message is dropped if the buffer is full
  */
-void SIM808Driver::sendCommand(const char *command)
+void SIM808Driver::logMessage_P(uint8_t level, const char *format, ...)
 {
-  if (enableDebug)
+  char line[SIM808_LOG_LINE];
+  va_list args;
+  va_start(args, format);
+  vsnprintf_P(line, sizeof(line), format, args);
+  va_end(args);
+
+  uint16_t size = strlen(line) + 2;
+  if (SIM808_LOG_BUFFER - logUsed < size)
   {
-    debugStream->print(F("SIM808Driver : Send \""));
-    debugStream->print(command);
-    debugStream->println(F("\""));
+    logDropped++;
+    return;
   }
 
-  purgeSerial();
-  stream->write(command);
-  stream->write("\r\n");
-  purgeSerial();
-}
-
-/**
- * Send AT command coming from the PROGMEM
- */
-void SIM808Driver::sendCommand_P(const char *command)
-{
-  char cmdBuff[32];
-  strcpy_P(cmdBuff, command);
-  sendCommand(cmdBuff);
+  logBuffer[logHead] = level;
+  logHead = (logHead + 1) % SIM808_LOG_BUFFER;
+  for (uint16_t i = 0; i < size - 1; i++)
+  {
+    logBuffer[logHead] = line[i];
+    logHead = (logHead + 1) % SIM808_LOG_BUFFER;
+  }
+  logUsed += size;
 }
+#endif
 
 /**
- * Send AT command to the module with a parameter
+ * Purge the serial data received
  */
-void SIM808Driver::sendCommand(const char *command, const char *parameter)
+void SIM808Driver::purgeSerial()
 {
-  if (enableDebug)
+  while (stream->available())
   {
-    debugStream->print(F("SIM808Driver : Send \""));
-    debugStream->print(command);
-    debugStream->print(F("\""));
-    debugStream->print(parameter);
-    debugStream->print(F("\""));
-    debugStream->println(F("\""));
+    stream->read();
   }
-
-  purgeSerial();
-  stream->write(command);
-  stream->write("\"");
-  stream->write(parameter);
-  stream->write("\"");
-  stream->write("\r\n");
-  purgeSerial();
+  // The URC line being received is dropped with the rest
+  urcUsed = 0;
 }
 
 /**
- * Send AT command coming from the PROGMEM with a parameter
+ * Keep the URC lines received before a command for readURC(), the rest of the stale bytes is dropped
+ * A line being received is waited for URC_LINE_TIMEOUT ms: the command would cut it
  */
-void SIM808Driver::sendCommand_P(const char *command, const char *parameter)
+void SIM808Driver::keepURC()
 {
-  char cmdBuff[32];
-  strcpy_P(cmdBuff, command);
-  sendCommand(cmdBuff, parameter);
+  uint32_t timerStart = millis();
+  while (stream->available() || (urcUsed > 0 && millis() - timerStart < URC_LINE_TIMEOUT))
+  {
+    if (stream->available() && urcPut(stream->read()))
+    {
+      queueURC();
+    }
+  }
+  // The end of a line still incomplete comes with the answer of the command
+  urcUsed = 0;
 }
 
 /**
- * Purge the serial data
+ * Keep the URC line just completed for readURC() (dropped if the queue is full)
  */
-void SIM808Driver::purgeSerial()
+void SIM808Driver::queueURC()
 {
-  stream->flush();
-  while (stream->available())
+  if (urcQueueCount < URC_QUEUE_SIZE)
   {
-    stream->read();
+    strcpy(urcQueue[(urcQueueHead + urcQueueCount) % URC_QUEUE_SIZE], urcBuffer);
+    urcQueueCount++;
+  }
+  else
+  {
+    SIM808_LOG(LOG_WARNING, PSTR("URC \"%s\" dropped"), urcBuffer);
   }
-  stream->flush();
 }
 
 /**
  * Read from module and expect a specific answer (timeout in millisec)
  */
-bool SIM808Driver::readResponseCheckAnswer_P(uint16_t timeout, const char *expectedAnswer, uint8_t crlfToWait)
+bool SIM808Driver::readResponseCheckAnswer_P(uint32_t timeout, const char *expectedAnswer, uint8_t crlfToWait)
 {
   if (readResponse(timeout, crlfToWait))
   {
@@ -1276,11 +3649,72 @@ bool SIM808Driver::readResponseCheckAnswer_P(uint16_t timeout, const char *expec
 
     // Check if it's the expected answer
     int16_t idx = strIndex(internalBuffer, rspBuff);
-    if (idx > 0)
+    if (idx >= 0)
+    {
+      return true;
+    }
+
+    // Keep the error code of the module (numeric format enabled by enableModuleErrorCodes())
+    idx = strIndex(internalBuffer, "+CME ERROR: ");
+    if (idx >= 0)
+    {
+      lastResult.moduleError = atoi(&internalBuffer[idx + 12]);
+    }
+  }
+  return false;
+}
+
+/**
+ * Read from module until the expected answer (or the error answer) is seen, whatever the CRLF
+ * Used for answers without CRLF (prompts) or after binary data
+ * True if the expected answer was found
+ */
+bool SIM808Driver::readUntilAnswer_P(uint32_t timeout, const char *expectedAnswer, const char *errorAnswer)
+{
+  if (timeout == POLICY_TIMEOUT)
+  {
+    timeout = currentPolicy.timeout;
+  }
+
+  char rspBuff[16];
+  char errBuff[16] = "";
+  strcpy_P(rspBuff, expectedAnswer);
+  if (errorAnswer != NULL)
+  {
+    strcpy_P(errBuff, errorAnswer);
+  }
+  uint8_t rspMatch = 0;
+  uint8_t errMatch = 0;
+
+  uint32_t timerStart = millis();
+  while (millis() - timerStart <= timeout)
+  {
+    if (!stream->available())
+    {
+      continue;
+    }
+    char c = stream->read();
+
+    rspMatch = (c == rspBuff[rspMatch]) ? rspMatch + 1 : (c == rspBuff[0] ? 1 : 0);
+    if (rspBuff[rspMatch] == 0)
     {
       return true;
     }
+
+    if (errBuff[0] != 0)
+    {
+      errMatch = (c == errBuff[errMatch]) ? errMatch + 1 : (c == errBuff[0] ? 1 : 0);
+      if (errBuff[errMatch] == 0)
+      {
+        return false;
+      }
+    }
   }
+
+  SIM808_LOG(LOG_WARNING, PSTR("Receive timeout"));
+#if SIM808_METRICS
+  metrics.timeouts++;
+#endif
   return false;
 }
 
@@ -1288,12 +3722,23 @@ bool SIM808Driver::readResponseCheckAnswer_P(uint16_t timeout, const char *expec
  * Read from the module for a specific number of CRLF
  * True if we have some data
  */
-bool SIM808Driver::readResponse(uint16_t timeout, uint8_t crlfToWait)
+bool SIM808Driver::readResponse(uint32_t timeout, uint8_t crlfToWait)
 {
+  if (timeout == POLICY_TIMEOUT)
+  {
+    timeout = currentPolicy.timeout;
+  }
+
   uint16_t currentSizeResponse = 0;
   bool seenCR = false;
   uint8_t countCRLF = 0;
 
+  // No buffer, nothing can be received
+  if (internalBufferSize < 2)
+  {
+    return false;
+  }
+
   // First of all, cleanup the buffer
   initInternalBuffer();
 
@@ -1317,8 +3762,7 @@ bool SIM808Driver::readResponse(uint16_t timeout, uint8_t crlfToWait)
         countCRLF++;
         if (countCRLF == crlfToWait)
         {
-          if (enableDebug)
-            debugStream->println(F("SIM808Driver : End of transmission"));
+          SIM808_LOG(LOG_DEBUG, PSTR("End of transmission"));
           break;
         }
       }
@@ -1330,11 +3774,13 @@ bool SIM808Driver::readResponse(uint16_t timeout, uint8_t crlfToWait)
       // Prepare for next read
       currentSizeResponse++;
 
-      // Avoid buffer overflow
-      if (currentSizeResponse == internalBufferSize)
+      // Avoid buffer overflow (the last byte is kept for the end of string)
+      if (currentSizeResponse == internalBufferSize - 1)
       {
-        if (enableDebug)
-          debugStream->println(F("SIM808Driver : Received maximum buffer size"));
+        SIM808_LOG(LOG_WARNING, PSTR("Received maximum buffer size"));
+#if SIM808_METRICS
+        metrics.overflows++;
+#endif
         break;
       }
     }
@@ -1342,19 +3788,16 @@ bool SIM808Driver::readResponse(uint16_t timeout, uint8_t crlfToWait)
     // If timeout, abord the reading
     if (millis() - timerStart > timeout)
     {
-      if (enableDebug)
-        debugStream->println(F("SIM808Driver : Receive timeout"));
+      SIM808_LOG(LOG_WARNING, PSTR("Receive timeout"));
+#if SIM808_METRICS
+      metrics.timeouts++;
+#endif
       // Timeout, return false to parent function
       return false;
     }
   }
 
-  if (enableDebug)
-  {
-    debugStream->print(F("SIM808Driver : Receive \""));
-    debugStream->print(internalBuffer);
-    debugStream->println(F("\""));
-  }
+  SIM808_LOG(LOG_DEBUG, PSTR("Receive \"%s\""), internalBuffer);
 
   // If we are here, it's OK ;-)
   return true;
@@ -32,9 +32,27 @@
 #define _SIM808_H_
 
 #include <Arduino.h>
+#include "SIM808Config.h"
 
 #define DEFAULT_TIMEOUT 5000
+#define POLICY_TIMEOUT 0
 #define RESET_PIN_NOT_USED -1
+#define SOCKET_MAX_CONNECTIONS 6
+#define SOCKET_MAX_SEND 1460
+#define METRICS_BUCKETS 8
+#define GNSS_PARSED_FIELDS 14
+#define FS_CHUNK_SIZE 1024
+#define FTP_CHUNK_SIZE 1024
+#define URC_BUFFER_SIZE 32
+#define URC_QUEUE_SIZE 2
+#define URC_LINE_TIMEOUT 50
+
+// Levels of the log messages (see SIM808_LOG_LEVEL)
+#define LOG_NONE 0
+#define LOG_ERROR 1
+#define LOG_WARNING 2
+#define LOG_INFO 3
+#define LOG_DEBUG 4
 
 class SIM808Driver
 {
@@ -45,9 +63,11 @@ public:
   //  _pinRst (optional) : pin to the reset of the SIM808 module
   //  _internalBufferSize (optional): size in bytes of the internal buffer to handle general IO with the module
   //                        (including URL and maximum payload to send through POST method)
-  //  _recvBufferSize (optional) : size in bytes of the reception buffer (max data to receive from GET or POST)
+  //  _recvBufferSize (optional) : size in bytes of the reception buffer (max data to receive from GET or POST, plus one byte for the end of string)
   //  _debugStream (optional) : Stream opened to the debug console (Software of Hardware)
   SIM808Driver(Stream *_stream, uint8_t _pinRst = RESET_PIN_NOT_USED, uint16_t _internalBufferSize = 256, uint16_t _recvBufferSize = 512, Stream *_debugStream = NULL);
+  // Initialize the driver with buffers given by the caller (nothing is allocated)
+  SIM808Driver(Stream *_stream, uint8_t _pinRst, char *_internalBuffer, uint16_t _internalBufferSize, char *_recvBuffer, uint16_t _recvBufferSize, Stream *_debugStream = NULL);
   ~SIM808Driver();
 
   // Enums & Structures
@@ -80,11 +100,88 @@ public:
     GNSS_ERROR
   };
 
+  enum BearerStatus
+  {
+    BEARER_CONNECTING,
+    BEARER_CONNECTED,
+    BEARER_CLOSING,
+    BEARER_CLOSED,
+    BEARER_ERROR
+  };
+
+  enum SocketType
+  {
+    SOCKET_TCP,
+    SOCKET_UDP
+  };
+
+  // Options of the SSL stack of the module (AT+SSLOPT)
+  enum SSLOption
+  {
+    SSL_IGNORE_INVALID_CERTIFICATE = 0,
+    SSL_CLIENT_AUTHENTICATION = 1
+  };
+
+  // Stages of a network call (STAGE_NONE is the time spent outside the stages, e.g. compression)
+  enum RequestStage
+  {
+    STAGE_NONE,
+    STAGE_BEARER,     // GPRS bearer connection
+    STAGE_INIT,       // HTTP session init
+    STAGE_PARAMETERS, // URL, headers, content type
+    STAGE_SSL,        // HTTP/HTTPS switch
+    STAGE_SEND,       // Payload upload (HTTP POST, socket send, FTP put)
+    STAGE_ACTION,     // Wait for the server: DNS, TCP, TLS and server time (HTTP action, socket connection, FTP session)
+    STAGE_READ,       // Data download (HTTP read, socket read, FTP get)
+    STAGE_TERMINATE,  // HTTP or FTP session termination
+    STAGE_COUNT
+  };
+
+  // Detailed result of the last network call
+  struct RequestResult
+  {
+    uint16_t code;                    // Code returned by the call (HTTP status or 7xx error, 0 for the boolean calls)
+    RequestStage stage;               // Stage which failed, STAGE_NONE if successful
+    uint16_t moduleError;             // Raw error of the module (+CME ERROR, 6xx status of +HTTPACTION, FTP error), 0 if none
+    uint32_t stageTime[STAGE_COUNT]; // Time spent in each stage (ms)
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+    bool secure;                      // HTTPS request: the action stage includes the TLS handshake
+  };
+
+#if SIM808_METRICS
+  // Counters and latency histograms (fixed buckets, see getMetricsBucketLimit())
+  struct Metrics
+  {
+    uint32_t commands;      // AT commands sent
+    uint32_t retries;       // Commands sent again following their policy
+    uint32_t timeouts;      // Receive timeouts
+    uint32_t overflows;     // Answers or data truncated to the size of the buffers
+    uint32_t bytesSent;     // Payload bytes sent (HTTP, sockets)
+    uint32_t bytesReceived; // Payload bytes received (HTTP, sockets)
+    uint32_t txBytes;       // Bytes of the AT command lines written
+    uint32_t txTime;        // Time spent to write the AT command lines (microsec)
+    uint32_t sslErrors;     // HTTPS requests failed with a SSL error of the module (605, 606)
+    uint16_t stageLatency[STAGE_COUNT][METRICS_BUCKETS];
+    uint16_t secureActionLatency[METRICS_BUCKETS]; // Action stage of the HTTPS requests only (with the TLS handshake)
+  };
+#endif
+
+  // Timeout and retry policy of a command (see the policy table)
+  struct CommandPolicy
+  {
+    const char *command;
+    uint32_t timeout;
+    uint8_t retries;
+    uint16_t backoff;
+    bool idempotent;
+  };
+
   struct GnssInfo
   {
-    char utc[18];
-    char latitude[10];
-    char longitude[11];
+    char utc[19];
+    char latitude[11];
+    char longitude[12];
     float altitude;
     float speed;
     float heading;
@@ -101,12 +198,41 @@ public:
 
   // Status functions
   bool isReady();
-  uint8_t getSignal();
+  // Single try without retry (polling of a module which is starting)
+  bool isReady(uint16_t timeoutMs);
+  // Line sent by the module outside of the commands (URC: RDY, Call Ready, +CREG...), read without waiting
+  // Returns the line without its CRLF (valid until the next call) or NULL if no complete line was received
+  // The lines received just before a command are kept for this call (URC_QUEUE_SIZE lines at most)
+  const char *readURC();
+  // Echo of the commands by the module (set to SIM808_ECHO by the first successful isReady())
+  bool setEcho(bool enable);
+
+  // Write the pending debug messages on the debug stream (also done by the driver when nothing is received)
+  void flushLog();
+
+  // Numeric error codes of the module, kept in the result of the calls
+  bool enableModuleErrorCodes();
+  const RequestResult &getLastResult();
+
+#if SIM808_METRICS
+  // Copy of the counters and histograms since the last reset
+  void getMetrics(Metrics *snapshot);
+  void resetMetrics();
+  // Upper limit (ms, excluded) of a histogram bucket, 0 for the last bucket (no limit)
+  static uint32_t getMetricsBucketLimit(uint8_t bucket);
+#endif
   PowerMode getPowerMode();
-  NetworkRegistration getRegistrationStatus();
+#if SIM808_STATUS || (SIM808_HTTP && SIM808_SSL)
   char *getVersion();
+#endif
+#if SIM808_STATUS
+  uint8_t getSignal();
+  NetworkRegistration getRegistrationStatus();
+  // URC +CREG: <stat> sent by the module when the registration changes (see readURC())
+  bool setRegistrationURC(bool enable);
   char *getFirmware();
   char *getSimCardNumber();
+#endif
 
   // Define the power mode (for parameter: see PowerMode enum)
   bool setPowerMode(PowerMode powerMode);
@@ -116,16 +242,129 @@ public:
   bool connectGPRS();
   bool disconnectGPRS();
 
+  // GPRS bearer management
+  BearerStatus getBearerStatus();
+  // Keep the bearer up between requests and close it after timeoutMs without activity (0 to disable)
+  void setBearerIdleTimeout(uint32_t timeoutMs);
+  // To call in the loop, close the bearer if idle
+  bool maintainGPRS();
+  const char *getBearerIp();
+  uint32_t getBearerConnectTime();
+  uint16_t getBearerConnectCount();
+
+#if SIM808_HTTP
   // HTTP methods
   uint16_t doGet(const char *url, uint16_t serverReadTimeoutMs);
   uint16_t doGet(const char *url, const char *headers, uint16_t serverReadTimeoutMs);
   uint16_t doPost(const char *url, const char *contentType, const char *payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
   uint16_t doPost(const char *url, const char *headers, const char *contentType, const char *payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+  // Binary-safe POST: payload may contain NUL bytes, payloadSize gives its length
+  uint16_t doPost(const char *url, const char *contentType, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+  uint16_t doPost(const char *url, const char *headers, const char *contentType, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+  // Same requests without waiting for the server: the session, the parameters and the payload are given to
+  // the module (blocking), then pollHTTP() is called in the loop until it returns the code of the request
+  // Return 0 when the request is started, or the error code. No other command can be sent to the module
+  // until pollHTTP() returned the code (it would take the answer of the server)
+  uint16_t startGet(const char *url, const char *headers, uint16_t serverReadTimeoutMs);
+  uint16_t startPost(const char *url, const char *headers, const char *contentType, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+  // Returns 0 while the server is awaited, then the code of the request (as doGet/doPost)
+  uint16_t pollHTTP();
+  bool isHTTPPending();
+  // Requests from templates in PROGMEM (URL, headers and content type): the placeholders {0} to {9} are
+  // replaced by values[0] to values[9] while the command is written, no full string is built in RAM
+  uint16_t doGet_P(const char *urlTemplate, const char *headersTemplate, const char *const *values, uint8_t valueCount, uint16_t serverReadTimeoutMs);
+  uint16_t doPost_P(const char *urlTemplate, const char *headersTemplate, const char *contentType, const char *const *values, uint8_t valueCount, const char *payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+  uint16_t doPost_P(const char *urlTemplate, const char *headersTemplate, const char *contentType, const char *const *values, uint8_t valueCount, const uint8_t *payload, uint16_t payloadSize, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+
+  // Compress POST payloads with gzip (sent with "Content-Encoding: gzip" when smaller than the original)
+  void setPayloadCompression(bool enable);
+  // Write the data received by doGet/doPost on an output (e.g. SIM808JsonExtractor) instead of the
+  // reception buffer, so the body does not have to fit in memory (NULL to use the reception buffer)
+  void setDataOutput(Print *output);
+  // Write the headers of the answers to doGet on an output (one more command per request, NULL to skip them)
+  void setHeaderOutput(Print *output);
+#if SIM808_SSL
+  // Options of the SSL stack, kept by the module until it is restarted
+  bool setSSLOption(SSLOption option, bool enable);
+#if SIM808_FS
+  // Store a certificate (CA or client .p12, password optional) in a file of the module and load it in the SSL
+  // stack; the file is only written again when the fingerprint of the certificate changed
+  bool setupSSLCertificate(const char *name, const uint8_t *certificate, uint16_t size, const char *password = NULL);
+#endif
+#endif
+#endif
+
+#if SIM808_TCPIP
+  // TCP/UDP sockets on the TCP/IP stack of the module (multi-connection mode, link number mux from 0 to 5)
+  bool startTCPIP(const char *apn);
+  bool stopTCPIP();
+  bool socketOpen(uint8_t mux, SocketType type, const char *host, uint16_t port, uint32_t connectTimeoutMs = 75000);
+  bool socketClose(uint8_t mux);
+  bool socketConnected(uint8_t mux);
+  // Blocks until the module has taken the data (size from 1 to SOCKET_MAX_SEND)
+  bool socketSend(uint8_t mux, const uint8_t *data, uint16_t size);
+  uint16_t socketAvailable(uint8_t mux);
+  uint16_t socketRead(uint8_t mux, uint8_t *buffer, uint16_t size);
+#endif
+
+#if SIM808_FS
+  // Files on the flash of the module (name without the drive, stored in C:\User\)
+  bool fileCreate(const char *name);
+  bool fileDelete(const char *name);
+  // Size of a file, -1 if it does not exist
+  int32_t fileSize(const char *name);
+  // Free space on the flash of the module in bytes, -1 on error
+  int32_t fileFreeSpace();
+  // Write in a file (created if needed), at its end or from its beginning (append false)
+  bool fileWrite(const char *name, const uint8_t *data, uint16_t size, bool append = true);
+  // Write size bytes read from a source (file on a SD card...) in chunks, returns the number of bytes written
+  uint32_t fileWrite(const char *name, Stream *source, uint32_t size, bool append = true);
+  // Read size bytes of a file from a position and write them on an output, returns the number of bytes read
+  uint32_t fileRead(const char *name, uint32_t position, uint32_t size, Print *output);
+#if SIM808_HTTP
+  // Do HTTP/S GET and store the body in a file of the module (read in chunks of the reception buffer size)
+  // Every byte goes through the board: AT+HTTPREAD into the reception buffer, then AT+FSWRITE
+  // The size of the body is given by getFileDataSize()
+  // There is no HTTP upload from a file of the module: AT+HTTPDATA takes its data from the serial, which can
+  // not read the file at the same time. The FTP transfers of files (ftpPutFromFile()) are done by the module
+  uint16_t doGetToFile(const char *url, const char *headers, const char *name, uint16_t serverReadTimeoutMs);
+  uint32_t getFileDataSize();
+#endif
+#endif
+
+#if SIM808_FTP
+  // FTP transfers on the GPRS bearer (connectGPRS() first), the strings are kept by the caller
+  void setupFTP(const char *server, uint16_t port, const char *user, const char *password);
+  // Upload size bytes read from a source in the file path/name of the server (path ending with '/')
+  // With append, the bytes are added to the file: resume an upload after the getLastResult().bytesSent
+  // bytes confirmed by the module
+  bool ftpPut(const char *path, const char *name, Stream *source, uint32_t size, bool append, uint32_t timeoutMs);
+  // Download the file path/name of the server from an offset (to resume a download) and write it on an output
+  bool ftpGet(const char *path, const char *name, Print *output, uint32_t offset, uint32_t timeoutMs);
+#if SIM808_FS
+  // Transfers between a file of the module and the server done by the module itself (AT+FTPPUTFRMFS and
+  // AT+FTPGETTOFS of the FTP application of the SIM800 series firmwares): no byte crosses the serial.
+  // The file to put is a file of the driver (fileWrite()), the file got is stored in the FTP directory of
+  // the module (fileRead("FTP\\<fileName>")). The size transferred is given by getLastResult()
+  bool ftpPutFromFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs);
+  bool ftpGetToFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs);
+  // Same transfers without waiting: the session parameters are given to the module (blocking), then the
+  // board is free (it can sleep until the serial wakes it up) and pollFTP() is called until it returns 1
+  // (file transferred) or -1 (failure, see getLastResult()). No other command can be sent meanwhile
+  bool startFTPPutFromFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs);
+  bool startFTPGetToFile(const char *path, const char *name, const char *fileName, uint32_t timeoutMs);
+  int8_t pollFTP();
+  bool isFTPPending();
+#endif
+#endif
 
   // Obtain results after HTTP successful connections (size and buffer)
-  uint16_t getDataSizeReceived();
+  uint32_t getDataSizeReceived();
   char *getDataReceived();
+  // Raw access to the data received (binary-safe, length given by getDataSizeReceived())
+  const uint8_t *getRawDataReceived();
 
+#if SIM808_GNSS
   // Initiate GNSS functionality
   bool powerOnGNSS();
   bool powerOffGNSS();
@@ -135,8 +374,12 @@ public:
   bool attachGNSS(uint8_t fix);
   bool detachGNSS();
   GnssStatus getGnssInfo(GnssInfo *gnssInfo);
+#endif
 
 protected:
+  // Common part of the constructors
+  void init(Stream *_stream, uint8_t _pinRst, Stream *_debugStream);
+
   // Send command
   void sendCommand(const char *command);
   // Send comment from PROGMEM
@@ -146,27 +389,114 @@ protected:
   // Send command with parameter within quotes from PROGMEM (template : command"parameter")
   void sendCommand_P(const char *command, const char *parameter);
 
-  // Read from module (timeout in millisec)
-  bool readResponse(uint16_t timeout, uint8_t crlfToWait = 2);
+  // Stage an AT command line and write it on the module in one call (the staging buffer is written when full)
+  void txBegin();
+  void txAppend(const char *data);
+  void txAppend_P(const char *data);
+  void txPut(char c);
+  // Append a parameter (a template from PROGMEM during doGet_P/doPost_P)
+  void txAppendParameter(const char *parameter);
+#if SIM808_HTTP
+  void txAppendTemplate_P(const char *data);
+#endif
+  void txWrite();
+  void txEnd();
+
+#if SIM808_FS || SIM808_FTP
+  // Write size bytes read from a source on the module (after a prompt), false if the source runs dry
+  bool writeFromSource(Stream *source, uint16_t size);
+#endif
+#if SIM808_FS
+  // Send a file command from PROGMEM with the path of the file and the end of the command (template: command path suffix)
+  void sendFileCommand_P(const char *command, const char *name, const char *suffix = NULL);
+  // Create the file if needed (again when not appending)
+  bool filePrepare(const char *name, bool append);
+  // Append a chunk to a file from a buffer or from a source (data NULL)
+  bool fileWriteChunk(const char *name, const uint8_t *data, Stream *source, uint16_t size);
+#endif
+#if SIM808_FTP
+  // Send the parameters of a FTP session (server, account, binary type, file to put or to get)
+  bool ftpSetup(const char *path, const char *name, bool put);
+  // Wait for the status URC of the FTP session (+FTPPUT: 1,<status>... or +FTPGET: 1,<status>), -1 on timeout
+  // The rest of the line is kept in the internal buffer
+  int16_t readFTPStatus(const char *urc, uint32_t timeout);
+#if SIM808_FS
+  // Give a file transfer to the module, its end is read by pollFTP()
+  bool startFTPFile(const char *path, const char *name, const char *fileName, bool put, uint32_t timeoutMs);
+  bool waitFTP();
+#endif
+#endif
+
+  // Send command from PROGMEM (parameter optional) and expect a specific answer, with the retries of its policy
+  bool sendCommandCheckAnswer_P(const char *command, const char *parameter, const char *expectedAnswer, uint8_t crlfToWait = 2);
+  // Load the timeout and retry policy of a command
+  void loadPolicy(const char *command);
+
+#if SIM808_DEBUG
+  // Store a debug message in the log buffer (printf-like format from PROGMEM)
+  void logMessage_P(uint8_t level, const char *format, ...);
+#endif
+
+  // Read from module (timeout in millisec, POLICY_TIMEOUT for the timeout of the last command sent)
+  bool readResponse(uint32_t timeout, uint8_t crlfToWait = 2);
   // Read from module and expect a specific answer defined in PROGMEM (timeout in millisec)
-  bool readResponseCheckAnswer_P(uint16_t timeout, const char *expectedAnswer, uint8_t crlfToWait = 2);
+  bool readResponseCheckAnswer_P(uint32_t timeout, const char *expectedAnswer, uint8_t crlfToWait = 2);
+  // Read from module until the expected answer defined in PROGMEM is seen, false on error answer or timeout
+  bool readUntilAnswer_P(uint32_t timeout, const char *expectedAnswer, const char *errorAnswer = NULL);
+
+  // Track the result of a network call
+  void startResult();
+  void enterStage(RequestStage stage);
+  uint16_t closeResult(uint16_t code, RequestStage failedStage);
+  uint16_t failResult(uint16_t code);
 
   // Purge the serial
   void purgeSerial();
+  // Keep the URC lines received before a command and drop the other stale bytes
+  void keepURC();
+  // Add a byte to the URC line being received, true when the line is complete (in urcBuffer)
+  bool urcPut(char c);
+  void queueURC();
 
   // Find string in another string
   int16_t strIndex(const char *str, const char *findStr, uint16_t startIdx = 0);
+  // Start of the information answer without prefix (after the echo and the empty lines)
+  int16_t informationIndex();
+  // Character of the internal buffer (0 if out of the buffer)
+  char internalBufferAt(int16_t idx);
+  // Copy a part of the internal buffer in the reception buffer (NULL if the bounds are invalid)
+  char *copyToRecvBuffer(int16_t idx, int16_t idxEnd);
 
   // Manage internal buffer
   void initInternalBuffer();
   void initRecvBuffer();
 
+#if SIM808_HTTP
   // Initiate HTTP/S connection
-  uint16_t initiateHTTP(const char *url, const char *headers);
+  uint16_t initiateHTTP(const char *url, const char *headers, const char *extraHeader_P = NULL);
   uint16_t terminateHTTP();
+  // Size of the HTTP/S data announced by +HTTPACTION (located at sizeIdx in the internal buffer)
+  uint32_t parseDataSize(int16_t sizeIdx);
+  // Read the HTTP/S data announced by +HTTPACTION
+  uint16_t readHTTPData(uint32_t size);
+#if SIM808_FS
+  // Read a part of the HTTP/S data in the reception buffer (AT+HTTPREAD=<start>,<size>)
+  uint16_t readHTTPChunk(uint32_t start, uint16_t size);
+#endif
+  // Read the headers of the HTTP/S answer on the header output
+  bool readHTTPHead();
+  // Wait for +HTTPACTION (read by pollHTTP()), then finish the request
+  void startAction(bool post, uint16_t serverReadTimeoutMs);
+  uint16_t waitHTTP();
+  uint16_t finishGet();
+  uint16_t finishPost();
+#endif
 
+#if SIM808_GNSS
   // Parse CGNSINF & UGNSINF data
   GnssStatus parseGnssData(GnssInfo *gnssInfo);
+  void copyField(char *destination, const char *field, uint8_t size);
+#endif
 
 private:
   // Serial line with SIM808
@@ -186,10 +516,133 @@ private:
   // Reception buffer
   char *recvBuffer;
   uint16_t recvBufferSize = 0;
-  uint16_t dataSize = 0;
+  uint32_t dataSize = 0;
 
-  // Enable debug mode
+  // Staging buffer of the command line being sent
+  char txBuffer[SIM808_TX_BUFFER];
+  uint8_t txUsed = 0;
+#if SIM808_METRICS
+  uint32_t txStart = 0;
+#endif
+
+  // Policy of the last command sent
+  CommandPolicy currentPolicy = {NULL, DEFAULT_TIMEOUT, 0, 0, false};
+
+  // Result of the last network call
+  RequestResult lastResult = {};
+  RequestStage currentStage = STAGE_NONE;
+  uint32_t stageStart = 0;
+
+#if SIM808_METRICS
+  Metrics metrics = {};
+#endif
+
+  // Echo mode of the module set after the reset
+  bool echoConfigured = false;
+
+  // Line of URC being received (see readURC())
+  char urcBuffer[URC_BUFFER_SIZE];
+  uint8_t urcUsed = 0;
+  // URC lines received before a command, until readURC() is called
+  char urcQueue[URC_QUEUE_SIZE][URC_BUFFER_SIZE];
+  uint8_t urcQueueHead = 0;
+  uint8_t urcQueueCount = 0;
+
+  // Buffers allocated by the driver (to free on destruction)
+  bool ownBuffers = false;
+
+  // Enable debug mode (constant when the debug is compiled out, so the debug code is removed)
+#if SIM808_DEBUG
   bool enableDebug = false;
+
+  // Ring buffer of the log messages waiting to be written ([level][message][0] per message)
+  char logBuffer[SIM808_LOG_BUFFER];
+  uint16_t logHead = 0;
+  uint16_t logUsed = 0;
+  uint16_t logDropped = 0;
+#else
+  static const bool enableDebug = false;
+#endif
+
+  // Compress POST payloads
+  bool enableCompression = false;
+
+#if SIM808_HTTP
+  // Output of the data received (reception buffer if NULL)
+  Print *dataOutput = NULL;
+  // Output of the headers of the answers (not read if NULL)
+  Print *headerOutput = NULL;
+  // Action started by startGet/startPost, waiting for +HTTPACTION
+  bool httpPending = false;
+  bool httpPendingPost = false;
+  uint32_t httpActionStart = 0;
+  uint16_t httpActionTimeout = 0;
+#if SIM808_FS
+  // Size of the data stored in a file by doGetToFile
+  uint32_t fileDataSize = 0;
+#endif
+
+  // Values of the request templates (the parameters are templates from PROGMEM when set)
+  bool parameterTemplate = false;
+  const char *const *templateValues = NULL;
+  uint8_t templateValueCount = 0;
+
+#if SIM808_SSL
+  // Support of the SSL stack by the firmware, checked once (0 unknown, 1 supported, 2 not supported)
+  uint8_t sslSupport = 0;
+#endif
+#endif
+
+#if SIM808_FTP
+  // FTP server and account (kept by the caller)
+  const char *ftpServer = NULL;
+  uint16_t ftpPort = 21;
+  const char *ftpUser = NULL;
+  const char *ftpPassword = NULL;
+#if SIM808_FS
+  // File transfer started by startFTPPutFromFile/startFTPGetToFile, waiting for its end
+  bool ftpPending = false;
+  bool ftpPendingPut = false;
+  uint32_t ftpStart = 0;
+  uint32_t ftpTimeout = 0;
+#endif
+#endif
+
+  // GPRS bearer state
+  BearerStatus bearerStatus = BEARER_CLOSED;
+  char bearerIp[16] = "";
+  uint32_t bearerIdleTimeout = 0;
+  uint32_t bearerLastActivity = 0;
+  uint32_t bearerConnectTime = 0;
+  uint16_t bearerConnectCount = 0;
+};
+
+// Driver with buffers sized at compile time (no heap allocation, RAM usage known at link time)
+// Usage: SIM808StaticDriver<200, 512> sim808(&Serial1, SIM808_RST_PIN);
+template <uint16_t InternalBufferSize = 256, uint16_t RecvBufferSize = 512>
+class SIM808StaticDriver : public SIM808Driver
+{
+public:
+  SIM808StaticDriver(Stream *_stream, uint8_t _pinRst = RESET_PIN_NOT_USED, Stream *_debugStream = NULL)
+      : SIM808Driver(_stream, _pinRst, internalStorage, InternalBufferSize, recvStorage, RecvBufferSize, _debugStream)
+  {
+  }
+
+private:
+  char internalStorage[InternalBufferSize];
+  char recvStorage[RecvBufferSize];
+};
+
+// Buffers shared by several drivers (gateway driving several modules)
+// The calls of the drivers are blocking and run one after the other, so one pair of buffers serves
+// all the modules; the data received is only valid until the next call on any of these drivers
+// Usage: SIM808SharedBuffers<200, 512> buffers;
+//        SIM808Driver modem1(&Serial1, RST_PIN_1, buffers.internal, sizeof(buffers.internal), buffers.recv, sizeof(buffers.recv));
+template <uint16_t InternalBufferSize = 256, uint16_t RecvBufferSize = 512>
+struct SIM808SharedBuffers
+{
+  char internal[InternalBufferSize];
+  char recv[RecvBufferSize];
 };
 
 #endif // _SIM808_H_
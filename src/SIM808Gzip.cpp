@@ -0,0 +1,223 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Small footprint gzip (deflate, fixed Huffman) encoder used to compress the   *
+ * HTTP POST payloads on the fly while they are written to the module           *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Gzip.h"
+
+/**
+ * Deflate tables (RFC 1951 section 3.2.5) in PROGMEM to save memory usage
+ */
+const uint16_t GZIP_LENGTH_BASE[] PROGMEM = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t GZIP_LENGTH_EXTRA[] PROGMEM = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t GZIP_DIST_BASE[] PROGMEM = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t GZIP_DIST_EXTRA[] PROGMEM = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Header of a gzip member: magic, deflate, no flags, no mtime, no extra flags, unknown OS
+const uint8_t GZIP_HEADER[] PROGMEM = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff};
+
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+
+/**
+ * Bit writer of the deflate stream (LSB first), counting the bytes produced
+ */
+struct GzipBitWriter
+{
+  Print *output;
+  uint32_t size;
+  uint32_t bits;
+  uint8_t bitCount;
+
+  void writeByte(uint8_t b)
+  {
+    if (output != NULL)
+    {
+      output->write(b);
+    }
+    size++;
+  }
+
+  void writeBits(uint32_t value, uint8_t count)
+  {
+    bits |= value << bitCount;
+    bitCount += count;
+    while (bitCount >= 8)
+    {
+      writeByte(bits & 0xff);
+      bits >>= 8;
+      bitCount -= 8;
+    }
+  }
+
+  // Huffman codes are stored MSB first
+  void writeCode(uint16_t code, uint8_t count)
+  {
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+      reversed = (reversed << 1) | (code & 1);
+      code >>= 1;
+    }
+    writeBits(reversed, count);
+  }
+
+  void alignByte()
+  {
+    if (bitCount > 0)
+    {
+      writeBits(0, 8 - bitCount);
+    }
+  }
+
+  void writeLE32(uint32_t value)
+  {
+    for (uint8_t i = 0; i < 4; i++)
+    {
+      writeByte(value & 0xff);
+      value >>= 8;
+    }
+  }
+
+  // Literal/length symbol with the fixed Huffman code
+  void writeSymbol(uint16_t symbol)
+  {
+    if (symbol < 144)
+      writeCode(0x30 + symbol, 8);
+    else if (symbol < 256)
+      writeCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+      writeCode(symbol - 256, 7);
+    else
+      writeCode(0xc0 + symbol - 280, 8);
+  }
+
+  void writeMatch(uint16_t length, uint16_t distance)
+  {
+    uint8_t code = 28;
+    while (length < pgm_read_word(&GZIP_LENGTH_BASE[code]))
+    {
+      code--;
+    }
+    writeSymbol(257 + code);
+    writeBits(length - pgm_read_word(&GZIP_LENGTH_BASE[code]), pgm_read_byte(&GZIP_LENGTH_EXTRA[code]));
+
+    code = 29;
+    while (distance < pgm_read_word(&GZIP_DIST_BASE[code]))
+    {
+      code--;
+    }
+    writeCode(code, 5);
+    writeBits(distance - pgm_read_word(&GZIP_DIST_BASE[code]), pgm_read_byte(&GZIP_DIST_EXTRA[code]));
+  }
+};
+
+/**
+ * Compress the data in a single fixed Huffman deflate block wrapped in a gzip member
+ * The look back window is the input itself, matches are searched greedily
+ */
+uint32_t SIM808Gzip::compress(const uint8_t *data, uint16_t size, Print *output, uint16_t window)
+{
+  GzipBitWriter writer = {output, 0, 0, 0};
+
+  for (uint8_t i = 0; i < sizeof(GZIP_HEADER); i++)
+  {
+    writer.writeByte(pgm_read_byte(&GZIP_HEADER[i]));
+  }
+
+  // BFINAL = 1, BTYPE = 01 (fixed Huffman)
+  writer.writeBits(1, 1);
+  writer.writeBits(1, 2);
+
+  uint16_t pos = 0;
+  while (pos < size)
+  {
+    // Find the longest match in the window
+    uint16_t bestLength = 0;
+    uint16_t bestDistance = 0;
+    uint16_t maxLength = size - pos < GZIP_MAX_MATCH ? size - pos : GZIP_MAX_MATCH;
+    uint16_t start = pos > window ? pos - window : 0;
+    for (uint16_t candidate = pos; candidate-- > start && maxLength >= GZIP_MIN_MATCH;)
+    {
+      if (data[candidate] != data[pos] || data[candidate + bestLength] != data[pos + bestLength])
+      {
+        continue;
+      }
+      uint16_t length = 0;
+      while (length < maxLength && data[candidate + length] == data[pos + length])
+      {
+        length++;
+      }
+      if (length > bestLength)
+      {
+        bestLength = length;
+        bestDistance = pos - candidate;
+        if (length == maxLength)
+        {
+          break;
+        }
+      }
+    }
+
+    if (bestLength >= GZIP_MIN_MATCH)
+    {
+      writer.writeMatch(bestLength, bestDistance);
+      pos += bestLength;
+    }
+    else
+    {
+      writer.writeSymbol(data[pos]);
+      pos++;
+    }
+  }
+
+  // End of block, then the gzip trailer (CRC32 and size of the original data)
+  writer.writeSymbol(256);
+  writer.alignByte();
+  writer.writeLE32(crc32(0, data, size));
+  writer.writeLE32(size);
+
+  return writer.size;
+}
+
+/**
+ * Bitwise CRC32 (reflected, polynomial 0xEDB88320), no table to keep the footprint small
+ */
+uint32_t SIM808Gzip::crc32(uint32_t crc, const uint8_t *data, uint16_t size)
+{
+  crc = ~crc;
+  for (uint16_t i = 0; i < size; i++)
+  {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
@@ -0,0 +1,55 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Small footprint gzip (deflate, fixed Huffman) encoder used to compress the   *
+ * HTTP POST payloads on the fly while they are written to the module           *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_GZIP_H_
+#define _SIM808_GZIP_H_
+
+#include <Arduino.h>
+
+// Maximum distance (in bytes) to look back for a match
+// The window is the payload itself, no extra RAM is needed, only CPU time grows with it
+#ifndef SIM808_GZIP_WINDOW
+#define SIM808_GZIP_WINDOW 256
+#endif
+
+class SIM808Gzip
+{
+public:
+  // Compress the data in gzip format and write it on the output
+  // If output is NULL, nothing is written and only the compressed size is computed
+  // The encoder is deterministic: the size computed without output is the size written with output
+  // Returns the size of the compressed data in bytes
+  static uint32_t compress(const uint8_t *data, uint16_t size, Print *output, uint16_t window = SIM808_GZIP_WINDOW);
+
+  // Update a CRC32 (IEEE 802.3, as used by gzip) with new data; start with crc = 0
+  static uint32_t crc32(uint32_t crc, const uint8_t *data, uint16_t size);
+};
+
+#endif // _SIM808_GZIP_H_
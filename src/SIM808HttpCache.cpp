@@ -0,0 +1,341 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Cache of a polled HTTP resource: conditional GET with the Last-Modified      *
+ * validator, the body is kept in a store given by the caller                   *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Config.h"
+
+#if SIM808_HTTP
+#include "SIM808HttpCache.h"
+
+/**
+ * Constructor; prepare the buffer of the request headers
+ */
+SIM808HttpCache::SIM808HttpCache(SIM808Driver *_driver, const char *_url, char *_body, uint16_t _bodySize, uint16_t _headersSize)
+{
+  driver = _driver;
+  url = _url;
+  if (_body != NULL && _bodySize > 0)
+  {
+    body = _body;
+    bodySize = _bodySize;
+  }
+
+  requestHeaders = (char *)malloc(_headersSize);
+  if (requestHeaders != NULL)
+  {
+    requestHeadersSize = _headersSize;
+  }
+  // Out of memory: the requests are sent without the validator (full downloads)
+}
+
+/**
+ * Destructor; cleanup the memory allocated by the cache
+ */
+SIM808HttpCache::~SIM808HttpCache()
+{
+  free(requestHeaders);
+}
+
+/**
+ * Headers sent with each request
+ */
+void SIM808HttpCache::setHeaders(const char *_headers)
+{
+  headers = _headers;
+}
+
+/**
+ * GET the resource, conditional when a body is cached
+ * The headers and the body of the answer are read through the outputs of the driver during the call
+ */
+uint16_t SIM808HttpCache::get(uint16_t serverReadTimeoutMs)
+{
+  hit = false;
+  if (body == NULL)
+  {
+    return 702;
+  }
+
+  // Without room for the validator, the request is sent without them (full download)
+  const char *sentHeaders = buildHeaders() ? requestHeaders : headers;
+  if (sentHeaders != NULL && sentHeaders[0] == 0)
+  {
+    sentHeaders = NULL;
+  }
+
+  headerParser.begin(newLastModified);
+  bodyWriter.begin(body, bodySize);
+  driver->setHeaderOutput(&headerParser);
+  driver->setDataOutput(&bodyWriter);
+  uint16_t rc = driver->doGet(url, sentHeaders, serverReadTimeoutMs);
+  driver->setHeaderOutput(NULL);
+  driver->setDataOutput(NULL);
+  droppedValidators += headerParser.dropped;
+
+  if (rc == 304 && cached)
+  {
+    // Not modified: the cached body is still valid (the server may give an updated validator)
+    hit = true;
+    hits++;
+    if (newLastModified[0] != 0)
+    {
+      strcpy(lastModified, newLastModified);
+    }
+  }
+  else if (rc == 200 && !bodyWriter.overflow)
+  {
+    bodyLength = bodyWriter.length;
+    body[bodyLength] = 0;
+    cached = true;
+    strcpy(lastModified, newLastModified);
+    misses++;
+  }
+  else if (rc == 200 || rc == 304 || bodyWriter.length > 0)
+  {
+    // Body too large for the store, unexpected answer or store overwritten by an incomplete body
+    invalidate();
+    misses++;
+  }
+  // Otherwise the request failed before the body: the cached body and its validator are kept
+
+  return rc;
+}
+
+/**
+ * Forget the cached body and its validator
+ */
+void SIM808HttpCache::invalidate()
+{
+  cached = false;
+  bodyLength = 0;
+  lastModified[0] = 0;
+  if (body != NULL)
+  {
+    body[0] = 0;
+  }
+}
+
+bool SIM808HttpCache::isCached()
+{
+  return cached;
+}
+
+const char *SIM808HttpCache::getBody()
+{
+  return body;
+}
+
+uint16_t SIM808HttpCache::getBodySize()
+{
+  return bodyLength;
+}
+
+bool SIM808HttpCache::isHit()
+{
+  return hit;
+}
+
+uint32_t SIM808HttpCache::getHits()
+{
+  return hits;
+}
+
+uint32_t SIM808HttpCache::getMisses()
+{
+  return misses;
+}
+
+const char *SIM808HttpCache::getLastModified()
+{
+  return lastModified;
+}
+
+uint32_t SIM808HttpCache::getDroppedValidators()
+{
+  return droppedValidators;
+}
+
+/**
+ * Build the headers of the request: headers of the user then the validator of the cached body
+ * The headers are separated by the escaped CRLF expected by AT+HTTPPARA="USERDATA"
+ */
+bool SIM808HttpCache::buildHeaders()
+{
+  if (requestHeaders == NULL || requestHeadersSize == 0)
+  {
+    return false;
+  }
+
+  requestHeaders[0] = 0;
+  if (headers != NULL)
+  {
+    if (strlen(headers) >= requestHeadersSize)
+    {
+      return false;
+    }
+    strcpy(requestHeaders, headers);
+  }
+
+  if (!cached)
+  {
+    return true;
+  }
+
+  return appendHeader("If-Modified-Since: ", lastModified);
+}
+
+/**
+ * Append a header if its value is set, false if it does not fit
+ * A value with a '"' is not sent: it would end the quoted parameter of AT+HTTPPARA="USERDATA"
+ */
+bool SIM808HttpCache::appendHeader(const char *name, const char *value)
+{
+  if (value[0] == 0 || strchr(value, '"') != NULL)
+  {
+    return true;
+  }
+
+  uint16_t length = strlen(requestHeaders);
+  uint16_t separator = length > 0 ? 4 : 0;
+  if (length + separator + strlen(name) + strlen(value) >= requestHeadersSize)
+  {
+    return false;
+  }
+
+  if (separator > 0)
+  {
+    strcat(requestHeaders, "\\r\\n");
+  }
+  strcat(requestHeaders, name);
+  strcat(requestHeaders, value);
+  return true;
+}
+
+/**
+ * Start the parsing of new headers, the validator found is written in the buffer given
+ */
+void SIM808HttpCache::HeaderParser::begin(char *_lastModified)
+{
+  lastModified = _lastModified;
+  lastModified[0] = 0;
+  nameLength = 0;
+  value = NULL;
+  skipLine = false;
+  dropped = 0;
+}
+
+/**
+ * Parse the headers line per line ("Name: value"), the names are not case sensitive
+ */
+size_t SIM808HttpCache::HeaderParser::write(uint8_t c)
+{
+  if (c == '\r' || c == '\n')
+  {
+    // End of line: next header
+    nameLength = 0;
+    value = NULL;
+    skipLine = false;
+  }
+  else if (skipLine)
+  {
+    // Header not needed (or status line)
+  }
+  else if (value != NULL)
+  {
+    // Value of the validator (leading spaces skipped), a truncated one would never match: it is dropped
+    if (valueLength == SIM808_CACHE_VALIDATOR_SIZE - 1)
+    {
+      value[0] = 0;
+      value = NULL;
+      skipLine = true;
+      dropped++;
+    }
+    else if (valueLength > 0 || c != ' ')
+    {
+      value[valueLength++] = c;
+      value[valueLength] = 0;
+    }
+  }
+  else if (c == ':')
+  {
+    name[nameLength] = 0;
+    if (strcmp_P(name, PSTR("last-modified")) == 0)
+    {
+      value = lastModified;
+    }
+    else
+    {
+      skipLine = true;
+    }
+
+    if (value != NULL)
+    {
+      valueLength = 0;
+      value[0] = 0;
+    }
+  }
+  else if (nameLength < sizeof(name) - 1)
+  {
+    name[nameLength++] = tolower(c);
+  }
+  else
+  {
+    skipLine = true;
+  }
+  return 1;
+}
+
+/**
+ * Start to write a new body in the store
+ */
+void SIM808HttpCache::BodyWriter::begin(char *_body, uint16_t _size)
+{
+  body = _body;
+  size = _size;
+  length = 0;
+  overflow = false;
+}
+
+/**
+ * Write a byte of the body, one byte is kept for the end of string
+ */
+size_t SIM808HttpCache::BodyWriter::write(uint8_t c)
+{
+  if (length + 1 < size)
+  {
+    body[length++] = c;
+  }
+  else
+  {
+    overflow = true;
+  }
+  return 1;
+}
+
+#endif // SIM808_HTTP
@@ -0,0 +1,152 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Cache of a polled HTTP resource: conditional GET with the Last-Modified      *
+ * validator, the body is kept in a store given by the caller                   *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_HTTP_CACHE_H_
+#define _SIM808_HTTP_CACHE_H_
+
+#include "SIM808Driver.h"
+
+#if !SIM808_HTTP
+#error "SIM808HttpCache needs the HTTP subsystem (SIM808_HTTP)"
+#endif
+
+// Maximum size of the validator (value of the Last-Modified header), with its end of string
+// The default fits an HTTP date (29 characters) with room for the non-standard forms
+#ifndef SIM808_CACHE_VALIDATOR_SIZE
+#define SIM808_CACHE_VALIDATOR_SIZE 48
+#endif
+
+class SIM808HttpCache
+{
+public:
+  // Initialize the cache of a resource
+  // Parameters:
+  //  _driver : driver used to send the requests
+  //  _url : URL of the resource (kept as pointer, must stay valid)
+  //  _body : store of the body given by the caller, kept between the requests
+  //  _bodySize : size of the store in bytes, with the end of string (a body which does not fit is not cached)
+  //  A NULL or empty store makes get() fail with 702
+  //  _headersSize (optional) : size in bytes of the buffer used to build the headers of the requests
+  SIM808HttpCache(SIM808Driver *_driver, const char *_url, char *_body, uint16_t _bodySize, uint16_t _headersSize = 128);
+  ~SIM808HttpCache();
+
+  // Headers sent with each request (kept as pointer, must stay valid)
+  void setHeaders(const char *headers);
+
+  // GET the resource, with If-Modified-Since when a body is cached
+  // Only Last-Modified is used: the headers are sent in a quoted parameter of AT+HTTPPARA, which cannot
+  // carry the '"' of an ETag ("..." or W/"...")
+  // Returns the HTTP code: 200 when a new body was stored, 304 when the cached body is still valid
+  uint16_t get(uint16_t serverReadTimeoutMs);
+  // Forget the cached body (the next request downloads it)
+  void invalidate();
+
+  // Cached body (valid when isCached())
+  bool isCached();
+  const char *getBody();
+  uint16_t getBodySize();
+  // True if the last request was answered by the cached body (304)
+  bool isHit();
+
+  // Statistics
+  uint32_t getHits();
+  uint32_t getMisses();
+  const char *getLastModified();
+  // Validators of the answers longer than SIM808_CACHE_VALIDATOR_SIZE - 1, dropped
+  uint32_t getDroppedValidators();
+
+private:
+  // Extract the validator from the headers of the answer
+  class HeaderParser : public Print
+  {
+  public:
+    void begin(char *_lastModified);
+    size_t write(uint8_t c);
+    using Print::write;
+    // Validators too long for their buffer (cleared)
+    uint8_t dropped = 0;
+
+  private:
+    char *lastModified = NULL;
+    char name[16];
+    uint8_t nameLength = 0;
+    char *value = NULL;
+    uint8_t valueLength = 0;
+    bool skipLine = false;
+  };
+
+  // Write the body of the answer in the store
+  class BodyWriter : public Print
+  {
+  public:
+    void begin(char *_body, uint16_t _size);
+    size_t write(uint8_t c);
+    using Print::write;
+    uint16_t length = 0;
+    bool overflow = false;
+
+  private:
+    char *body = NULL;
+    uint16_t size = 0;
+  };
+
+  // Build the headers of the request, false if they do not fit in the buffer
+  bool buildHeaders();
+  bool appendHeader(const char *name, const char *value);
+
+  SIM808Driver *driver = NULL;
+  const char *url = NULL;
+  const char *headers = NULL;
+
+  // Store of the body
+  char *body = NULL;
+  uint16_t bodySize = 0;
+  uint16_t bodyLength = 0;
+  bool cached = false;
+  bool hit = false;
+
+  // Validator of the cached body, and the one of the answer (kept only if the answer is valid)
+  char lastModified[SIM808_CACHE_VALIDATOR_SIZE] = "";
+  char newLastModified[SIM808_CACHE_VALIDATOR_SIZE] = "";
+
+  // Headers of the request
+  char *requestHeaders = NULL;
+  uint16_t requestHeadersSize = 0;
+
+  HeaderParser headerParser;
+  BodyWriter bodyWriter;
+
+  // Statistics
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint32_t droppedValidators = 0;
+};
+
+#endif // _SIM808_HTTP_CACHE_H_
@@ -0,0 +1,385 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Pull JSON extractor: the values of a few paths are extracted while the body  *
+ * of the HTTP answer is read, without keeping the whole body in memory         *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Json.h"
+
+/**
+ * Add a path to extract (in PROGMEM) and the buffer receiving its value
+ */
+int8_t SIM808JsonExtractor::addPath_P(const char *_path, char *value, uint8_t size)
+{
+  if (pathCount >= SIM808_JSON_MAX_PATHS || pathCount >= 16 || value == NULL || size == 0)
+  {
+    return -1;
+  }
+
+  paths[pathCount] = _path;
+  values[pathCount] = value;
+  sizes[pathCount] = size;
+  value[0] = 0;
+  return pathCount++;
+}
+
+/**
+ * Start a new document
+ */
+void SIM808JsonExtractor::reset()
+{
+  state = STATE_VALUE;
+  depth = 0;
+  pathLength = 0;
+  path[0] = 0;
+  pathTruncated = false;
+  capture = -1;
+  unicodeDigits = 0;
+  found = 0;
+  for (uint8_t i = 0; i < pathCount; i++)
+  {
+    values[i][0] = 0;
+  }
+}
+
+bool SIM808JsonExtractor::isFound(uint8_t index)
+{
+  return index < pathCount && (found & (1U << index)) != 0;
+}
+
+uint8_t SIM808JsonExtractor::getFoundCount()
+{
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < pathCount; i++)
+  {
+    count += isFound(i) ? 1 : 0;
+  }
+  return count;
+}
+
+bool SIM808JsonExtractor::hasError()
+{
+  return state == STATE_ERROR;
+}
+
+bool SIM808JsonExtractor::isComplete()
+{
+  return state == STATE_DONE;
+}
+
+/**
+ * Give the next byte of the document (always accepted, the parsing stops on error)
+ */
+size_t SIM808JsonExtractor::write(uint8_t c)
+{
+  if (state != STATE_ERROR && !parse(c))
+  {
+    state = STATE_ERROR;
+    capture = -1;
+  }
+  return 1;
+}
+
+/**
+ * Parse a character, false if the document is invalid
+ */
+bool SIM808JsonExtractor::parse(char c)
+{
+  bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+
+  switch (state)
+  {
+  case STATE_VALUE:
+    return space || startValue(c);
+
+  case STATE_VALUE_OR_END:
+    if (space)
+    {
+      return true;
+    }
+    return c == ']' ? endContainer(c) : startValue(c);
+
+  case STATE_KEY_OR_END:
+    if (space)
+    {
+      return true;
+    }
+    if (c == '}')
+    {
+      return endContainer(c);
+    }
+    if (c != '"')
+    {
+      return false;
+    }
+    // The key replaces the previous one in the path of the object
+    pathLength = pathStart[depth - 1];
+    path[pathLength] = 0;
+    pathTruncated = false;
+    if (pathLength > 0)
+    {
+      pathPut('.');
+    }
+    state = STATE_KEY;
+    return true;
+
+  case STATE_KEY:
+    if (c == '"')
+    {
+      state = STATE_COLON;
+    }
+    else if (c == '\\')
+    {
+      state = STATE_KEY_ESCAPE;
+    }
+    else
+    {
+      pathPut(c);
+    }
+    return true;
+
+  case STATE_KEY_ESCAPE:
+    pathPut(c);
+    state = STATE_KEY;
+    return true;
+
+  case STATE_COLON:
+    if (c == ':')
+    {
+      state = STATE_VALUE;
+    }
+    return space || c == ':';
+
+  case STATE_STRING:
+    if (unicodeDigits > 0)
+    {
+      unicodeDigits--;
+    }
+    else if (c == '"')
+    {
+      endValue();
+    }
+    else if (c == '\\')
+    {
+      state = STATE_STRING_ESCAPE;
+    }
+    else
+    {
+      capturePut(c);
+    }
+    return true;
+
+  case STATE_STRING_ESCAPE:
+    switch (c)
+    {
+    case 'n':
+      capturePut('\n');
+      break;
+    case 'r':
+      capturePut('\r');
+      break;
+    case 't':
+      capturePut('\t');
+      break;
+    case 'b':
+      capturePut('\b');
+      break;
+    case 'f':
+      capturePut('\f');
+      break;
+    case 'u':
+      // Characters out of ASCII are not decoded
+      capturePut('?');
+      unicodeDigits = 4;
+      break;
+    default:
+      capturePut(c);
+    }
+    state = STATE_STRING;
+    return true;
+
+  case STATE_LITERAL:
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.')
+    {
+      capturePut(c);
+      return true;
+    }
+    // The character after the literal belongs to the container
+    endValue();
+    return parse(c);
+
+  case STATE_NEXT:
+    if (space)
+    {
+      return true;
+    }
+    if (c == ',' && depth > 0)
+    {
+      if (isArray[depth - 1])
+      {
+        arrayIndex[depth - 1]++;
+        state = STATE_VALUE;
+      }
+      else
+      {
+        state = STATE_KEY_OR_END;
+      }
+      return true;
+    }
+    return endContainer(c);
+
+  case STATE_DONE:
+    return space;
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Start a value: extracted if its path is one of the paths, or a new container
+ */
+bool SIM808JsonExtractor::startValue(char c)
+{
+  // The element of an array is named by its index
+  if (depth > 0 && isArray[depth - 1])
+  {
+    pathLength = pathStart[depth - 1];
+    path[pathLength] = 0;
+    pathTruncated = false;
+    if (pathLength > 0)
+    {
+      pathPut('.');
+    }
+    pathIndex(arrayIndex[depth - 1]);
+  }
+
+  capture = -1;
+  if (c == '{' || c == '[')
+  {
+    if (depth >= SIM808_JSON_MAX_DEPTH)
+    {
+      return false;
+    }
+    isArray[depth] = c == '[';
+    arrayIndex[depth] = 0;
+    pathStart[depth] = pathLength;
+    depth++;
+    state = c == '[' ? STATE_VALUE_OR_END : STATE_KEY_OR_END;
+    return true;
+  }
+
+  if (c != '"' && c != '-' && (c < '0' || c > '9') && c != 't' && c != 'f' && c != 'n')
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < pathCount && !pathTruncated; i++)
+  {
+    if (strcmp_P(path, paths[i]) == 0)
+    {
+      capture = i;
+      captureLength = 0;
+      values[i][0] = 0;
+      break;
+    }
+  }
+
+  if (c == '"')
+  {
+    unicodeDigits = 0;
+    state = STATE_STRING;
+  }
+  else
+  {
+    capturePut(c);
+    state = STATE_LITERAL;
+  }
+  return true;
+}
+
+/**
+ * End of an object or an array
+ */
+bool SIM808JsonExtractor::endContainer(char c)
+{
+  if (depth == 0 || c != (isArray[depth - 1] ? ']' : '}'))
+  {
+    return false;
+  }
+
+  depth--;
+  pathLength = pathStart[depth];
+  path[pathLength] = 0;
+  endValue();
+  return true;
+}
+
+/**
+ * End of a value, the path is marked as found if it was extracted
+ */
+void SIM808JsonExtractor::endValue()
+{
+  if (capture >= 0)
+  {
+    found |= 1U << capture;
+    capture = -1;
+  }
+  state = depth == 0 ? STATE_DONE : STATE_NEXT;
+}
+
+void SIM808JsonExtractor::pathPut(char c)
+{
+  if (pathLength < SIM808_JSON_PATH_SIZE - 1)
+  {
+    path[pathLength++] = c;
+    path[pathLength] = 0;
+  }
+  else
+  {
+    pathTruncated = true;
+  }
+}
+
+void SIM808JsonExtractor::pathIndex(uint16_t index)
+{
+  char buff[6];
+  utoa(index, buff, 10);
+  for (uint8_t i = 0; buff[i] != 0; i++)
+  {
+    pathPut(buff[i]);
+  }
+}
+
+void SIM808JsonExtractor::capturePut(char c)
+{
+  if (capture >= 0 && captureLength < sizes[capture] - 1)
+  {
+    values[capture][captureLength++] = c;
+    values[capture][captureLength] = 0;
+  }
+}
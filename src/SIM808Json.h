@@ -0,0 +1,130 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Pull JSON extractor: the values of a few paths are extracted while the body  *
+ * of the HTTP answer is read, without keeping the whole body in memory         *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_JSON_H_
+#define _SIM808_JSON_H_
+
+#include <Arduino.h>
+
+// Maximum number of paths to extract
+#ifndef SIM808_JSON_MAX_PATHS
+#define SIM808_JSON_MAX_PATHS 8
+#endif
+
+// Maximum nesting of objects and arrays
+#ifndef SIM808_JSON_MAX_DEPTH
+#define SIM808_JSON_MAX_DEPTH 8
+#endif
+
+// Maximum length of the current path (keys joined by dots)
+#ifndef SIM808_JSON_PATH_SIZE
+#define SIM808_JSON_PATH_SIZE 48
+#endif
+
+/**
+ * Extract the values of a few paths from a JSON document given byte per byte (Print interface)
+ * A path is made of the keys joined by dots, the elements of an array by their index: "config.interval",
+ * "commands.0.id". Only the values which are strings, numbers, booleans or null are extracted, as text
+ * Usage: SIM808JsonExtractor json; json.addPath_P(PSTR("config.interval"), interval, sizeof(interval));
+ *        sim808->setDataOutput(&json); sim808->doGet(...); if (json.isFound(0)) ...
+ */
+class SIM808JsonExtractor : public Print
+{
+public:
+  // Add a path (in PROGMEM) and the buffer receiving its value (truncated to size - 1 characters)
+  // Returns the index of the path, or -1 if the maximum of paths is reached
+  int8_t addPath_P(const char *path, char *value, uint8_t size);
+  // Start a new document (the paths are kept, their values are cleared)
+  void reset();
+
+  // True if the value of the path (index given by addPath_P) was found in the document
+  bool isFound(uint8_t index);
+  // Number of paths found
+  uint8_t getFoundCount();
+  // True if the document is not valid JSON (the values found before the error are kept)
+  bool hasError();
+  // True when the whole document was read
+  bool isComplete();
+
+  // Print interface
+  size_t write(uint8_t c);
+  using Print::write;
+
+private:
+  enum State
+  {
+    STATE_VALUE,        // Value expected
+    STATE_KEY_OR_END,   // Key or end of object expected
+    STATE_VALUE_OR_END, // Value or end of array expected
+    STATE_KEY,          // In a key
+    STATE_KEY_ESCAPE,   // Escape sequence in a key
+    STATE_COLON,        // Colon after a key expected
+    STATE_STRING,       // In a string value
+    STATE_STRING_ESCAPE,// Escape sequence in a string value
+    STATE_LITERAL,      // In a number, true, false or null
+    STATE_NEXT,         // Comma or end of the container expected
+    STATE_DONE,         // End of the document
+    STATE_ERROR         // Invalid document
+  };
+
+  bool parse(char c);
+  bool startValue(char c);
+  bool endContainer(char c);
+  void endValue();
+  void pathPut(char c);
+  void pathIndex(uint16_t index);
+  void capturePut(char c);
+
+  // Paths to extract
+  const char *paths[SIM808_JSON_MAX_PATHS];
+  char *values[SIM808_JSON_MAX_PATHS];
+  uint8_t sizes[SIM808_JSON_MAX_PATHS];
+  uint8_t pathCount = 0;
+  uint16_t found = 0; // One bit per path (16 paths at most)
+
+  // Parser state
+  State state = STATE_VALUE;
+  uint8_t depth = 0;
+  bool isArray[SIM808_JSON_MAX_DEPTH];
+  uint16_t arrayIndex[SIM808_JSON_MAX_DEPTH];
+  uint8_t pathStart[SIM808_JSON_MAX_DEPTH];
+
+  // Current path (truncated paths do not match)
+  char path[SIM808_JSON_PATH_SIZE] = "";
+  uint8_t pathLength = 0;
+  bool pathTruncated = false;
+
+  // Value being extracted (-1 if the current value is not extracted)
+  int8_t capture = -1;
+  uint8_t captureLength = 0;
+  uint8_t unicodeDigits = 0;
+};
+
+#endif // _SIM808_JSON_H_
@@ -0,0 +1,649 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Lightweight MQTT 3.1.1 client (QoS 0/1) on a TCP connection of the module    *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Config.h"
+
+#if SIM808_TCPIP
+#include "SIM808MqttClient.h"
+
+/**
+ * MQTT control packet types (first byte of the fixed header)
+ */
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_SUBSCRIBE 0x82
+#define MQTT_SUBACK 0x90
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+
+// Protocol name and level of MQTT 3.1.1
+const uint8_t MQTT_PROTOCOL[] PROGMEM = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04};
+
+/**
+ * Constructor; prepare the packet buffers and the publish queue
+ */
+SIM808MqttClient::SIM808MqttClient(SIM808Driver *_driver, uint8_t _mux, uint16_t _bufferSize, uint16_t _queueSize)
+{
+  driver = _driver;
+  mux = _mux;
+
+  txBuffer = (uint8_t *)malloc(_bufferSize);
+  rxBuffer = (uint8_t *)malloc(_bufferSize);
+  queueBuffer = (uint8_t *)malloc(_queueSize);
+  if (txBuffer == NULL || rxBuffer == NULL || queueBuffer == NULL)
+  {
+    // Out of memory: connect() fails and nothing can be published
+    free(txBuffer);
+    free(rxBuffer);
+    free(queueBuffer);
+    txBuffer = NULL;
+    rxBuffer = NULL;
+    queueBuffer = NULL;
+    return;
+  }
+  bufferSize = _bufferSize;
+  queueSize = _queueSize;
+}
+
+/**
+ * Destructor; cleanup the memory allocated by the client
+ */
+SIM808MqttClient::~SIM808MqttClient()
+{
+  free(txBuffer);
+  free(rxBuffer);
+  free(queueBuffer);
+}
+
+/*****************************************************************************************
+ * CONFIGURATION
+ *****************************************************************************************/
+
+void SIM808MqttClient::setServer(const char *_host, uint16_t _port)
+{
+  host = _host;
+  port = _port;
+}
+
+void SIM808MqttClient::setCallback(MessageCallback _callback)
+{
+  callback = _callback;
+}
+
+void SIM808MqttClient::setKeepAlive(uint16_t seconds)
+{
+  keepAlive = seconds;
+}
+
+/*****************************************************************************************
+ * SESSION
+ *****************************************************************************************/
+
+/**
+ * Open the TCP connection and send CONNECT, wait for CONNACK
+ */
+SIM808MqttClient::ConnectResult SIM808MqttClient::connect(const char *clientId, const char *user, const char *password, bool cleanSession)
+{
+  isConnected = false;
+  rxLength = 0;
+  rxSkip = 0;
+
+  if (txBuffer == NULL)
+  {
+    return MQTT_NO_MEMORY;
+  }
+
+  if (!driver->socketOpen(mux, SIM808Driver::SOCKET_TCP, host, port))
+  {
+    return MQTT_TCP_FAILED;
+  }
+
+  // Variable header and payload size
+  uint16_t remainingLength = sizeof(MQTT_PROTOCOL) + 3 + 2 + strlen(clientId);
+  uint8_t flags = cleanSession ? 0x02 : 0x00;
+  if (user != NULL)
+  {
+    remainingLength += 2 + strlen(user);
+    flags |= 0x80;
+  }
+  if (password != NULL)
+  {
+    remainingLength += 2 + strlen(password);
+    flags |= 0x40;
+  }
+  if (remainingLength + 5 > bufferSize)
+  {
+    driver->socketClose(mux);
+    return MQTT_PACKET_TOO_LARGE;
+  }
+
+  uint16_t pos = writeHeader(MQTT_CONNECT, remainingLength);
+  for (uint8_t i = 0; i < sizeof(MQTT_PROTOCOL); i++)
+  {
+    txBuffer[pos++] = pgm_read_byte(&MQTT_PROTOCOL[i]);
+  }
+  txBuffer[pos++] = flags;
+  txBuffer[pos++] = keepAlive >> 8;
+  txBuffer[pos++] = keepAlive & 0xff;
+  pos = writeString(pos, clientId);
+  if (user != NULL)
+  {
+    pos = writeString(pos, user);
+  }
+  if (password != NULL)
+  {
+    pos = writeString(pos, password);
+  }
+
+  if (!sendPacket(txBuffer, pos) || !waitPacket(MQTT_CONNACK, MQTT_DEFAULT_TIMEOUT))
+  {
+    driver->socketClose(mux);
+    return MQTT_TIMEOUT;
+  }
+
+  // The return code of CONNACK is kept by handlePacket()
+  uint8_t returnCode = connackCode;
+  if (returnCode != 0)
+  {
+    driver->socketClose(mux);
+    return returnCode <= MQTT_UNAUTHORIZED ? (ConnectResult)returnCode : MQTT_SERVER_UNAVAILABLE;
+  }
+
+  isConnected = true;
+  pingPending = false;
+
+  // Send what was queued while disconnected (and what was not acknowledged)
+  sendQueue(true);
+  return MQTT_CONNECTED;
+}
+
+/**
+ * Send DISCONNECT and close the TCP connection
+ */
+void SIM808MqttClient::disconnect()
+{
+  if (isConnected)
+  {
+    uint8_t packet[2] = {MQTT_DISCONNECT, 0};
+    sendPacket(packet, 2);
+  }
+  driver->socketClose(mux);
+  isConnected = false;
+}
+
+bool SIM808MqttClient::connected()
+{
+  return isConnected;
+}
+
+/*****************************************************************************************
+ * PUBLISH & SUBSCRIBE
+ *****************************************************************************************/
+
+/**
+ * Publish a message; QoS 0 are sent directly when connected, others go through the queue
+ */
+bool SIM808MqttClient::publish(const char *topic, const uint8_t *payload, uint16_t size, uint8_t qos, bool retain)
+{
+  if (qos > 1)
+  {
+    qos = 1;
+  }
+
+  uint16_t remainingLength = 2 + strlen(topic) + (qos > 0 ? 2 : 0) + size;
+  if (remainingLength + 5 > bufferSize)
+  {
+    return false;
+  }
+
+  uint16_t pos = writeHeader(MQTT_PUBLISH | (qos << 1) | (retain ? 1 : 0), remainingLength);
+  pos = writeString(pos, topic);
+  if (qos > 0)
+  {
+    txBuffer[pos++] = nextPacketId >> 8;
+    txBuffer[pos++] = nextPacketId & 0xff;
+    nextPacketId = nextPacketId == 0xffff ? 1 : nextPacketId + 1;
+  }
+  memcpy(txBuffer + pos, payload, size);
+  pos += size;
+
+  if (qos == 0 && isConnected && queueUsed == 0)
+  {
+    return sendPacket(txBuffer, pos);
+  }
+
+  if (!queuePacket(pos))
+  {
+    return false;
+  }
+  if (isConnected)
+  {
+    sendQueue(false);
+  }
+  return true;
+}
+
+bool SIM808MqttClient::publish(const char *topic, const char *payload, uint8_t qos, bool retain)
+{
+  return publish(topic, (const uint8_t *)payload, strlen(payload), qos, retain);
+}
+
+/**
+ * Subscribe to a topic and wait for SUBACK
+ */
+bool SIM808MqttClient::subscribe(const char *topic, uint8_t qos)
+{
+  if (!isConnected)
+  {
+    return false;
+  }
+
+  uint16_t remainingLength = 2 + 2 + strlen(topic) + 1;
+  if (remainingLength + 5 > bufferSize)
+  {
+    return false;
+  }
+
+  uint16_t pos = writeHeader(MQTT_SUBSCRIBE, remainingLength);
+  txBuffer[pos++] = nextPacketId >> 8;
+  txBuffer[pos++] = nextPacketId & 0xff;
+  nextPacketId = nextPacketId == 0xffff ? 1 : nextPacketId + 1;
+  pos = writeString(pos, topic);
+  txBuffer[pos++] = qos > 1 ? 1 : qos;
+
+  return sendPacket(txBuffer, pos) && waitPacket(MQTT_SUBACK, MQTT_DEFAULT_TIMEOUT);
+}
+
+/**
+ * Process the incoming packets, the queue and the keep-alive
+ */
+bool SIM808MqttClient::loop()
+{
+  if (!isConnected)
+  {
+    return false;
+  }
+
+  if (!readPackets())
+  {
+    isConnected = false;
+    return false;
+  }
+
+  // Send again the messages not acknowledged in time
+  if (queueUsed > 0 && millis() - lastQueueSend > MQTT_RETRY_TIMEOUT)
+  {
+    sendQueue(true);
+  }
+
+  // Keep-alive: ping when nothing was sent, give up when the ping is not answered in time
+  uint32_t keepAliveMs = (uint32_t)keepAlive * 1000;
+  if (keepAliveMs > 0)
+  {
+    if (pingPending && millis() - pingSentAt > keepAliveMs)
+    {
+      driver->socketClose(mux);
+      isConnected = false;
+      return false;
+    }
+    if (!pingPending && millis() - lastOutbound > keepAliveMs)
+    {
+      uint8_t packet[2] = {MQTT_PINGREQ, 0};
+      if (!sendPacket(packet, 2))
+      {
+        isConnected = false;
+        return false;
+      }
+      pingPending = true;
+      pingSentAt = millis();
+    }
+  }
+
+  return isConnected;
+}
+
+uint16_t SIM808MqttClient::getQueueUsed()
+{
+  return queueUsed;
+}
+
+/*****************************************************************************************
+ * PACKETS
+ *****************************************************************************************/
+
+/**
+ * Write the fixed header in the TX buffer, returns the position after it
+ */
+uint16_t SIM808MqttClient::writeHeader(uint8_t type, uint16_t remainingLength)
+{
+  uint16_t pos = 0;
+  txBuffer[pos++] = type;
+  do
+  {
+    uint8_t digit = remainingLength & 0x7f;
+    remainingLength >>= 7;
+    txBuffer[pos++] = digit | (remainingLength > 0 ? 0x80 : 0);
+  } while (remainingLength > 0);
+  return pos;
+}
+
+/**
+ * Write a length prefixed string in the TX buffer, returns the position after it
+ */
+uint16_t SIM808MqttClient::writeString(uint16_t pos, const char *str)
+{
+  uint16_t length = strlen(str);
+  txBuffer[pos++] = length >> 8;
+  txBuffer[pos++] = length & 0xff;
+  memcpy(txBuffer + pos, str, length);
+  return pos + length;
+}
+
+bool SIM808MqttClient::sendPacket(const uint8_t *packet, uint16_t size)
+{
+  if (!driver->socketSend(mux, packet, size))
+  {
+    return false;
+  }
+  lastOutbound = millis();
+  return true;
+}
+
+bool SIM808MqttClient::sendShortPacket(uint8_t type, uint16_t packetId, bool withId)
+{
+  uint8_t packet[4] = {type, (uint8_t)(withId ? 2 : 0), (uint8_t)(packetId >> 8), (uint8_t)(packetId & 0xff)};
+  return sendPacket(packet, withId ? 4 : 2);
+}
+
+/**
+ * Read what the module received and handle each complete packet
+ * Packets larger than the buffer are skipped
+ */
+bool SIM808MqttClient::readPackets()
+{
+  if (rxLength >= bufferSize)
+  {
+    return true;
+  }
+  uint16_t received = driver->socketRead(mux, rxBuffer + rxLength, bufferSize - rxLength);
+  if (received == 0)
+  {
+    return true;
+  }
+  rxLength += received;
+
+  while (rxLength > 0)
+  {
+    // Drop the end of a packet too large for the buffer
+    if (rxSkip > 0)
+    {
+      uint16_t skip = rxSkip < rxLength ? rxSkip : rxLength;
+      memmove(rxBuffer, rxBuffer + skip, rxLength - skip);
+      rxLength -= skip;
+      rxSkip -= skip;
+      continue;
+    }
+
+    // Decode the remaining length
+    uint32_t remainingLength = 0;
+    uint8_t headerSize = 1;
+    bool complete = false;
+    for (uint8_t shift = 0; headerSize < rxLength && headerSize <= 4; shift += 7)
+    {
+      uint8_t digit = rxBuffer[headerSize++];
+      remainingLength |= (uint32_t)(digit & 0x7f) << shift;
+      if ((digit & 0x80) == 0)
+      {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete)
+    {
+      // Malformed length: the stream can't be resynchronized
+      return headerSize <= 4;
+    }
+
+    uint32_t packetSize = headerSize + remainingLength;
+    if (packetSize > bufferSize)
+    {
+      rxSkip = packetSize;
+      continue;
+    }
+    if (packetSize > rxLength)
+    {
+      // Wait for the end of the packet
+      break;
+    }
+
+    if (!handlePacket(rxBuffer, packetSize, headerSize))
+    {
+      // Fields longer than the packet: protocol violation, the connection is dropped
+      rxLength = 0;
+      return false;
+    }
+    memmove(rxBuffer, rxBuffer + packetSize, rxLength - packetSize);
+    rxLength -= packetSize;
+  }
+  return true;
+}
+
+/**
+ * Handle one complete packet received, false if it is malformed
+ * The lengths given by the broker are checked against the size of the packet before any access
+ */
+bool SIM808MqttClient::handlePacket(uint8_t *packet, uint16_t size, uint8_t headerSize)
+{
+  uint8_t type = packet[0] & 0xf0;
+  pingPending = false;
+
+  switch (type)
+  {
+  case MQTT_PUBLISH:
+  {
+    uint8_t qos = (packet[0] >> 1) & 0x03;
+    uint16_t pos = headerSize;
+    if (qos > 1 || (uint32_t)pos + 2 > size)
+    {
+      return false;
+    }
+    uint16_t topicLength = (packet[pos] << 8) | packet[pos + 1];
+    pos += 2;
+    if ((uint32_t)pos + topicLength + (qos > 0 ? 2 : 0) > size)
+    {
+      return false;
+    }
+
+    // Move the topic one byte back to NUL terminate it in place
+    char *topic = (char *)packet + pos - 1;
+    memmove(topic, packet + pos, topicLength);
+    topic[topicLength] = 0;
+    pos += topicLength;
+
+    uint16_t packetId = 0;
+    if (qos > 0)
+    {
+      packetId = (packet[pos] << 8) | packet[pos + 1];
+      pos += 2;
+    }
+
+    if (callback != NULL)
+    {
+      callback(topic, packet + pos, size - pos);
+    }
+    if (qos > 0)
+    {
+      sendShortPacket(MQTT_PUBACK, packetId, true);
+    }
+    break;
+  }
+  case MQTT_CONNACK:
+    if ((uint32_t)headerSize + 2 > size)
+    {
+      return false;
+    }
+    connackCode = packet[headerSize + 1];
+    break;
+  case MQTT_PUBACK:
+    if ((uint32_t)headerSize + 2 > size)
+    {
+      return false;
+    }
+    removeQueued((packet[headerSize] << 8) | packet[headerSize + 1]);
+    break;
+  default:
+    // SUBACK, PINGRESP: nothing more to do, waitPacket() checks the type
+    break;
+  }
+
+  if (type == waitedType)
+  {
+    waitedSeen = true;
+  }
+  return true;
+}
+
+/**
+ * Wait for a packet of a given type (CONNACK or SUBACK)
+ */
+bool SIM808MqttClient::waitPacket(uint8_t type, uint16_t timeoutMs)
+{
+  waitedType = type & 0xf0;
+  waitedSeen = false;
+  uint32_t timerStart = millis();
+  while (millis() - timerStart < timeoutMs && !waitedSeen)
+  {
+    if (!readPackets())
+    {
+      break;
+    }
+  }
+  waitedType = 0;
+  return waitedSeen;
+}
+
+/*****************************************************************************************
+ * PUBLISH QUEUE
+ *****************************************************************************************/
+
+/**
+ * Copy the packet in the TX buffer at the end of the queue
+ */
+bool SIM808MqttClient::queuePacket(uint16_t size)
+{
+  if (queueUsed + 3 + size > queueSize)
+  {
+    return false;
+  }
+  queueBuffer[queueUsed++] = size & 0xff;
+  queueBuffer[queueUsed++] = size >> 8;
+  queueBuffer[queueUsed++] = 0;
+  memcpy(queueBuffer + queueUsed, txBuffer, size);
+  queueUsed += size;
+  return true;
+}
+
+/**
+ * Send the queued packets; QoS 0 are removed once sent, QoS 1 stay until PUBACK
+ * The packets already sent are sent again only on retransmission
+ */
+void SIM808MqttClient::sendQueue(bool retransmit)
+{
+  lastQueueSend = millis();
+  uint16_t pos = 0;
+  while (pos < queueUsed)
+  {
+    uint16_t size = queueBuffer[pos] | (queueBuffer[pos + 1] << 8);
+    uint8_t *packet = queueBuffer + pos + 3;
+
+    // Set DUP on retransmission
+    if (queueBuffer[pos + 2])
+    {
+      if (!retransmit)
+      {
+        pos += 3 + size;
+        continue;
+      }
+      packet[0] |= 0x08;
+    }
+    if (!sendPacket(packet, size))
+    {
+      isConnected = false;
+      return;
+    }
+
+    if ((packet[0] & 0x06) == 0)
+    {
+      memmove(queueBuffer + pos, queueBuffer + pos + 3 + size, queueUsed - pos - 3 - size);
+      queueUsed -= 3 + size;
+    }
+    else
+    {
+      queueBuffer[pos + 2] = 1;
+      pos += 3 + size;
+    }
+  }
+}
+
+/**
+ * Remove the QoS 1 message acknowledged
+ */
+void SIM808MqttClient::removeQueued(uint16_t packetId)
+{
+  uint16_t pos = 0;
+  while (pos < queueUsed)
+  {
+    uint16_t size = queueBuffer[pos] | (queueBuffer[pos + 1] << 8);
+    uint8_t *packet = queueBuffer + pos + 3;
+
+    // Packet id follows the topic in a QoS 1 PUBLISH
+    uint8_t headerSize = 2;
+    while (headerSize < 5 && headerSize < size && (packet[headerSize - 1] & 0x80))
+    {
+      headerSize++;
+    }
+    uint32_t idPos = headerSize + 2;
+    if (idPos <= size)
+    {
+      idPos += (packet[headerSize] << 8) | packet[headerSize + 1];
+    }
+    if ((packet[0] & 0x06) != 0 && idPos + 2 <= size && ((packet[idPos] << 8) | packet[idPos + 1]) == packetId)
+    {
+      memmove(queueBuffer + pos, queueBuffer + pos + 3 + size, queueUsed - pos - 3 - size);
+      queueUsed -= 3 + size;
+      return;
+    }
+    pos += 3 + size;
+  }
+}
+
+#endif // SIM808_TCPIP
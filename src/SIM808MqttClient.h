@@ -0,0 +1,149 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Lightweight MQTT 3.1.1 client (QoS 0/1) on a TCP connection of the module    *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_MQTT_CLIENT_H_
+#define _SIM808_MQTT_CLIENT_H_
+
+#include "SIM808Driver.h"
+
+#if !SIM808_TCPIP
+#error "SIM808MqttClient needs the TCP/IP subsystem (SIM808_TCPIP)"
+#endif
+
+#define MQTT_DEFAULT_KEEP_ALIVE 60
+#define MQTT_DEFAULT_TIMEOUT 10000
+#define MQTT_RETRY_TIMEOUT 20000
+
+class SIM808MqttClient
+{
+public:
+  // Callback called for each message received on a subscribed topic
+  // The topic is a NUL terminated string, the payload is binary (size given)
+  typedef void (*MessageCallback)(const char *topic, const uint8_t *payload, uint16_t size);
+
+  // Initialize the client
+  // Parameters:
+  //  _driver : driver with the TCP/IP stack started (see startTCPIP)
+  //  _mux (optional) : link number of the TCP connection used by the client
+  //  _bufferSize (optional) : size in bytes of the packet buffers (largest packet sent or received)
+  //  _queueSize (optional) : size in bytes of the publish queue (messages waiting to be sent or acknowledged)
+  // If the buffers cannot be allocated, connect() returns MQTT_NO_MEMORY
+  SIM808MqttClient(SIM808Driver *_driver, uint8_t _mux = 0, uint16_t _bufferSize = 128, uint16_t _queueSize = 256);
+  ~SIM808MqttClient();
+
+  enum ConnectResult
+  {
+    MQTT_CONNECTED,
+    MQTT_BAD_PROTOCOL,
+    MQTT_ID_REJECTED,
+    MQTT_SERVER_UNAVAILABLE,
+    MQTT_BAD_CREDENTIALS,
+    MQTT_UNAUTHORIZED,
+    MQTT_TCP_FAILED,
+    MQTT_TIMEOUT,
+    MQTT_PACKET_TOO_LARGE,
+    MQTT_NO_MEMORY
+  };
+
+  // Configuration (host is kept as pointer, must stay valid)
+  void setServer(const char *host, uint16_t port);
+  void setCallback(MessageCallback callback);
+  void setKeepAlive(uint16_t seconds);
+
+  // Session
+  ConnectResult connect(const char *clientId, const char *user = NULL, const char *password = NULL, bool cleanSession = true);
+  void disconnect();
+  bool connected();
+
+  // Publish a message (QoS 0 or 1)
+  // The message is queued if the client is not connected, QoS 1 messages stay queued until acknowledged
+  bool publish(const char *topic, const uint8_t *payload, uint16_t size, uint8_t qos = 0, bool retain = false);
+  bool publish(const char *topic, const char *payload, uint8_t qos = 0, bool retain = false);
+
+  // Subscribe to a topic (QoS 0 or 1)
+  bool subscribe(const char *topic, uint8_t qos = 0);
+
+  // To call in the loop: read the incoming packets, send the queue and keep the connection alive
+  // Returns false if the connection is lost
+  bool loop();
+
+  // Number of bytes used in the publish queue
+  uint16_t getQueueUsed();
+
+protected:
+  // Packet encoding
+  uint16_t writeHeader(uint8_t type, uint16_t remainingLength);
+  uint16_t writeString(uint16_t pos, const char *str);
+  bool sendPacket(const uint8_t *packet, uint16_t size);
+  bool sendShortPacket(uint8_t type, uint16_t packetId, bool withId);
+
+  // Incoming packets
+  bool readPackets();
+  bool handlePacket(uint8_t *packet, uint16_t size, uint8_t headerSize);
+  bool waitPacket(uint8_t type, uint16_t timeoutMs);
+
+  // Publish queue: entries [length LSB][length MSB][sent flag][packet]
+  bool queuePacket(uint16_t size);
+  void sendQueue(bool retransmit);
+  void removeQueued(uint16_t packetId);
+
+private:
+  SIM808Driver *driver = NULL;
+  uint8_t mux = 0;
+
+  const char *host = NULL;
+  uint16_t port = 1883;
+  MessageCallback callback = NULL;
+  uint16_t keepAlive = MQTT_DEFAULT_KEEP_ALIVE;
+
+  // Packet buffers
+  uint8_t *txBuffer = NULL;
+  uint8_t *rxBuffer = NULL;
+  uint16_t bufferSize = 0;
+  uint16_t rxLength = 0;
+  uint32_t rxSkip = 0;
+
+  // Publish queue
+  uint8_t *queueBuffer = NULL;
+  uint16_t queueSize = 0;
+  uint16_t queueUsed = 0;
+  uint32_t lastQueueSend = 0;
+
+  // Session state
+  bool isConnected = false;
+  uint16_t nextPacketId = 1;
+  uint8_t waitedType = 0;
+  bool waitedSeen = false;
+  uint8_t connackCode = 0;
+  uint32_t lastOutbound = 0;
+  uint32_t pingSentAt = 0;
+  bool pingPending = false;
+};
+
+#endif // _SIM808_MQTT_CLIENT_H_
@@ -0,0 +1,476 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Store-and-forward queue of HTTP POST records with retry, exponential backoff *
+ * and coalescing of small records into a single body                           *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Config.h"
+
+#if SIM808_HTTP
+#include "SIM808RequestQueue.h"
+
+/**
+ * Constructor; prepare the RAM ring and the batch buffer
+ */
+SIM808RequestQueue::SIM808RequestQueue(SIM808Driver *_driver, const char *_url, const char *_contentType, uint16_t _queueSize, uint16_t _batchSize, Stream *_spillStream)
+{
+  driver = _driver;
+  url = _url;
+  contentType = _contentType;
+  spillStream = _spillStream;
+
+  // The batch buffer has 2 more bytes to stage a spilled record with its length
+  queueBuffer = (uint8_t *)malloc(_queueSize);
+  batchBuffer = (uint8_t *)malloc(_batchSize + 2);
+  if (queueBuffer == NULL || batchBuffer == NULL)
+  {
+    // Out of memory: every record is refused
+    free(queueBuffer);
+    free(batchBuffer);
+    queueBuffer = NULL;
+    batchBuffer = NULL;
+    return;
+  }
+  queueSize = _queueSize;
+  batchSize = _batchSize;
+}
+
+/**
+ * Destructor; cleanup the memory allocated by the queue
+ */
+SIM808RequestQueue::~SIM808RequestQueue()
+{
+  free(queueBuffer);
+  free(batchBuffer);
+}
+
+/*****************************************************************************************
+ * CONFIGURATION
+ *****************************************************************************************/
+
+void SIM808RequestQueue::setHeaders(const char *_headers)
+{
+  headers = _headers;
+}
+
+void SIM808RequestQueue::setCoalescing(const char *_prefix, const char *_separator, const char *_suffix)
+{
+  prefix = _prefix;
+  separator = _separator;
+  suffix = _suffix;
+}
+
+void SIM808RequestQueue::setBackoff(uint32_t minMs, uint32_t maxMs)
+{
+  minBackoff = minMs;
+  maxBackoff = maxMs;
+}
+
+void SIM808RequestQueue::setTimeouts(uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs)
+{
+  clientWriteTimeout = clientWriteTimeoutMs;
+  serverReadTimeout = serverReadTimeoutMs;
+}
+
+/*****************************************************************************************
+ * QUEUE FUNCTIONS
+ *****************************************************************************************/
+
+/**
+ * Add a record to the queue
+ * Goes to the RAM ring, or to the spill stream if the ring is full (or if older records are already spilled)
+ */
+bool SIM808RequestQueue::enqueue(const uint8_t *data, uint16_t size)
+{
+  if (queueBuffer == NULL)
+  {
+    droppedRecords++;
+    return false;
+  }
+
+  // A record that cannot fit in a body alone will never be sent, an empty one would read as a lost spill
+  uint16_t overhead = (prefix != NULL ? strlen(prefix) : 0) + (suffix != NULL ? strlen(suffix) : 0);
+  if (size == 0 || (uint32_t)size + overhead > batchSize || (uint32_t)size + 2 > queueSize)
+  {
+    droppedRecords++;
+    return false;
+  }
+
+  uint8_t length[2] = {(uint8_t)(size & 0xff), (uint8_t)(size >> 8)};
+
+  // Keep the order: once something is spilled, everything goes to the spill until it is drained
+  if (!spillHasData() && freeSpace() >= size + 2)
+  {
+    pushBytes(length, 2);
+    pushBytes(data, size);
+    queueRecords++;
+    return true;
+  }
+
+  // The length and the data are written in one call, so a failed write does not leave a length alone
+  if (spillStream != NULL)
+  {
+    memcpy(batchBuffer, length, 2);
+    memcpy(batchBuffer + 2, data, size);
+    if (spillStream->write(batchBuffer, size + 2) == (size_t)size + 2)
+    {
+      spillStream->flush();
+      spillRecords++;
+      return true;
+    }
+  }
+
+  droppedRecords++;
+  return false;
+}
+
+bool SIM808RequestQueue::enqueue(const char *data)
+{
+  return enqueue((const uint8_t *)data, strlen(data));
+}
+
+/**
+ * Send the next batch if the backoff delay is elapsed and wait for the answer of the server
+ */
+uint16_t SIM808RequestQueue::process()
+{
+  uint16_t rc = processStep();
+  while (waiting)
+  {
+    rc = processStep();
+  }
+  return rc;
+}
+
+/**
+ * Start the next batch if the backoff delay is elapsed, or check the answer of the batch started
+ */
+uint16_t SIM808RequestQueue::processStep()
+{
+  if (waiting)
+  {
+    uint16_t rc = driver->pollHTTP();
+    if (rc == 0)
+    {
+      return 0;
+    }
+    waiting = false;
+    return endBatch(rc);
+  }
+
+  refillFromSpill();
+
+  if (queueRecords == 0)
+  {
+    return 0;
+  }
+
+  if (currentBackoff > 0 && millis() - lastAttempt < currentBackoff)
+  {
+    return 0;
+  }
+  lastAttempt = millis();
+
+  // Bring the bearer up if the last attempt failed because of it, no request without it
+  if (!bearerUp)
+  {
+    bearerUp = driver->connectGPRS();
+    if (!bearerUp)
+    {
+      increaseBackoff();
+      return 0;
+    }
+  }
+
+  uint16_t batchLength = 0;
+  batchRecords = buildBatch(&batchLength, &batchRecordsBytes);
+
+  uint16_t rc = driver->startPost(url, headers, contentType, batchBuffer, batchLength, clientWriteTimeout, serverReadTimeout);
+  if (rc > 0)
+  {
+    return endBatch(rc);
+  }
+  waiting = true;
+  return 0;
+}
+
+/**
+ * Remove the records of the batch sent, or keep them for a retry, depending on the code of the request
+ */
+uint16_t SIM808RequestQueue::endBatch(uint16_t code)
+{
+  lastCode = code;
+
+  if (lastCode >= 200 && lastCode < 300)
+  {
+    // Success: remove the records sent
+    dropBytes(batchRecordsBytes);
+    queueRecords -= batchRecords;
+    sentRecords += batchRecords;
+    currentBackoff = 0;
+  }
+  else if (!isRetryable(lastCode))
+  {
+    // Rejected by the server, retrying won't help
+    dropBytes(batchRecordsBytes);
+    queueRecords -= batchRecords;
+    droppedRecords += batchRecords;
+    currentBackoff = 0;
+  }
+  else
+  {
+    increaseBackoff();
+
+    // 7xx: the session could not be set up on the module, probably no bearer
+    // 601: network error
+    if ((lastCode >= 700 && lastCode < 800) || lastCode == 601)
+    {
+      bearerUp = false;
+    }
+  }
+
+  return lastCode;
+}
+
+bool SIM808RequestQueue::isWaiting()
+{
+  return waiting;
+}
+
+/**
+ * Build the body of the next request from the head of the ring
+ */
+uint8_t SIM808RequestQueue::buildBatch(uint16_t *batchLength, uint16_t *recordsBytes)
+{
+  uint16_t prefixLength = prefix != NULL ? strlen(prefix) : 0;
+  uint16_t separatorLength = separator != NULL ? strlen(separator) : 0;
+  uint16_t suffixLength = suffix != NULL ? strlen(suffix) : 0;
+
+  uint16_t length = 0;
+  uint16_t offset = 0;
+  uint8_t records = 0;
+
+  if (prefixLength > 0)
+  {
+    memcpy(batchBuffer, prefix, prefixLength);
+    length += prefixLength;
+  }
+
+  while (records < queueRecords && records < 255)
+  {
+    uint16_t recordLength = peekLength(offset);
+    uint16_t needed = recordLength + suffixLength + (records > 0 ? separatorLength : 0);
+    if (records > 0 && (separator == NULL || length + needed > batchSize))
+    {
+      break;
+    }
+
+    if (records > 0 && separatorLength > 0)
+    {
+      memcpy(batchBuffer + length, separator, separatorLength);
+      length += separatorLength;
+    }
+    for (uint16_t i = 0; i < recordLength; i++)
+    {
+      batchBuffer[length++] = peekByte(offset + 2 + i);
+    }
+    offset += recordLength + 2;
+    records++;
+  }
+
+  if (suffixLength > 0)
+  {
+    memcpy(batchBuffer + length, suffix, suffixLength);
+    length += suffixLength;
+  }
+
+  *batchLength = length;
+  *recordsBytes = offset;
+  return records;
+}
+
+/**
+ * True while the spill stream holds records not moved to the RAM ring yet
+ * The unread bytes of the stream are used rather than spillRecords: the records written before a reset
+ * of the board are found again
+ */
+bool SIM808RequestQueue::spillHasData()
+{
+  return spillStream != NULL && (spillPendingRead || spillStream->available() > 0);
+}
+
+/**
+ * Move the spilled records back to the RAM ring while there is room
+ * The data of a record is read in the batch buffer first: a short read drops the record instead of
+ * queuing missing bytes
+ */
+void SIM808RequestQueue::refillFromSpill()
+{
+  while (spillHasData())
+  {
+    // Read the length first and keep it until there is enough room for the data
+    if (!spillPendingRead)
+    {
+      uint8_t length[2];
+      spillPendingLength = 0;
+      if (spillStream->readBytes(length, 2) == 2)
+      {
+        spillPendingLength = length[0] | (length[1] << 8);
+      }
+      if (spillPendingLength == 0 || spillPendingLength > batchSize || spillPendingLength + 2 > queueSize)
+      {
+        // Spill lost or corrupted (e.g. storage erased), the records can't be found again
+        dropSpill();
+        return;
+      }
+      spillPendingRead = true;
+    }
+
+    if (freeSpace() < spillPendingLength + 2)
+    {
+      return;
+    }
+
+    spillPendingRead = false;
+    if (spillRecords > 0)
+    {
+      spillRecords--;
+    }
+    if (spillStream->readBytes(batchBuffer, spillPendingLength) != spillPendingLength)
+    {
+      droppedRecords++;
+      continue;
+    }
+    uint8_t length[2] = {(uint8_t)(spillPendingLength & 0xff), (uint8_t)(spillPendingLength >> 8)};
+    pushBytes(length, 2);
+    pushBytes(batchBuffer, spillPendingLength);
+    queueRecords++;
+  }
+}
+
+/**
+ * Forget the content of the spill stream (read until its end)
+ */
+void SIM808RequestQueue::dropSpill()
+{
+  while (spillStream->available() > 0)
+  {
+    spillStream->read();
+  }
+  droppedRecords += spillRecords > 0 ? spillRecords : 1;
+  spillRecords = 0;
+  spillPendingRead = false;
+}
+
+/**
+ * Exponential backoff after a failure
+ */
+void SIM808RequestQueue::increaseBackoff()
+{
+  currentBackoff = currentBackoff == 0 ? minBackoff : currentBackoff * 2;
+  if (currentBackoff > maxBackoff)
+  {
+    currentBackoff = maxBackoff;
+  }
+}
+
+/**
+ * Client errors are not retried, except timeout (408) and too many requests (429)
+ */
+bool SIM808RequestQueue::isRetryable(uint16_t code)
+{
+  if (code >= 400 && code < 500)
+  {
+    return code == 408 || code == 429;
+  }
+  return true;
+}
+
+/*****************************************************************************************
+ * STATUS
+ *****************************************************************************************/
+
+uint16_t SIM808RequestQueue::getPendingRecords()
+{
+  return queueRecords + spillRecords;
+}
+
+uint32_t SIM808RequestQueue::getSentRecords()
+{
+  return sentRecords;
+}
+
+uint32_t SIM808RequestQueue::getDroppedRecords()
+{
+  return droppedRecords;
+}
+
+uint16_t SIM808RequestQueue::getLastCode()
+{
+  return lastCode;
+}
+
+bool SIM808RequestQueue::isEmpty()
+{
+  return getPendingRecords() == 0 && !spillHasData();
+}
+
+/*****************************************************************************************
+ * RAM RING HELPERS
+ *****************************************************************************************/
+
+uint16_t SIM808RequestQueue::freeSpace()
+{
+  return queueSize - queueUsed;
+}
+
+void SIM808RequestQueue::pushBytes(const uint8_t *data, uint16_t size)
+{
+  for (uint16_t i = 0; i < size; i++)
+  {
+    queueBuffer[(uint32_t)(queueHead + queueUsed) % queueSize] = data[i];
+    queueUsed++;
+  }
+}
+
+uint8_t SIM808RequestQueue::peekByte(uint16_t offset)
+{
+  return queueBuffer[(uint32_t)(queueHead + offset) % queueSize];
+}
+
+uint16_t SIM808RequestQueue::peekLength(uint16_t offset)
+{
+  return peekByte(offset) | (peekByte(offset + 1) << 8);
+}
+
+void SIM808RequestQueue::dropBytes(uint16_t size)
+{
+  queueHead = (uint32_t)(queueHead + size) % queueSize;
+  queueUsed -= size;
+}
+
+#endif // SIM808_HTTP
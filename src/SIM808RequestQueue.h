@@ -0,0 +1,166 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Store-and-forward queue of HTTP POST records with retry, exponential backoff *
+ * and coalescing of small records into a single body                           *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_REQUEST_QUEUE_H_
+#define _SIM808_REQUEST_QUEUE_H_
+
+#include "SIM808Driver.h"
+
+#if !SIM808_HTTP
+#error "SIM808RequestQueue needs the HTTP subsystem (SIM808_HTTP)"
+#endif
+
+#define QUEUE_DEFAULT_MIN_BACKOFF 5000
+#define QUEUE_DEFAULT_MAX_BACKOFF 600000
+
+class SIM808RequestQueue
+{
+public:
+  // Initialize the queue
+  // Parameters:
+  //  _driver : driver used to send the requests
+  //  _url : URL where the records are posted (kept as pointer, must stay valid)
+  //  _contentType : content type of the body (kept as pointer, must stay valid)
+  //  _queueSize (optional) : size in bytes of the RAM ring holding the records (2 bytes of overhead per record)
+  //  _batchSize (optional) : size in bytes of the buffer used to build the body of one request
+  //  _spillStream (optional) : Stream used when the RAM ring is full, it must give back the bytes in the
+  //                            order they were written (FIFO), e.g. a wrapper of an EEPROM area or a file
+  //                            Each record is written in one write() call, which has to write all or nothing
+  //                            available() has to give the bytes not read yet: the records left in the
+  //                            spill by a reset of the board are sent when the queue of the new run is
+  //                            processed (the stream has to keep its read and write positions)
+  // If the buffers cannot be allocated, every record is refused
+  SIM808RequestQueue(SIM808Driver *_driver, const char *_url, const char *_contentType, uint16_t _queueSize = 256, uint16_t _batchSize = 128, Stream *_spillStream = NULL);
+  ~SIM808RequestQueue();
+
+  // Configuration
+  // Headers sent with each request (kept as pointer, must stay valid)
+  void setHeaders(const char *headers);
+  // Coalesce several records in one body: prefix + record + separator + record ... + suffix
+  // Without separator (default) each record is posted alone
+  void setCoalescing(const char *prefix, const char *separator, const char *suffix);
+  // Delay before retrying after a failure, doubled at each failure up to maxMs
+  void setBackoff(uint32_t minMs, uint32_t maxMs);
+  void setTimeouts(uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+
+  // Add a record to the queue, false if there is no room left or if it is empty (record dropped)
+  bool enqueue(const uint8_t *data, uint16_t size);
+  bool enqueue(const char *data);
+
+  // To call in the loop: send the next batch when the backoff delay is elapsed
+  // Returns the code of the request sent (see doPost), or 0 if nothing was sent (also when the
+  // bearer could not be connected, the backoff delay applies before the next try)
+  uint16_t process();
+  // Same without waiting for the server (see SIM808Driver::startPost): a call starts the request and
+  // returns 0, the next calls return 0 until the answer is received, then its code
+  uint16_t processStep();
+  // True while a request started by processStep() waits for the server
+  bool isWaiting();
+
+  // Status of the queue
+  // The records left in the spill by a previous run are counted once they are moved to the RAM ring
+  uint16_t getPendingRecords();
+  uint32_t getSentRecords();
+  uint32_t getDroppedRecords();
+  uint16_t getLastCode();
+  bool isEmpty();
+
+protected:
+  // Manage the RAM ring
+  uint16_t freeSpace();
+  void pushBytes(const uint8_t *data, uint16_t size);
+  uint8_t peekByte(uint16_t offset);
+  uint16_t peekLength(uint16_t offset);
+  void dropBytes(uint16_t size);
+
+  // Move records from the spill stream to the RAM ring when possible
+  bool spillHasData();
+  void refillFromSpill();
+  void dropSpill();
+
+  // Build the body of the next request, returns the number of records in it
+  uint8_t buildBatch(uint16_t *batchLength, uint16_t *recordsBytes);
+
+  // Update the queue with the code of the batch sent
+  uint16_t endBatch(uint16_t code);
+
+  // Double the delay before the next try
+  void increaseBackoff();
+  // Check if a failed request is worth a retry
+  bool isRetryable(uint16_t code);
+
+private:
+  SIM808Driver *driver = NULL;
+  const char *url = NULL;
+  const char *contentType = NULL;
+  const char *headers = NULL;
+
+  const char *prefix = NULL;
+  const char *separator = NULL;
+  const char *suffix = NULL;
+
+  // RAM ring of records ([length LSB][length MSB][data] each)
+  uint8_t *queueBuffer = NULL;
+  uint16_t queueSize = 0;
+  uint16_t queueHead = 0;
+  uint16_t queueUsed = 0;
+  uint16_t queueRecords = 0;
+
+  // Body of the request in progress
+  uint8_t *batchBuffer = NULL;
+  uint16_t batchSize = 0;
+  // Records of the request waiting for the server (processStep())
+  bool waiting = false;
+  uint8_t batchRecords = 0;
+  uint16_t batchRecordsBytes = 0;
+
+  // Spill area
+  Stream *spillStream = NULL;
+  uint16_t spillRecords = 0;
+  uint16_t spillPendingLength = 0;
+  bool spillPendingRead = false;
+
+  // Retry management
+  uint32_t minBackoff = QUEUE_DEFAULT_MIN_BACKOFF;
+  uint32_t maxBackoff = QUEUE_DEFAULT_MAX_BACKOFF;
+  uint32_t currentBackoff = 0;
+  uint32_t lastAttempt = 0;
+  bool bearerUp = false;
+
+  uint16_t clientWriteTimeout = 10000;
+  uint16_t serverReadTimeout = 10000;
+
+  // Statistics
+  uint32_t sentRecords = 0;
+  uint32_t droppedRecords = 0;
+  uint16_t lastCode = 0;
+};
+
+#endif // _SIM808_REQUEST_QUEUE_H_
@@ -0,0 +1,127 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Cooperative scheduler to drive several modules from one microcontroller      *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Scheduler.h"
+#if SIM808_HTTP
+#include "SIM808RequestQueue.h"
+#endif
+
+/**
+ * Add a task for a module, false if there is no slot left
+ */
+bool SIM808Scheduler::addTask(SIM808Driver *driver, Task task, void *context)
+{
+  if (taskCount >= SIM808_SCHEDULER_TASKS)
+  {
+    return false;
+  }
+
+  Slot *slot = &slots[taskCount++];
+  slot->driver = driver;
+  slot->task = task;
+  slot->context = context;
+  slot->runs = 0;
+  slot->busyRuns = 0;
+  slot->busyTime = 0;
+  return true;
+}
+
+/**
+ * Run one step of the next task (round robin)
+ */
+bool SIM808Scheduler::runNext()
+{
+  if (taskCount == 0)
+  {
+    return false;
+  }
+
+  Slot *slot = &slots[nextTask];
+  nextTask = (nextTask + 1) % taskCount;
+
+  uint32_t timerStart = millis();
+  bool busy = slot->task(slot->driver, slot->context);
+  slot->runs++;
+  if (busy)
+  {
+    slot->busyRuns++;
+    slot->busyTime += millis() - timerStart;
+  }
+  return busy;
+}
+
+/**
+ * Run one step of each task
+ */
+uint8_t SIM808Scheduler::runAll()
+{
+  uint8_t busy = 0;
+  for (uint8_t i = 0; i < taskCount; i++)
+  {
+    if (runNext())
+    {
+      busy++;
+    }
+  }
+  return busy;
+}
+
+#if SIM808_HTTP
+/**
+ * Task running the next step of the request queue given as context: busy when a batch was started or
+ * its answer received, not while the server is awaited
+ */
+bool SIM808Scheduler::processQueue(SIM808Driver * /*driver*/, void *queue)
+{
+  SIM808RequestQueue *requestQueue = (SIM808RequestQueue *)queue;
+  bool waiting = requestQueue->isWaiting();
+  uint16_t rc = requestQueue->processStep();
+  return rc > 0 || waiting != requestQueue->isWaiting();
+}
+#endif
+
+uint8_t SIM808Scheduler::getTaskCount()
+{
+  return taskCount;
+}
+
+uint32_t SIM808Scheduler::getRuns(uint8_t index)
+{
+  return index < taskCount ? slots[index].runs : 0;
+}
+
+uint32_t SIM808Scheduler::getBusyRuns(uint8_t index)
+{
+  return index < taskCount ? slots[index].busyRuns : 0;
+}
+
+uint32_t SIM808Scheduler::getBusyTime(uint8_t index)
+{
+  return index < taskCount ? slots[index].busyTime : 0;
+}
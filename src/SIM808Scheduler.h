@@ -0,0 +1,95 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Cooperative scheduler to drive several modules from one microcontroller      *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_SCHEDULER_H_
+#define _SIM808_SCHEDULER_H_
+
+#include "SIM808Driver.h"
+
+// Maximum number of tasks (usually one per module)
+#ifndef SIM808_SCHEDULER_TASKS
+#define SIM808_SCHEDULER_TASKS 4
+#endif
+
+/**
+ * Round robin scheduler giving each module a step of work in turn
+ * A step is one short job for one module (start the next batch of a queue, check its answer, poll a
+ * socket...). Only one module is served at a time, and a step ends with the data of its module read:
+ * the drivers can share the same buffers (see SIM808SharedBuffers)
+ * The wait of the server (AT+HTTPACTION) is not part of a step with processQueue: the modules wait for
+ * their servers at the same time. The rest of a request still blocks (session set up, payload upload,
+ * reading of the answer)
+ * Limit: nothing reads the serial of the other modules during a step. A blocking step (a task calling
+ * doPost...) lets them send far more than the 64 bytes of an AVR serial buffer, so their URCs and late
+ * answers are lost. Keep the URCs off (AT+CREG=0...) on modules driven by the scheduler, or give their
+ * serials a larger buffer
+ */
+class SIM808Scheduler
+{
+public:
+  // One step of work for a module, returns true if something was done
+  typedef bool (*Task)(SIM808Driver *driver, void *context);
+
+  // Add a task for a module, false if there is no slot left
+  bool addTask(SIM808Driver *driver, Task task, void *context = NULL);
+
+  // Run one step of the next task, returns true if the task did something
+  bool runNext();
+  // Run one step of each task, returns the number of tasks which did something
+  uint8_t runAll();
+
+#if SIM808_HTTP
+  // Ready-made task running the next step of a SIM808RequestQueue given as context (processStep())
+  static bool processQueue(SIM808Driver *driver, void *queue);
+#endif
+
+  // Statistics per task (index in the order of addTask)
+  uint8_t getTaskCount();
+  uint32_t getRuns(uint8_t index);
+  uint32_t getBusyRuns(uint8_t index);
+  // Time spent in the steps of the task (ms), while the other modules were waiting
+  uint32_t getBusyTime(uint8_t index);
+
+private:
+  struct Slot
+  {
+    SIM808Driver *driver;
+    Task task;
+    void *context;
+    uint32_t runs;
+    uint32_t busyRuns;
+    uint32_t busyTime;
+  };
+
+  Slot slots[SIM808_SCHEDULER_TASKS];
+  uint8_t taskCount = 0;
+  uint8_t nextTask = 0;
+};
+
+#endif // _SIM808_SCHEDULER_H_
@@ -0,0 +1,366 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Binary trace of the serial link with the module (record and replay)          *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM808Trace.h"
+
+/*****************************************************************************************
+ * RECORDER
+ *****************************************************************************************/
+
+/**
+ * Constructor; Record on an output
+ */
+SIM808TraceStream::SIM808TraceStream(Stream *_module, Print *_output)
+{
+  module = _module;
+  output = _output;
+}
+
+/**
+ * Constructor; Record in a ring buffer given by the caller
+ */
+SIM808TraceStream::SIM808TraceStream(Stream *_module, uint8_t *_ring, uint16_t _ringSize)
+{
+  module = _module;
+  ring = _ring;
+  ringSize = _ringSize;
+}
+
+/**
+ * Pause/resume the recording (the pending burst is written when paused)
+ */
+void SIM808TraceStream::setRecording(bool enable)
+{
+  if (!enable)
+  {
+    flushTrace();
+  }
+  recording = enable;
+}
+
+/**
+ * Write the pending burst as a record
+ */
+void SIM808TraceStream::flushTrace()
+{
+  if (burstSize == 0)
+  {
+    return;
+  }
+
+  uint8_t header[TRACE_HEADER_SIZE];
+  header[0] = burstType;
+  header[1] = burstStart & 0xFF;
+  header[2] = (burstStart >> 8) & 0xFF;
+  header[3] = (burstStart >> 16) & 0xFF;
+  header[4] = (burstStart >> 24) & 0xFF;
+  header[5] = burstSize;
+  writeRecord(header, burst, burstSize);
+  burstSize = 0;
+}
+
+/**
+ * Write the content of the ring buffer on the output, oldest record first
+ * Nothing to dump when recording on an output (the records are already written there)
+ */
+void SIM808TraceStream::dumpTrace(Print *_output)
+{
+  flushTrace();
+  if (ring == NULL)
+  {
+    return;
+  }
+  uint16_t tail = (ringHead + ringSize - ringUsed) % ringSize;
+  for (uint16_t i = 0; i < ringUsed; i++)
+  {
+    _output->write(ring[(tail + i) % ringSize]);
+  }
+}
+
+/**
+ * Number of records dropped because the ring buffer was full
+ */
+uint16_t SIM808TraceStream::getDroppedRecords()
+{
+  return dropped;
+}
+
+/**
+ * Add a byte to the current burst, a new burst is started when the direction changes,
+ * when the burst is full or after a silence
+ */
+void SIM808TraceStream::record(uint8_t type, uint8_t c)
+{
+  if (!recording)
+  {
+    return;
+  }
+
+  uint32_t now = millis();
+  if (burstSize > 0 && (type != burstType || burstSize == SIM808_TRACE_BURST_SIZE || now - burstLast > TRACE_BURST_GAP))
+  {
+    flushTrace();
+  }
+
+  if (burstSize == 0)
+  {
+    burstType = type;
+    burstStart = now;
+  }
+  burst[burstSize++] = c;
+  burstLast = now;
+}
+
+/**
+ * Write a record on the output or in the ring buffer (dropping the oldest records to make room)
+ */
+void SIM808TraceStream::writeRecord(const uint8_t *header, const uint8_t *data, uint8_t size)
+{
+  if (output != NULL)
+  {
+    output->write(header, TRACE_HEADER_SIZE);
+    output->write(data, size);
+    return;
+  }
+
+  uint16_t recordSize = TRACE_HEADER_SIZE + size;
+  if (recordSize > ringSize)
+  {
+    dropped++;
+    return;
+  }
+
+  // Drop the oldest records until the new one fits
+  while (ringSize - ringUsed < recordSize)
+  {
+    uint16_t tail = (ringHead + ringSize - ringUsed) % ringSize;
+    ringUsed -= TRACE_HEADER_SIZE + ring[(tail + TRACE_HEADER_SIZE - 1) % ringSize];
+    dropped++;
+  }
+
+  for (uint8_t i = 0; i < TRACE_HEADER_SIZE; i++)
+  {
+    ringWrite(header[i]);
+  }
+  for (uint8_t i = 0; i < size; i++)
+  {
+    ringWrite(data[i]);
+  }
+}
+
+/**
+ * Write a byte in the ring buffer (room is already made)
+ */
+void SIM808TraceStream::ringWrite(uint8_t b)
+{
+  ring[ringHead] = b;
+  ringHead = (ringHead + 1) % ringSize;
+  ringUsed++;
+}
+
+int SIM808TraceStream::available()
+{
+  return module->available();
+}
+
+int SIM808TraceStream::read()
+{
+  int c = module->read();
+  if (c >= 0)
+  {
+    record(TRACE_RECORD_RX, c);
+  }
+  return c;
+}
+
+int SIM808TraceStream::peek()
+{
+  return module->peek();
+}
+
+size_t SIM808TraceStream::write(uint8_t c)
+{
+  record(TRACE_RECORD_TX, c);
+  return module->write(c);
+}
+
+/**
+ * Bulk write, given as is to the module link (one call for a whole command line)
+ */
+size_t SIM808TraceStream::write(const uint8_t *buffer, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    record(TRACE_RECORD_TX, buffer[i]);
+  }
+  return module->write(buffer, size);
+}
+
+/**
+ * Flush the module link, the bytes sent are written as a record
+ */
+void SIM808TraceStream::flush()
+{
+  module->flush();
+  flushTrace();
+}
+
+/*****************************************************************************************
+ * REPLAY
+ *****************************************************************************************/
+
+/**
+ * Constructor; the trace is read record per record from the stream (file, serial...)
+ * With realTime, the bytes received are given back with the delays of the recording
+ */
+SIM808TraceReplay::SIM808TraceReplay(Stream *_trace, bool _realTime)
+{
+  trace = _trace;
+  realTime = _realTime;
+}
+
+/**
+ * True when the whole trace was played
+ */
+bool SIM808TraceReplay::isFinished()
+{
+  return !loadRecord();
+}
+
+/**
+ * Number of bytes written by the driver which are different from the trace
+ */
+uint32_t SIM808TraceReplay::getMismatches()
+{
+  return mismatches;
+}
+
+/**
+ * Load the header of the next record if the current one is played
+ * The record is due after the same delay as between the previous record and this one in the recording
+ */
+bool SIM808TraceReplay::loadRecord()
+{
+  if (loaded)
+  {
+    return true;
+  }
+  if (finished || trace->available() < TRACE_HEADER_SIZE)
+  {
+    finished = true;
+    return false;
+  }
+
+  recordType = trace->read();
+  recordTime = 0;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    recordTime |= (uint32_t)(trace->read() & 0xFF) << (8 * i);
+  }
+  recordLeft = trace->read();
+
+  dueTime = millis() + (previousTime > 0 ? recordTime - previousTime : 0);
+  previousTime = recordTime;
+  loaded = recordLeft > 0;
+  return loadRecord();
+}
+
+/**
+ * Bytes received available only when the previous bytes sent were written by the driver
+ */
+int SIM808TraceReplay::available()
+{
+  if (!loadRecord() || recordType != TRACE_RECORD_RX)
+  {
+    return 0;
+  }
+  if (realTime && (int32_t)(millis() - dueTime) < 0)
+  {
+    return 0;
+  }
+  return recordLeft;
+}
+
+int SIM808TraceReplay::read()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  int c = trace->read();
+  if (--recordLeft == 0)
+  {
+    loaded = false;
+  }
+  return c;
+}
+
+int SIM808TraceReplay::peek()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return trace->peek();
+}
+
+/**
+ * Bytes written by the driver are compared to the bytes sent in the recording
+ * Bytes received still pending are skipped: in the recording, they were purged before sending
+ */
+size_t SIM808TraceReplay::write(uint8_t c)
+{
+  while (loadRecord() && recordType == TRACE_RECORD_RX)
+  {
+    for (; recordLeft > 0; recordLeft--)
+    {
+      trace->read();
+    }
+    loaded = false;
+  }
+
+  if (!loadRecord() || recordType != TRACE_RECORD_TX)
+  {
+    mismatches++;
+    return 1;
+  }
+  if (trace->read() != c)
+  {
+    mismatches++;
+  }
+  if (--recordLeft == 0)
+  {
+    loaded = false;
+  }
+  return 1;
+}
+
+void SIM808TraceReplay::flush()
+{
+}
@@ -0,0 +1,143 @@
+/********************************************************************************
+ * SIM808-arduino-driver                                                        *
+ * ----------------------                                                       *
+ * Binary trace of the serial link with the module (record and replay)          *
+ * Author: Amin Mokhtari                                                        *
+ * Source: https://github.com/aminmokhtari94/SIM808-arduino-driver              *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Amin Mokhtari
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM808_TRACE_H_
+#define _SIM808_TRACE_H_
+
+#include <Arduino.h>
+
+// Maximum size of a burst (bytes kept in RAM before writing a record)
+#ifndef SIM808_TRACE_BURST_SIZE
+#define SIM808_TRACE_BURST_SIZE 32
+#endif
+
+// A burst is closed when no byte is seen for this time (ms)
+#define TRACE_BURST_GAP 5
+
+// Record format (little endian): type ('T' sent to the module, 'R' received), timestamp (uint32, ms), length (uint8), data
+#define TRACE_RECORD_TX 'T'
+#define TRACE_RECORD_RX 'R'
+#define TRACE_HEADER_SIZE 6
+
+/**
+ * Stream placed between the driver and the module which records all the bytes exchanged
+ * The trace is written on an output (SD card file, serial...) or kept in a ring buffer in RAM
+ * Usage: SIM808TraceStream trace(&Serial1, &traceFile); SIM808Driver sim808(&trace, ...);
+ */
+class SIM808TraceStream : public Stream
+{
+public:
+  // Record on an output (nothing is dropped, the output should be fast enough)
+  SIM808TraceStream(Stream *_module, Print *_output);
+  // Record in a ring buffer given by the caller (oldest records are dropped when full)
+  SIM808TraceStream(Stream *_module, uint8_t *_ring, uint16_t _ringSize);
+
+  // Pause/resume the recording
+  void setRecording(bool enable);
+  // Write the pending burst as a record
+  void flushTrace();
+  // Write the content of the ring buffer (oldest record first) on the output (nothing without ring buffer)
+  void dumpTrace(Print *output);
+  // Number of records dropped because the ring buffer was full
+  uint16_t getDroppedRecords();
+
+  // Stream interface
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+  void flush();
+
+private:
+  void record(uint8_t type, uint8_t c);
+  void writeRecord(const uint8_t *header, const uint8_t *data, uint8_t size);
+  void ringWrite(uint8_t b);
+
+  Stream *module = NULL;
+  Print *output = NULL;
+
+  // Ring buffer [head = next write, tail = oldest record]
+  uint8_t *ring = NULL;
+  uint16_t ringSize = 0;
+  uint16_t ringHead = 0;
+  uint16_t ringUsed = 0;
+  uint16_t dropped = 0;
+
+  // Current burst
+  bool recording = true;
+  uint8_t burstType = 0;
+  uint32_t burstStart = 0;
+  uint32_t burstLast = 0;
+  uint8_t burstSize = 0;
+  uint8_t burst[SIM808_TRACE_BURST_SIZE];
+};
+
+/**
+ * Stream which plays the module side of a recorded trace, to reproduce a session without the module
+ * The bytes received are given back to the driver once the bytes sent before them in the trace have
+ * been written by the driver, with the same delay as in the recording (or immediately)
+ * Usage: SIM808TraceReplay replay(&traceFile); SIM808Driver sim808(&replay, ...);
+ */
+class SIM808TraceReplay : public Stream
+{
+public:
+  SIM808TraceReplay(Stream *_trace, bool _realTime = true);
+
+  // True when the whole trace was played
+  bool isFinished();
+  // Number of bytes written by the driver which are different from the trace
+  uint32_t getMismatches();
+
+  // Stream interface
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c);
+  void flush();
+
+private:
+  bool loadRecord();
+
+  Stream *trace = NULL;
+  bool realTime = true;
+  bool finished = false;
+  uint32_t mismatches = 0;
+
+  // Current record
+  bool loaded = false;
+  uint8_t recordType = 0;
+  uint32_t recordTime = 0;
+  uint8_t recordLeft = 0;
+  uint32_t previousTime = 0;
+  uint32_t dueTime = 0;
+};
+
+#endif // _SIM808_TRACE_H_